@@ -0,0 +1,254 @@
+// Copyright 2019 Dmitry Valter
+// Copyright 2019 Sviatoslav Dmitriev
+// Distributed under the Boost Software License, Version 1.0.
+// See accompanying file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt
+
+#ifndef INTEGRALRANGE_BENCHBASELINES_H
+#define INTEGRALRANGE_BENCHBASELINES_H
+
+#include <algorithm>
+#include <cstdint>
+#include <iterator>
+#include <set>
+#include <vector>
+
+#include "IntegralRangeVector.h"
+#include "RangeMerger.h"
+
+namespace ranges::bench {
+
+    /*
+     * Set representations compared by the benchmarks. Every representation provides the same static interface:
+     *   name                    - name used in case names
+     *   set_type                - type of a stored set
+     *   cached_length           - true if length() caches its result and has to be measured on a fresh copy
+     *   build(values)           - builds a set from sorted distinct values
+     *   visit(set, f)           - calls f for every member in ascending order
+     *   length(set)             - amount of members
+     *   toVector(set)           - members as a sorted vector
+     *   intersect(sets)         - intersection of all sets
+     *   unite(sets)             - union of all sets
+     */
+
+    //! IntegralRangeVector storing runs of values
+    template<typename T>
+    struct RangeVectorImpl {
+        static constexpr const char *name = "range";
+        static constexpr bool cached_length = true;
+        typedef IntegralRangeVector<T> set_type;
+
+        static set_type build(const std::vector<T> &values) {
+            set_type result;
+            for (auto value : values) {
+                result.push_back(value);
+            }
+            return result;
+        }
+
+        template<typename Func>
+        static void visit(const set_type &set, Func &&func) {
+            for (const auto &range : set) {
+                for (T value = range.first; value < range.second; value++) {
+                    func(value);
+                }
+            }
+        }
+
+        static std::size_t length(const set_type &set) { return set.length(); }
+
+        static std::vector<T> toVector(const set_type &set) { return set.toVector(); }
+
+        static set_type intersect(const std::vector<set_type> &sets) { return intersect_ranges(sets); }
+
+        static set_type unite(const std::vector<set_type> &sets) { return unite_ranges(sets); }
+    };
+
+    //! Balanced tree of values, folding merges pairwise with std::set_intersection and std::set_union
+    template<typename T>
+    struct StdSetImpl {
+        static constexpr const char *name = "set";
+        static constexpr bool cached_length = false;
+        typedef std::set<T> set_type;
+
+        static set_type build(const std::vector<T> &values) {
+            set_type result;
+            for (auto value : values) {
+                result.insert(result.end(), value);
+            }
+            return result;
+        }
+
+        template<typename Func>
+        static void visit(const set_type &set, Func &&func) {
+            for (auto value : set) {
+                func(value);
+            }
+        }
+
+        static std::size_t length(const set_type &set) { return set.size(); }
+
+        static std::vector<T> toVector(const set_type &set) { return {set.begin(), set.end()}; }
+
+        static set_type intersect(const std::vector<set_type> &sets) {
+            if (sets.empty()) {
+                return {};
+            }
+            set_type result = sets[0];
+            for (std::size_t i = 1; i < sets.size(); i++) {
+                set_type next;
+                std::set_intersection(result.begin(), result.end(), sets[i].begin(), sets[i].end(),
+                                      std::inserter(next, next.end()));
+                result.swap(next);
+            }
+            return result;
+        }
+
+        static set_type unite(const std::vector<set_type> &sets) {
+            if (sets.empty()) {
+                return {};
+            }
+            set_type result = sets[0];
+            for (std::size_t i = 1; i < sets.size(); i++) {
+                set_type next;
+                std::set_union(result.begin(), result.end(), sets[i].begin(), sets[i].end(),
+                               std::inserter(next, next.end()));
+                result.swap(next);
+            }
+            return result;
+        }
+    };
+
+    //! Sorted vector of values, folding merges pairwise with std::set_intersection and std::set_union
+    template<typename T>
+    struct SortedVectorImpl {
+        static constexpr const char *name = "sorted";
+        static constexpr bool cached_length = false;
+        typedef std::vector<T> set_type;
+
+        static set_type build(const std::vector<T> &values) {
+            set_type result;
+            for (auto value : values) {
+                result.push_back(value);
+            }
+            return result;
+        }
+
+        template<typename Func>
+        static void visit(const set_type &set, Func &&func) {
+            for (auto value : set) {
+                func(value);
+            }
+        }
+
+        static std::size_t length(const set_type &set) { return set.size(); }
+
+        static std::vector<T> toVector(const set_type &set) { return set; }
+
+        static set_type intersect(const std::vector<set_type> &sets) {
+            if (sets.empty()) {
+                return {};
+            }
+            set_type result = sets[0];
+            set_type next;
+            for (std::size_t i = 1; i < sets.size(); i++) {
+                next.clear();
+                std::set_intersection(result.begin(), result.end(), sets[i].begin(), sets[i].end(),
+                                      std::back_inserter(next));
+                result.swap(next);
+            }
+            return result;
+        }
+
+        static set_type unite(const std::vector<set_type> &sets) {
+            if (sets.empty()) {
+                return {};
+            }
+            set_type result = sets[0];
+            set_type next;
+            for (std::size_t i = 1; i < sets.size(); i++) {
+                next.clear();
+                std::set_union(result.begin(), result.end(), sets[i].begin(), sets[i].end(),
+                               std::back_inserter(next));
+                result.swap(next);
+            }
+            return result;
+        }
+    };
+
+    /**
+     * Uncompressed bitmap covering [0, largest member], stored in 64-bit words so merges are word-parallel.
+     * std::vector<bool> does not expose its words, hence the explicit word vector.
+     */
+    template<typename T>
+    struct BitmapImpl {
+        static constexpr const char *name = "bitmap";
+        static constexpr bool cached_length = false;
+        typedef std::vector<std::uint64_t> set_type;
+
+        static set_type build(const std::vector<T> &values) {
+            set_type result;
+            for (auto value : values) {
+                std::size_t word = std::size_t(value) / 64u;
+                if (word >= result.size()) {
+                    result.resize(word + 1u);
+                }
+                result[word] |= std::uint64_t(1u) << (value % 64u);
+            }
+            return result;
+        }
+
+        template<typename Func>
+        static void visit(const set_type &set, Func &&func) {
+            for (std::size_t i = 0; i < set.size(); i++) {
+                for (auto word = set[i]; word != 0; word &= word - 1u) {
+                    func(T(i * 64u + std::size_t(__builtin_ctzll(word))));
+                }
+            }
+        }
+
+        static std::size_t length(const set_type &set) {
+            std::size_t result = 0u;
+            for (auto word : set) {
+                result += std::size_t(__builtin_popcountll(word));
+            }
+            return result;
+        }
+
+        static std::vector<T> toVector(const set_type &set) {
+            std::vector<T> result;
+            visit(set, [&](T value) { result.push_back(value); });
+            return result;
+        }
+
+        static set_type intersect(const std::vector<set_type> &sets) {
+            if (sets.empty()) {
+                return {};
+            }
+            set_type result = sets[0];
+            for (std::size_t i = 1; i < sets.size(); i++) {
+                result.resize(std::min(result.size(), sets[i].size()));
+                for (std::size_t w = 0; w < result.size(); w++) {
+                    result[w] &= sets[i][w];
+                }
+            }
+            return result;
+        }
+
+        static set_type unite(const std::vector<set_type> &sets) {
+            if (sets.empty()) {
+                return {};
+            }
+            set_type result = sets[0];
+            for (std::size_t i = 1; i < sets.size(); i++) {
+                result.resize(std::max(result.size(), sets[i].size()));
+                for (std::size_t w = 0; w < sets[i].size(); w++) {
+                    result[w] |= sets[i][w];
+                }
+            }
+            return result;
+        }
+    };
+
+}
+
+#endif // INTEGRALRANGE_BENCHBASELINES_H
@@ -0,0 +1,437 @@
+// Copyright 2019 Dmitry Valter
+// Copyright 2019 Sviatoslav Dmitriev
+// Distributed under the Boost Software License, Version 1.0.
+// See accompanying file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt
+
+#ifndef INTEGRALRANGE_BENCHCOMPARE_H
+#define INTEGRALRANGE_BENCHCOMPARE_H
+
+#include <algorithm>
+#include <cassert>
+#include <cctype>
+#include <cmath>
+#include <istream>
+#include <iterator>
+#include <map>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "BenchHarness.h"
+
+namespace ranges::bench {
+
+    /**
+     * Minimal JSON document model, sufficient to read results written by write_json()
+     */
+    struct JsonValue {
+        enum class Kind {
+            Null, Bool, Number, String, Array, Object
+        };
+
+        Kind kind = Kind::Null;
+        bool boolean = false;
+        double number = 0.0;
+        std::string string;
+        std::vector<JsonValue> array;
+        std::vector<std::pair<std::string, JsonValue>> object;
+
+        //! Returns a member of an object or nullptr if there is none
+        const JsonValue *find(const std::string &key) const {
+            for (const auto &member : object) {
+                if (member.first == key) {
+                    return &member.second;
+                }
+            }
+            return nullptr;
+        }
+    };
+
+    //! Recursive descent JSON parser, throws std::runtime_error on malformed input
+    class JsonParser {
+        const std::string &_text;
+        std::size_t _pos = 0u;
+
+        [[noreturn]] void fail(const char *what) const {
+            throw std::runtime_error(std::string("JSON: ") + what + " at offset " + std::to_string(_pos));
+        }
+
+        void skip() {
+            while (_pos < _text.size() && std::isspace(static_cast<unsigned char>(_text[_pos]))) {
+                _pos++;
+            }
+        }
+
+        bool consume(char ch) {
+            skip();
+            if (_pos < _text.size() && _text[_pos] == ch) {
+                _pos++;
+                return true;
+            }
+            return false;
+        }
+
+        void expect(char ch) {
+            if (!consume(ch)) {
+                fail("unexpected character");
+            }
+        }
+
+        std::string parseString() {
+            expect('"');
+            std::string result;
+            while (_pos < _text.size() && _text[_pos] != '"') {
+                char ch = _text[_pos++];
+                if (ch == '\\') {
+                    if (_pos >= _text.size()) {
+                        fail("unterminated escape");
+                    }
+                    ch = _text[_pos++];
+                    switch (ch) {
+                        case 'n':
+                            ch = '\n';
+                            break;
+                        case 't':
+                            ch = '\t';
+                            break;
+                        case 'u':
+                            // Only ASCII escapes are produced by the harness
+                            try {
+                                ch = char(std::stoi(_text.substr(_pos, 4), nullptr, 16));
+                            }
+                            catch (const std::logic_error &) {
+                                fail("invalid escape");
+                            }
+                            _pos += 4;
+                            break;
+                        default:
+                            break;
+                    }
+                }
+                result.push_back(ch);
+            }
+            expect('"');
+            return result;
+        }
+
+        JsonValue parseValue() {
+            skip();
+            if (_pos >= _text.size()) {
+                fail("unexpected end");
+            }
+
+            JsonValue result;
+            char ch = _text[_pos];
+            if (ch == '{') {
+                result.kind = JsonValue::Kind::Object;
+                _pos++;
+                if (!consume('}')) {
+                    do {
+                        skip();
+                        auto key = parseString();
+                        expect(':');
+                        result.object.emplace_back(std::move(key), parseValue());
+                    } while (consume(','));
+                    expect('}');
+                }
+            }
+            else if (ch == '[') {
+                result.kind = JsonValue::Kind::Array;
+                _pos++;
+                if (!consume(']')) {
+                    do {
+                        result.array.push_back(parseValue());
+                    } while (consume(','));
+                    expect(']');
+                }
+            }
+            else if (ch == '"') {
+                result.kind = JsonValue::Kind::String;
+                result.string = parseString();
+            }
+            else if (_text.compare(_pos, 4, "true") == 0 || _text.compare(_pos, 5, "false") == 0) {
+                result.kind = JsonValue::Kind::Bool;
+                result.boolean = ch == 't';
+                _pos += result.boolean ? 4 : 5;
+            }
+            else if (_text.compare(_pos, 4, "null") == 0) {
+                _pos += 4;
+            }
+            else {
+                result.kind = JsonValue::Kind::Number;
+                std::size_t used = 0;
+                try {
+                    result.number = std::stod(_text.substr(_pos, 32), &used);
+                }
+                catch (const std::logic_error &) {
+                    fail("invalid number");
+                }
+                _pos += used;
+            }
+            return result;
+        }
+
+    public:
+        explicit JsonParser(const std::string &text) : _text(text) {}
+
+        //! Parses the whole text as a single value
+        JsonValue parse() {
+            auto result = parseValue();
+            skip();
+            if (_pos != _text.size()) {
+                fail("trailing characters");
+            }
+            return result;
+        }
+    };
+
+    //! Previously recorded benchmark results
+    struct Baseline {
+        //! Samples in nanoseconds per operation, keyed by case name
+        std::map<std::string, std::vector<double>> samples;
+
+        //! Context of the recorded run
+        std::map<std::string, std::string> context;
+    };
+
+    /*!
+     * Reads per-repetition samples of every case from a JSON result
+     * @param in Stream containing a document written by write_json()
+     * @return Recorded samples and context
+     */
+    inline Baseline read_baseline(std::istream &in) {
+        std::string text((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+        auto document = JsonParser(text).parse();
+
+        Baseline result;
+        if (auto context = document.find("context")) {
+            for (const auto &member : context->object) {
+                result.context[member.first] = member.second.string;
+            }
+        }
+
+        auto benchmarks = document.find("benchmarks");
+        if (benchmarks == nullptr) {
+            throw std::runtime_error("JSON: no benchmarks in the document");
+        }
+        for (const auto &entry : benchmarks->array) {
+            auto name = entry.find("name");
+            auto samples = entry.find("samples_ns");
+            if (name == nullptr || samples == nullptr) {
+                continue;
+            }
+            auto &output = result.samples[name->string];
+            for (const auto &sample : samples->array) {
+                output.push_back(sample.number);
+            }
+        }
+        return result;
+    }
+
+    //! Result of comparing two sets of samples
+    struct Comparison {
+        //! Case name
+        std::string name;
+
+        //! Median of the baseline samples, nanoseconds
+        double baseline;
+
+        //! Median of the current samples, nanoseconds
+        double current;
+
+        //! Estimated baseline/current time ratio, values above 1 mean the current build is faster
+        double speedup;
+
+        //! Lower bound of the speedup confidence interval
+        double low;
+
+        //! Upper bound of the speedup confidence interval
+        double high;
+
+        //! Two-sided Mann-Whitney U test p-value
+        double pValue;
+
+        //! "faster", "slower" or "same"
+        std::string verdict;
+    };
+
+    //! Standard normal cumulative distribution function
+    inline double normal_cdf(double x) {
+        return 0.5 * std::erfc(-x / std::sqrt(2.0));
+    }
+
+    /*!
+     * Two-sided Mann-Whitney U test. Uses the exact distribution of U for small samples without ties and the
+     * tie-corrected normal approximation otherwise.
+     * @param a First sample
+     * @param b Second sample
+     * @return p-value of the hypothesis that both samples come from the same distribution
+     */
+    inline double mann_whitney(const std::vector<double> &a, const std::vector<double> &b) {
+        const std::size_t m = a.size();
+        const std::size_t n = b.size();
+        if (m == 0u || n == 0u) {
+            return 1.0;
+        }
+
+        // Ranks of the pooled sample, ties get the mean rank
+        std::vector<std::pair<double, bool>> pooled;
+        for (auto v : a) {
+            pooled.emplace_back(v, true);
+        }
+        for (auto v : b) {
+            pooled.emplace_back(v, false);
+        }
+        std::sort(pooled.begin(), pooled.end());
+
+        double rankSumA = 0.0;
+        double tieCorrection = 0.0;
+        for (std::size_t i = 0; i < pooled.size();) {
+            std::size_t j = i;
+            while (j < pooled.size() && pooled[j].first == pooled[i].first) {
+                j++;
+            }
+            double rank = double(i + j + 1) / 2.0;
+            for (std::size_t k = i; k < j; k++) {
+                if (pooled[k].second) {
+                    rankSumA += rank;
+                }
+            }
+            double t = double(j - i);
+            tieCorrection += t * t * t - t;
+            i = j;
+        }
+
+        double u = rankSumA - double(m * (m + 1)) / 2.0;
+        double mean = double(m * n) / 2.0;
+
+        if (tieCorrection == 0.0 && m + n <= 40u) {
+            // counts[k] is the amount of arrangements with U == k, built by the usual recurrence over sample sizes
+            std::vector<std::vector<double>> prev(n + 1), cur(n + 1);
+            for (std::size_t j = 0; j <= n; j++) {
+                prev[j].assign(1u, 1.0);
+            }
+            for (std::size_t i = 1; i <= m; i++) {
+                cur[0].assign(1u, 1.0);
+                for (std::size_t j = 1; j <= n; j++) {
+                    cur[j].assign(i * j + 1, 0.0);
+                    for (std::size_t k = 0; k < prev[j].size(); k++) {
+                        cur[j][k + j] += prev[j][k];
+                    }
+                    for (std::size_t k = 0; k < cur[j - 1].size(); k++) {
+                        cur[j][k] += cur[j - 1][k];
+                    }
+                }
+                std::swap(prev, cur);
+            }
+
+            const auto &counts = prev[n];
+            double total = 0.0;
+            for (auto c : counts) {
+                total += c;
+            }
+            double tail = 0.0;
+            double extreme = std::min(u, double(m * n) - u);
+            for (std::size_t k = 0; k < counts.size() && double(k) <= extreme; k++) {
+                tail += counts[k];
+            }
+            return std::min(1.0, 2.0 * tail / total);
+        }
+
+        double total = double(m + n);
+        double variance = double(m * n) / 12.0 * ((total + 1.0) - tieCorrection / (total * (total - 1.0)));
+        if (variance <= 0.0) {
+            return 1.0;
+        }
+        double z = (std::abs(u - mean) - 0.5) / std::sqrt(variance);
+        return std::min(1.0, 2.0 * (1.0 - normal_cdf(std::max(0.0, z))));
+    }
+
+    /*!
+     * Compares samples of a case: Hodges-Lehmann estimate of the speedup with a distribution-free confidence
+     * interval derived from the Mann-Whitney statistic, and the Mann-Whitney test of the difference
+     * @param name Case name
+     * @param baseline Baseline samples, not empty
+     * @param current Current samples, not empty
+     * @param threshold Relative change below which a difference is not reported, e.g. 0.05
+     * @param alpha Significance level, the confidence level of the interval is 1 - alpha
+     */
+    inline Comparison compare_samples(const std::string &name, const std::vector<double> &baseline,
+                                      const std::vector<double> &current, double threshold, double alpha = 0.05) {
+        assert(!baseline.empty() && !current.empty());
+
+        auto median = [](std::vector<double> v) {
+            std::sort(v.begin(), v.end());
+            auto mid = v.size() / 2;
+            return v.size() % 2 ? v[mid] : (v[mid - 1] + v[mid]) / 2;
+        };
+
+        // Pairwise log ratios, their median is the Hodges-Lehmann estimate of the log speedup
+        std::vector<double> ratios;
+        for (auto b : baseline) {
+            for (auto c : current) {
+                ratios.push_back(std::log(b / c));
+            }
+        }
+        std::sort(ratios.begin(), ratios.end());
+
+        const double m = double(baseline.size());
+        const double n = double(current.size());
+        // Two-sided normal quantile for alpha, inverted by bisection to avoid a table
+        double lo = 0.0, hi = 10.0;
+        for (int i = 0; i < 100; i++) {
+            double mid = (lo + hi) / 2;
+            (2.0 * (1.0 - normal_cdf(mid)) > alpha ? lo : hi) = mid;
+        }
+        double k = std::floor(m * n / 2.0 - lo * std::sqrt(m * n * (m + n + 1.0) / 12.0));
+        auto index = std::size_t(std::max(0.0, k));
+        index = std::min(index, ratios.size() - 1);
+
+        Comparison result;
+        result.name = name;
+        result.baseline = median(baseline);
+        result.current = median(current);
+        result.speedup = std::exp(median(ratios));
+        result.low = std::exp(ratios[index]);
+        result.high = std::exp(ratios[ratios.size() - 1 - index]);
+        result.pValue = mann_whitney(baseline, current);
+
+        bool significant = result.pValue < alpha;
+        if (significant && result.speedup > 1.0 + threshold) {
+            result.verdict = "faster";
+        }
+        else if (significant && result.speedup < 1.0 / (1.0 + threshold)) {
+            result.verdict = "slower";
+        }
+        else {
+            result.verdict = "same";
+        }
+        return result;
+    }
+
+    //! Writes comparisons as JSON
+    inline void write_comparisons(std::ostream &out, const std::vector<Comparison> &comparisons,
+                                  const std::vector<std::string> &missing, double threshold) {
+        out << "{\n  \"threshold\": " << threshold << ",\n  \"comparisons\": [";
+        for (std::size_t i = 0; i < comparisons.size(); i++) {
+            const auto &c = comparisons[i];
+            out << (i ? ",\n" : "\n") << "    {\"name\": ";
+            write_json_string(out, c.name);
+            out << ", \"baseline_ns\": " << c.baseline << ", \"current_ns\": " << c.current
+                << ", \"speedup\": " << c.speedup << ", \"ci_low\": " << c.low << ", \"ci_high\": " << c.high
+                << ", \"p_value\": " << c.pValue << ", \"verdict\": ";
+            write_json_string(out, c.verdict);
+            out << "}";
+        }
+        out << "\n  ],\n  \"missing\": [";
+        for (std::size_t i = 0; i < missing.size(); i++) {
+            out << (i ? ", " : "");
+            write_json_string(out, missing[i]);
+        }
+        out << "]\n}\n";
+    }
+
+}
+
+#endif // INTEGRALRANGE_BENCHCOMPARE_H
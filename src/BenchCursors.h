@@ -0,0 +1,250 @@
+// Copyright 2019 Dmitry Valter
+// Copyright 2019 Sviatoslav Dmitriev
+// Distributed under the Boost Software License, Version 1.0.
+// See accompanying file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt
+
+#ifndef INTEGRALRANGE_BENCHCURSORS_H
+#define INTEGRALRANGE_BENCHCURSORS_H
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <utility>
+
+#include "IntegralRangeVector.h"
+
+namespace ranges::bench {
+
+    /*
+     * Alternative designs of a cursor decoding the IntegralRangeVector encoding, compared by the decode
+     * benchmarks. Every cursor is constructed from the encoded words and provides:
+     *   name       - name used in case names
+     *   done()     - true once all ranges were visited
+     *   operator*  - current range
+     *   advance()  - moves to the next range
+     *
+     * Branchless designs make the position of the next range depend on the loaded word, so the loop runs at the
+     * latency of a load even when the mask pattern is predictable. Branching designs let the branch predictor
+     * break that dependency and only lose on patterns like "clustered", where singletons and ranges are mixed
+     * randomly. The "iterator" cases measure const_iterator itself in the same loop; "branchy" is the same logic
+     * over raw pointers, which GCC if-converts into a conditional move, showing how fragile that advantage is.
+     */
+
+    //! Decode loop of const_iterator: branches on the end and on the mask bit in both decode and advance
+    template<typename T>
+    class BranchyCursor {
+        static constexpr T mask = IntegralRangeVector<T>::mask;
+        const T *_pos;
+        const T *_end;
+        std::pair<T, T> _value;
+
+        void decode() {
+            if (_pos >= _end) {
+                _value = {T(0u), T(0u)};
+            }
+            else if (mask & *_pos) {
+                _value = {T(*_pos & ~mask), T(*(_pos + 1) & ~mask)};
+            }
+            else {
+                _value = {*_pos, T(*_pos + 1u)};
+            }
+        }
+
+    public:
+        static constexpr const char *name = "branchy";
+
+        BranchyCursor(const T *begin, const T *end) : _pos(begin), _end(end) { decode(); }
+
+        bool done() const { return _pos >= _end; }
+
+        const std::pair<T, T> &operator*() const { return _value; }
+
+        void advance() {
+            if (_pos < _end && mask & *_pos) {
+                ++_pos;
+            }
+            ++_pos;
+            decode();
+        }
+    };
+
+    //! Finds the position of the next range while decoding, so an advance does not depend on a load
+    template<typename T>
+    class LookaheadCursor {
+        static constexpr T mask = IntegralRangeVector<T>::mask;
+        const T *_pos;
+        const T *_next;
+        const T *_end;
+        std::pair<T, T> _value;
+
+        void decode() {
+            if (_pos >= _end) {
+                _value = {T(0u), T(0u)};
+                _next = _pos + 1;
+            }
+            else if (mask & *_pos) {
+                _value = {T(*_pos & ~mask), T(*(_pos + 1) & ~mask)};
+                _next = _pos + 2;
+            }
+            else {
+                _value = {*_pos, T(*_pos + 1u)};
+                _next = _pos + 1;
+            }
+        }
+
+    public:
+        static constexpr const char *name = "lookahead";
+
+        LookaheadCursor(const T *begin, const T *end) : _pos(begin), _end(end) { decode(); }
+
+        bool done() const { return _pos >= _end; }
+
+        const std::pair<T, T> &operator*() const { return _value; }
+
+        void advance() {
+            _pos = _next;
+            decode();
+        }
+    };
+
+    //! Decodes without branching on the mask bit: the end is read from the next word of a range or the same word
+    template<typename T>
+    class BranchlessCursor {
+        static constexpr T mask = IntegralRangeVector<T>::mask;
+        static constexpr unsigned shift = sizeof(T) * 8u - 1u;
+        const T *_pos;
+        const T *_end;
+        std::size_t _step = 1u;
+        std::pair<T, T> _value;
+
+        void decode() {
+            if (_pos >= _end) {
+                _value = {T(0u), T(0u)};
+                _step = 1u;
+                return;
+            }
+            std::size_t isRange = std::size_t(*_pos >> shift);
+            _value = {T(*_pos & ~mask), T(T(_pos[isRange] & ~mask) + T(isRange ^ 1u))};
+            _step = 1u + isRange;
+        }
+
+    public:
+        static constexpr const char *name = "branchless";
+
+        BranchlessCursor(const T *begin, const T *end) : _pos(begin), _end(end) { decode(); }
+
+        bool done() const { return _pos >= _end; }
+
+        const std::pair<T, T> &operator*() const { return _value; }
+
+        void advance() {
+            _pos += _step;
+            decode();
+        }
+    };
+
+    /**
+     * Decodes ranges ahead in blocks into a small buffer, so that the decode loop runs without interleaved
+     * consumer code
+     */
+    template<typename T, std::size_t N = 16u>
+    class BufferedCursor {
+        static constexpr T mask = IntegralRangeVector<T>::mask;
+        static constexpr unsigned shift = sizeof(T) * 8u - 1u;
+        const T *_pos;
+        const T *_end;
+        std::pair<T, T> _buffer[N];
+        std::size_t _index = 0u;
+        std::size_t _size = 0u;
+
+        void refill() {
+            _index = 0u;
+            _size = 0u;
+            while (_size < N && _pos < _end) {
+                std::size_t isRange = std::size_t(*_pos >> shift);
+                _buffer[_size++] = {T(*_pos & ~mask), T(T(_pos[isRange] & ~mask) + T(isRange ^ 1u))};
+                _pos += 1u + isRange;
+            }
+        }
+
+    public:
+        static constexpr const char *name = "buffered";
+
+        BufferedCursor(const T *begin, const T *end) : _pos(begin), _end(end) { refill(); }
+
+        bool done() const { return _index == _size; }
+
+        const std::pair<T, T> &operator*() const { return _buffer[_index]; }
+
+        void advance() {
+            if (++_index == _size) {
+                refill();
+            }
+        }
+    };
+
+    /**
+     * Raw pointer cursor without a bounds check in decode: the range is decoded on dereference and the caller
+     * only compares positions
+     */
+    template<typename T>
+    class UncheckedCursor {
+        static constexpr T mask = IntegralRangeVector<T>::mask;
+        static constexpr unsigned shift = sizeof(T) * 8u - 1u;
+        const T *_pos;
+        const T *_end;
+
+    public:
+        static constexpr const char *name = "unchecked";
+
+        UncheckedCursor(const T *begin, const T *end) : _pos(begin), _end(end) {}
+
+        bool done() const { return _pos >= _end; }
+
+        std::pair<T, T> operator*() const {
+            std::size_t isRange = std::size_t(*_pos >> shift);
+            return {T(*_pos & ~mask), T(T(_pos[isRange] & ~mask) + T(isRange ^ 1u))};
+        }
+
+        void advance() { _pos += 1u + std::size_t(*_pos >> shift); }
+    };
+
+    /**
+     * Decodes blocks of words into arrays of beginnings and endings with decode_block(), the design of the cursors
+     * merges use for IntegralRangeVector
+     */
+    template<typename T, std::size_t N = IntegralRangeVector<T>::DECODE_BLOCK>
+    class BlockCursor {
+        const T *_pos;
+        const T *_end;
+        std::array<T, N> _begins;
+        std::array<T, N> _ends;
+        std::size_t _index = 0u;
+        std::size_t _size = 0u;
+
+        void refill() {
+            auto block = decode_block(_pos, std::min(std::size_t(_end - _pos), N), _begins.data(), _ends.data());
+            _index = 0u;
+            _size = block.ranges;
+            _pos += block.words;
+        }
+
+    public:
+        static constexpr const char *name = "block";
+
+        BlockCursor(const T *begin, const T *end) : _pos(begin), _end(end) { refill(); }
+
+        bool done() const { return _index == _size; }
+
+        std::pair<T, T> operator*() const { return {_begins[_index], _ends[_index]}; }
+
+        void advance() {
+            if (++_index == _size) {
+                refill();
+            }
+        }
+    };
+
+}
+
+#endif // INTEGRALRANGE_BENCHCURSORS_H
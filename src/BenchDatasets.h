@@ -0,0 +1,90 @@
+// Copyright 2019 Dmitry Valter
+// Copyright 2019 Sviatoslav Dmitriev
+// Distributed under the Boost Software License, Version 1.0.
+// See accompanying file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt
+
+#ifndef INTEGRALRANGE_BENCHDATASETS_H
+#define INTEGRALRANGE_BENCHDATASETS_H
+
+#include <functional>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "IntegralRangeVector.h"
+#include "RangeGenerators.h"
+
+namespace ranges::bench {
+
+    /**
+     * Named family of generated benchmark inputs
+     * @tparam Cont Container type of a generated set
+     */
+    template<typename Cont>
+    struct Dataset {
+        //! Name used in case names, e.g. "zipf"
+        std::string name;
+
+        /*!
+         * Generates a family of sets
+         * @param sets Amount of sets in the family
+         * @param ranges Approximate amount of ranges in every set
+         * @param seed Seed of the generator, same seed gives the same family
+         */
+        std::function<std::vector<Cont>(std::size_t sets, std::size_t ranges, std::uint64_t seed)> make;
+    };
+
+    //! Generates every set of a family independently with its own seed
+    template<typename Cont, typename Generator>
+    std::vector<Cont> independent(std::size_t sets, std::uint64_t seed, Generator generator) {
+        std::vector<Cont> result;
+        result.reserve(sets);
+        for (std::size_t i = 0; i < sets; i++) {
+            std::mt19937_64 engine(seed + i);
+            result.push_back(generator(engine, i));
+        }
+        return result;
+    }
+
+    //! Returns the standard dataset families used by the benchmarks
+    template<typename Cont>
+    std::vector<Dataset<Cont>> datasets() {
+        typedef std::mt19937_64 Engine;
+
+        return {
+                {"geometric", [](std::size_t sets, std::size_t ranges, std::uint64_t seed) {
+                    return independent<Cont>(sets, seed, [&](Engine &engine, std::size_t) {
+                        return gen::with_density<Cont>(engine, ranges, 0.5, 8.0);
+                    });
+                }},
+                {"uniform", [](std::size_t sets, std::size_t ranges, std::uint64_t seed) {
+                    return independent<Cont>(sets, seed, [&](Engine &engine, std::size_t) {
+                        return gen::uniform_sparse<Cont>(engine, ranges, 16u * ranges);
+                    });
+                }},
+                {"clustered", [](std::size_t sets, std::size_t ranges, std::uint64_t seed) {
+                    return independent<Cont>(sets, seed, [&](Engine &engine, std::size_t) {
+                        return gen::clustered<Cont>(engine, std::max<std::size_t>(1u, ranges / 64u), 256u, 0.5,
+                                                    4096.0);
+                    });
+                }},
+                {"zipf", [](std::size_t sets, std::size_t ranges, std::uint64_t seed) {
+                    return independent<Cont>(sets, seed, [&](Engine &engine, std::size_t) {
+                        return gen::zipf_runs<Cont>(engine, ranges, 1.2, 4096u, 1.2, 4096u);
+                    });
+                }},
+                {"alternating", [](std::size_t sets, std::size_t ranges, std::uint64_t seed) {
+                    return independent<Cont>(sets, seed, [&](Engine &, std::size_t i) {
+                        return gen::alternating<Cont>(ranges, i % 3u);
+                    });
+                }},
+                {"correlated", [](std::size_t sets, std::size_t ranges, std::uint64_t seed) {
+                    Engine engine(seed);
+                    return gen::correlated_family<Cont>(engine, sets, ranges, 8.0, 8.0, 0.7);
+                }},
+        };
+    }
+
+}
+
+#endif // INTEGRALRANGE_BENCHDATASETS_H
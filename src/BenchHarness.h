@@ -0,0 +1,428 @@
+// Copyright 2019 Dmitry Valter
+// Copyright 2019 Sviatoslav Dmitriev
+// Distributed under the Boost Software License, Version 1.0.
+// See accompanying file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt
+
+#ifndef INTEGRALRANGE_BENCHHARNESS_H
+#define INTEGRALRANGE_BENCHHARNESS_H
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <ostream>
+#include <regex>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "PerfCounters.h"
+#include "RangeTrace.h"
+
+namespace ranges::bench {
+
+    //! Prevents the compiler from optimizing away a computed value
+    template<typename Tp>
+    inline void do_not_optimize(const Tp &value) {
+        asm volatile("" : : "r,m"(value) : "memory");
+    }
+
+    //! Prevents the compiler from caching memory contents across the barrier
+    inline void clobber_memory() {
+        asm volatile("" : : : "memory");
+    }
+
+    //! Clock used by the harness
+    typedef std::chrono::steady_clock clock;
+
+    //! Heap usage of a thread, maintained by the allocation hooks of the benchmark executable
+    struct AllocationCounters {
+        //! Amount of allocations
+        std::uint64_t allocations = 0u;
+
+        //! Total amount of allocated bytes
+        std::uint64_t allocatedBytes = 0u;
+
+        //! Amount of currently allocated bytes, negative if memory allocated by another thread is freed
+        std::int64_t liveBytes = 0;
+    };
+
+    //! Returns allocation counters of the calling thread
+    inline AllocationCounters &allocation_counters() {
+        static thread_local AllocationCounters counters;
+        return counters;
+    }
+
+    /**
+     * Measurement state passed to a benchmark body. The body iterates over the state with a range-based
+     * for loop, only that loop is timed.
+     */
+    class State {
+    public:
+        //! Value produced by the measured loop, marked unused to keep "for (auto _ : state)" warning-free
+        struct __attribute__((unused)) Value {};
+
+        //! Iterator driving the measured loop
+        class iterator {
+            State *_state;
+            std::size_t _left;
+
+        public:
+            iterator(State *state, std::size_t left) : _state(state), _left(left) {}
+
+            //! Stops the timer once the loop is exhausted
+            bool operator!=(const iterator &) {
+                if (_left != 0) {
+                    return true;
+                }
+                _state->stop();
+                return false;
+            }
+
+            iterator &operator++() {
+                --_left;
+                return *this;
+            }
+
+            Value operator*() const { return {}; }
+        };
+
+    private:
+        std::size_t _iterations;
+        std::size_t _items = 0u;
+        clock::time_point _start;
+        clock::duration _elapsed{};
+        std::uint64_t _startAllocations = 0u;
+        std::uint64_t _allocations = 0u;
+        std::map<std::string, double> _counters;
+        const PerfCounters *_perf;
+        std::vector<PerfReading> _perfStart;
+        std::vector<PerfReading> _perfStop;
+        std::vector<PerfReading> _perfTotals;
+
+        // Counters are read outside of the timed interval so that the syscalls do not inflate timings. Part of a
+        // read is still counted by the counters themselves, which is noticeable for bodies pausing every iteration
+        void start() {
+            _startAllocations = allocation_counters().allocations;
+            if (_perf != nullptr) {
+                _perf->read(_perfStart);
+            }
+            _start = clock::now();
+        }
+
+        void stop() {
+            _elapsed += clock::now() - _start;
+            if (_perf != nullptr) {
+                _perf->read(_perfStop);
+                _perfTotals.resize(_perfStop.size());
+                for (std::size_t i = 0; i < _perfStop.size(); i++) {
+                    _perfTotals[i].add(_perfStart[i], _perfStop[i]);
+                }
+            }
+            _allocations += allocation_counters().allocations - _startAllocations;
+        }
+
+    public:
+        /*!
+         * @param iterations Amount of iterations of the measured loop
+         * @param perf Hardware counters read around the measured loop, nullptr disables them
+         */
+        explicit State(std::size_t iterations, const PerfCounters *perf = nullptr)
+                : _iterations(iterations), _perf(perf) {}
+
+        //! Starts the measured loop
+        iterator begin() {
+            start();
+            return {this, _iterations};
+        }
+
+        //! Returns the end of the measured loop
+        iterator end() { return {this, 0u}; }
+
+        //! Amount of iterations the measured loop performs
+        std::size_t iterations() const { return _iterations; }
+
+        //! Excludes the following code from the measurement until resumeTiming() is called
+        void pauseTiming() { stop(); }
+
+        //! Resumes measurement after pauseTiming()
+        void resumeTiming() { start(); }
+
+        //! Sets the amount of input items processed by a single iteration
+        void setItemsPerIteration(std::size_t items) { _items = items; }
+
+        //! Sets a custom counter reported together with timings
+        void counter(const std::string &name, double value) { _counters[name] = value; }
+
+        //! Amount of input items processed by a single iteration
+        std::size_t itemsPerIteration() const { return _items; }
+
+        //! Time spent inside the measured loop
+        clock::duration elapsed() const { return _elapsed; }
+
+        //! Custom counters set by the body
+        const std::map<std::string, double> &counters() const { return _counters; }
+
+        //! Heap allocations performed inside the measured loop
+        std::uint64_t allocations() const { return _allocations; }
+
+        //! Hardware counters accumulated inside the measured loop, in the order of PerfCounters::names()
+        const std::vector<PerfReading> &perf() const { return _perfTotals; }
+    };
+
+    //! Benchmark body type
+    typedef std::function<void(State &)> Body;
+
+    //! Single registered benchmark case
+    struct Case {
+        //! Operation family, e.g. "unite_ranges"
+        std::string family;
+
+        //! Ordered list of parameters identifying the case
+        std::vector<std::pair<std::string, std::string>> params;
+
+        //! Code to measure
+        Body body;
+
+        //! Full case name: family followed by "/key:value" parameters
+        std::string name() const {
+            std::string result = family;
+            for (const auto &param : params) {
+                result += "/" + param.first + ":" + param.second;
+            }
+            return result;
+        }
+    };
+
+    //! Measurement of a single case
+    struct CaseResult {
+        //! Case that was measured
+        const Case *source;
+
+        //! Iterations per repetition
+        std::size_t iterations;
+
+        //! Time per iteration of every repetition, in nanoseconds
+        std::vector<double> samples;
+
+        //! Input items processed by a single iteration
+        std::size_t items;
+
+        //! Custom counters of the last repetition
+        std::map<std::string, double> counters;
+
+        //! Heap allocations per iteration
+        double allocations;
+
+        //! Hardware counters per iteration over all repetitions, empty if counters are not available
+        std::map<std::string, double> perf;
+
+        //! Median time per iteration in nanoseconds
+        double median() const {
+            auto sorted = samples;
+            std::sort(sorted.begin(), sorted.end());
+            auto mid = sorted.size() / 2;
+            return sorted.size() % 2 ? sorted[mid] : (sorted[mid - 1] + sorted[mid]) / 2;
+        }
+
+        //! Fastest time per iteration in nanoseconds
+        double min() const { return *std::min_element(samples.begin(), samples.end()); }
+    };
+
+    //! Harness settings
+    struct Options {
+        //! Minimum time per repetition in seconds
+        double minTime = 0.05;
+
+        //! Amount of measured repetitions of every case
+        std::size_t repetitions = 5u;
+
+        //! Regular expression selecting cases by name
+        std::string filter = ".*";
+
+        //! Hardware counters read during measured repetitions, nullptr disables them
+        const PerfCounters *perf = nullptr;
+    };
+
+    //! Collection of benchmark cases
+    class Registry {
+        std::vector<Case> _cases;
+
+    public:
+        //! Registers a benchmark case
+        void add(std::string family, std::vector<std::pair<std::string, std::string>> params, Body body) {
+            _cases.push_back({std::move(family), std::move(params), std::move(body)});
+        }
+
+        //! Returns all registered cases
+        const std::vector<Case> &cases() const { return _cases; }
+
+        //! Returns cases whose name matches the filter
+        std::vector<const Case *> select(const std::string &filter) const {
+            std::regex re(filter);
+            std::vector<const Case *> result;
+            for (const auto &c : _cases) {
+                if (std::regex_search(c.name(), re)) {
+                    result.push_back(&c);
+                }
+            }
+            return result;
+        }
+    };
+
+    /*!
+     * Measures a case: finds an iteration count that runs for at least minTime and repeats the measurement
+     * @param c Case to measure
+     * @param options Harness settings
+     * @return Per-repetition timings
+     */
+    inline CaseResult measure(const Case &c, const Options &options) {
+        TraceSpan caseSpan(TraceSession::instance().enabled() ? trace_intern(c.name()) : "case");
+        const auto minTime = std::chrono::duration<double>(options.minTime);
+        std::size_t iterations = 1u;
+
+        for (;;) {
+            TraceSpan span("calibrate", "iterations", iterations);
+            State state(iterations);
+            auto wallStart = clock::now();
+            c.body(state);
+            // Untimed setup and paused sections also bound the calibration, otherwise bodies that pause timing
+            // for most of an iteration would grow the iteration count without limit
+            if (state.elapsed() >= minTime || clock::now() - wallStart >= 20 * minTime ||
+                iterations >= (std::size_t(1u) << 30u)) {
+                break;
+            }
+            double elapsed = std::chrono::duration<double>(state.elapsed()).count();
+            double factor = elapsed > 0 ? 1.4 * options.minTime / elapsed : 10.0;
+            iterations = std::max(iterations + 1, std::size_t(double(iterations) * std::min(factor, 10.0)));
+        }
+
+        CaseResult result{&c, iterations, {}, 0u, {}, 0.0, {}};
+        std::vector<PerfReading> perf;
+        for (std::size_t rep = 0; rep < options.repetitions; rep++) {
+            TraceSpan span("repetition", "iterations", iterations);
+            State state(iterations, options.perf);
+            c.body(state);
+            perf.resize(state.perf().size());
+            for (std::size_t i = 0; i < perf.size(); i++) {
+                perf[i].add(PerfReading{}, state.perf()[i]);
+            }
+            result.samples.push_back(std::chrono::duration<double, std::nano>(state.elapsed()).count() /
+                                     double(iterations));
+            result.items = state.itemsPerIteration();
+            result.counters = state.counters();
+            result.allocations = double(state.allocations()) / double(iterations);
+        }
+
+        double totalIterations = double(iterations) * double(options.repetitions);
+        for (std::size_t i = 0; i < perf.size(); i++) {
+            result.perf[options.perf->names()[i]] = perf[i].scaled() / totalIterations;
+        }
+        return result;
+    }
+
+    //! Writes a string as a JSON literal, escaping quotes, backslashes and control characters
+    inline void write_json_string(std::ostream &out, const std::string &str) {
+        out << '"';
+        for (char ch : str) {
+            switch (ch) {
+                case '"':
+                    out << "\\\"";
+                    break;
+                case '\\':
+                    out << "\\\\";
+                    break;
+                case '\n':
+                    out << "\\n";
+                    break;
+                default:
+                    if (static_cast<unsigned char>(ch) < 0x20) {
+                        const char *hex = "0123456789abcdef";
+                        out << "\\u00" << hex[(ch >> 4) & 0xf] << hex[ch & 0xf];
+                    } else {
+                        out << ch;
+                    }
+            }
+        }
+        out << '"';
+    }
+
+    //! Writes hardware counters divided by a scale as a JSON object field
+    inline void write_perf(std::ostream &out, const char *field, const std::map<std::string, double> &perf,
+                           double scale) {
+        out << ", \"" << field << "\": {";
+        std::size_t i = 0;
+        for (const auto &counter : perf) {
+            out << (i++ ? ", " : "");
+            write_json_string(out, counter.first);
+            out << ": " << counter.second / scale;
+        }
+        out << "}";
+    }
+
+    /*!
+     * Writes benchmark results as JSON
+     * @param out Stream to write to
+     * @param context Free-form key-value description of the run
+     * @param results Measured cases
+     */
+    inline void write_json(std::ostream &out, const std::vector<std::pair<std::string, std::string>> &context,
+                           const std::vector<CaseResult> &results) {
+        out << "{\n  \"context\": {";
+        for (std::size_t i = 0; i < context.size(); i++) {
+            out << (i ? ", " : "");
+            write_json_string(out, context[i].first);
+            out << ": ";
+            write_json_string(out, context[i].second);
+        }
+        out << "},\n  \"benchmarks\": [";
+
+        for (std::size_t i = 0; i < results.size(); i++) {
+            const auto &r = results[i];
+            out << (i ? ",\n" : "\n") << "    {\"name\": ";
+            write_json_string(out, r.source->name());
+            out << ", \"family\": ";
+            write_json_string(out, r.source->family);
+            out << ", \"params\": {";
+            for (std::size_t p = 0; p < r.source->params.size(); p++) {
+                out << (p ? ", " : "");
+                write_json_string(out, r.source->params[p].first);
+                out << ": ";
+                write_json_string(out, r.source->params[p].second);
+            }
+            out << "}, \"iterations\": " << r.iterations << ", \"items_per_iteration\": " << r.items;
+            out << ", \"ns_per_op\": " << r.median() << ", \"ns_per_op_min\": " << r.min();
+            out << ", \"allocs_per_op\": " << r.allocations;
+            if (r.items) {
+                out << ", \"ns_per_item\": " << r.median() / double(r.items);
+            }
+            out << ", \"samples_ns\": [";
+            for (std::size_t s = 0; s < r.samples.size(); s++) {
+                out << (s ? ", " : "") << r.samples[s];
+            }
+            out << "], \"counters\": {";
+            std::size_t c = 0;
+            for (const auto &counter : r.counters) {
+                out << (c++ ? ", " : "");
+                write_json_string(out, counter.first);
+                out << ": " << counter.second;
+            }
+            out << "}";
+            if (!r.perf.empty()) {
+                write_perf(out, "perf_per_op", r.perf, 1.0);
+                if (r.items) {
+                    write_perf(out, "perf_per_item", r.perf, double(r.items));
+                }
+                if (r.perf.count("cycles") && r.perf.count("instructions") && r.perf.at("cycles") > 0) {
+                    out << ", \"ipc\": " << r.perf.at("instructions") / r.perf.at("cycles");
+                }
+            }
+            out << "}";
+        }
+        out << "\n  ]\n}\n";
+    }
+
+}
+
+#endif // INTEGRALRANGE_BENCHHARNESS_H
@@ -0,0 +1,225 @@
+// Copyright 2019 Dmitry Valter
+// Copyright 2019 Sviatoslav Dmitriev
+// Distributed under the Boost Software License, Version 1.0.
+// See accompanying file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt
+
+#ifndef INTEGRALRANGE_BENCHINDEX_H
+#define INTEGRALRANGE_BENCHINDEX_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <ostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "BenchHarness.h"
+#include "BenchLatency.h"
+#include "IntegralRangeVector.h"
+#include "RangeGenerators.h"
+#include "RangeMerger.h"
+
+namespace ranges::bench {
+
+    //! Posting list of a term: identifiers of documents containing it
+    typedef IntegralRangeVector<std::uint32_t> Postings;
+
+    //! Parameters of a synthetic corpus
+    struct CorpusShape {
+        //! Amount of documents
+        std::size_t documents = 1000000u;
+
+        //! Amount of terms
+        std::size_t terms = 10000u;
+
+        //! Fraction of documents containing the most frequent term
+        double topFrequency = 0.3;
+
+        //! Zipf exponent of document frequencies, the term of rank r is in topFrequency / r^s of documents
+        double exponent = 1.0;
+    };
+
+    /*!
+     * Builds posting lists of a synthetic corpus. Document frequencies follow Zipf's law. Frequent terms come
+     * in longer runs of consecutive documents, like terms of a corpus sorted by site or date, rare terms are
+     * scattered. Every list starts at a random document so that lists are not aligned.
+     * @param engine Random number engine
+     * @param shape Corpus parameters
+     * @return Posting lists ordered by decreasing document frequency
+     */
+    template<typename Engine>
+    std::vector<Postings> make_corpus(Engine &engine, const CorpusShape &shape) {
+        std::vector<Postings> result;
+        result.reserve(shape.terms);
+        for (std::size_t rank = 1; rank <= shape.terms; rank++) {
+            double density = shape.topFrequency / std::pow(double(rank), shape.exponent);
+            double frequency = std::max(1.0, density * double(shape.documents));
+            double meanRun = 1.0 + 32.0 * density;
+            double meanGap = std::max(1.0, meanRun * (1.0 - density) / density);
+            auto ranges = std::size_t(std::max(1.0, frequency / meanRun));
+
+            std::uniform_int_distribution<std::uint64_t> start(0u, std::uint64_t(meanGap));
+            auto shifted = [](double mean) {
+                return [dist = std::geometric_distribution<std::uint64_t>(1.0 / mean)](Engine &e) mutable {
+                    return dist(e) + 1u;
+                };
+            };
+            result.push_back(gen::runs<Postings>(engine, ranges, shifted(meanRun), shifted(meanGap),
+                                                 start(engine)));
+        }
+        return result;
+    }
+
+    //! Boolean query over posting lists
+    struct Query {
+        //! Kind of the query: "and", "or" or "and_not"
+        std::string kind;
+
+        //! Terms that are intersected or united
+        std::vector<std::size_t> terms;
+
+        //! Terms excluded from the result of an "and_not" query
+        std::vector<std::size_t> excluded;
+
+        //! Index of the requested result page
+        std::size_t page = 0u;
+    };
+
+    //! Result of a query: the total amount of matches and the requested page
+    struct QueryResult {
+        std::uint64_t matches = 0u;
+        std::vector<std::uint32_t> page;
+    };
+
+    /*!
+     * Generates a query mix. Terms are drawn by a Zipf distribution over their ranks, so frequent terms are
+     * also queried often, and requested pages follow a geometric distribution.
+     * @param engine Random number engine
+     * @param terms Amount of terms of the corpus
+     * @param count Amount of queries
+     * @return Generated queries, 40% "and", 30% "or" and 30% "and_not"
+     */
+    template<typename Engine>
+    std::vector<Query> make_queries(Engine &engine, std::size_t terms, std::size_t count) {
+        gen::zipf_distribution<std::size_t> term(terms, 0.8);
+        std::uniform_int_distribution<std::size_t> arity(2u, 4u);
+        std::geometric_distribution<std::size_t> page(0.6);
+        std::discrete_distribution<int> kind({40.0, 30.0, 30.0});
+
+        std::vector<Query> result;
+        result.reserve(count);
+        for (std::size_t i = 0; i < count; i++) {
+            Query query;
+            int k = kind(engine);
+            query.kind = k == 0 ? "and" : k == 1 ? "or" : "and_not";
+            std::size_t size = k == 2 ? 2u : arity(engine);
+            while (query.terms.size() < size) {
+                query.terms.push_back(term(engine) - 1u);
+            }
+            if (k == 2) {
+                query.excluded.push_back(term(engine) - 1u);
+            }
+            query.page = std::min<std::size_t>(page(engine), 9u);
+            result.push_back(std::move(query));
+        }
+        return result;
+    }
+
+    /*!
+     * Evaluates a query through the public merge functions and collects its page of results
+     * @param corpus Posting lists
+     * @param query Evaluated query
+     * @param pageSize Amount of documents on a page
+     * @return Amount of matches and the requested page
+     */
+    inline QueryResult run_query(const std::vector<Postings> &corpus, const Query &query, std::size_t pageSize) {
+        std::vector<Postings> operands;
+        operands.reserve(query.terms.size());
+        for (auto term : query.terms) {
+            operands.push_back(corpus[term]);
+        }
+
+        Postings matches;
+        if (query.kind == "or") {
+            matches = unite_ranges(std::move(operands));
+        }
+        else {
+            matches = intersect_ranges(operands);
+            if (query.kind == "and_not") {
+                std::vector<Postings> difference{std::move(matches)};
+                for (auto term : query.excluded) {
+                    difference.push_back(corpus[term]);
+                }
+                matches = subtract_ranges(difference);
+            }
+        }
+
+        // Pages are cut from the ranges without expanding the values before the requested page
+        QueryResult result;
+        result.matches = matches.length();
+        std::uint64_t skip = std::uint64_t(query.page) * pageSize;
+        for (const auto &range : matches) {
+            std::uint64_t size = std::uint64_t(range.second - range.first);
+            if (skip >= size) {
+                skip -= size;
+                continue;
+            }
+            for (auto value = std::uint64_t(range.first) + skip; value < range.second; value++) {
+                if (result.page.size() == pageSize) {
+                    return result;
+                }
+                result.page.push_back(std::uint32_t(value));
+            }
+            skip = 0u;
+        }
+        return result;
+    }
+
+    //! Measurements of a kind of queries
+    struct IndexResult {
+        std::string kind;
+
+        //! Mean amount of matching documents
+        double meanMatches = 0.0;
+
+        //! Latencies of queries in nanoseconds
+        LatencyHistogram latency;
+    };
+
+    /*!
+     * Writes macro-benchmark results as JSON
+     * @param out Stream to write to
+     * @param context Free-form key-value description of the run
+     * @param seconds Wall time of the whole query mix
+     * @param results Measurements by kind of queries, the first one covering all queries
+     */
+    inline void write_index_json(std::ostream &out, const std::vector<std::pair<std::string, std::string>> &context,
+                                 double seconds, const std::vector<IndexResult> &results) {
+        out << "{\n  \"context\": {";
+        for (std::size_t i = 0; i < context.size(); i++) {
+            out << (i ? ", " : "");
+            write_json_string(out, context[i].first);
+            out << ": ";
+            write_json_string(out, context[i].second);
+        }
+        std::uint64_t queries = results.empty() ? 0u : results[0].latency.count();
+        out << "},\n  \"seconds\": " << seconds << ", \"qps\": " << double(queries) / std::max(seconds, 1e-9)
+            << ",\n  \"queries\": [";
+        for (std::size_t i = 0; i < results.size(); i++) {
+            const auto &r = results[i];
+            out << (i ? ",\n" : "\n") << "    {\"kind\": ";
+            write_json_string(out, r.kind);
+            out << ", \"count\": " << r.latency.count() << ", \"mean_matches\": " << r.meanMatches
+                << ", \"mean_ns\": " << r.latency.mean();
+            for (const auto &p : latency_percentiles()) {
+                out << ", \"" << p.first << "_ns\": " << r.latency.percentile(p.second);
+            }
+            out << ", \"max_ns\": " << r.latency.max() << "}";
+        }
+        out << "\n  ]\n}\n";
+    }
+
+}
+
+#endif // INTEGRALRANGE_BENCHINDEX_H
@@ -0,0 +1,235 @@
+// Copyright 2019 Dmitry Valter
+// Copyright 2019 Sviatoslav Dmitriev
+// Distributed under the Boost Software License, Version 1.0.
+// See accompanying file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt
+
+#ifndef INTEGRALRANGE_BENCHLATENCY_H
+#define INTEGRALRANGE_BENCHLATENCY_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "BenchHarness.h"
+#include "BenchMemory.h"
+
+namespace ranges::bench {
+
+    /**
+     * Histogram of latencies with logarithmic buckets in the style of HdrHistogram. Values below 128 are counted
+     * exactly, every larger power of two is split into 64 linear sub-buckets, so a reported value is at most 1/64
+     * above the recorded one and the histogram covers the whole 64-bit range in a fixed amount of buckets.
+     */
+    class LatencyHistogram {
+    public:
+        //! Bits of a value kept exactly by its bucket
+        static constexpr unsigned SUB_BITS = 7u;
+
+        //! Amount of sub-buckets of a power of two above 2^SUB_BITS
+        static constexpr std::size_t HALF = std::size_t(1u) << (SUB_BITS - 1u);
+
+        //! Amount of buckets
+        static constexpr std::size_t BUCKETS = (std::size_t(1u) << SUB_BITS) + (64u - SUB_BITS) * HALF;
+
+    private:
+        std::vector<std::uint64_t> _counts = std::vector<std::uint64_t>(BUCKETS);
+        std::uint64_t _total = 0u;
+        std::uint64_t _min = std::numeric_limits<std::uint64_t>::max();
+        std::uint64_t _max = 0u;
+        double _sum = 0.0;
+
+    public:
+        //! Returns the bucket of a value
+        static std::size_t index(std::uint64_t value) {
+            if (value < (std::uint64_t(1u) << SUB_BITS)) {
+                return std::size_t(value);
+            }
+            unsigned shift = unsigned(63 - __builtin_clzll(value)) - (SUB_BITS - 1u);
+            return (std::size_t(1u) << SUB_BITS) + (shift - 1u) * HALF + std::size_t((value >> shift) - HALF);
+        }
+
+        //! Returns the lowest value counted by a bucket
+        static std::uint64_t lowest(std::size_t bucket) {
+            if (bucket < (std::size_t(1u) << SUB_BITS)) {
+                return bucket;
+            }
+            std::size_t offset = bucket - (std::size_t(1u) << SUB_BITS);
+            return std::uint64_t(offset % HALF + HALF) << (offset / HALF + 1u);
+        }
+
+        //! Returns the highest value counted by a bucket
+        static std::uint64_t highest(std::size_t bucket) {
+            if (bucket < (std::size_t(1u) << SUB_BITS)) {
+                return bucket;
+            }
+            std::size_t offset = bucket - (std::size_t(1u) << SUB_BITS);
+            return lowest(bucket) + (std::uint64_t(1u) << (offset / HALF + 1u)) - 1u;
+        }
+
+        //! Counts a value
+        void record(std::uint64_t value) {
+            _counts[index(value)]++;
+            _total++;
+            _min = std::min(_min, value);
+            _max = std::max(_max, value);
+            _sum += double(value);
+        }
+
+        //! Adds counts of another histogram
+        LatencyHistogram &operator+=(const LatencyHistogram &other) {
+            for (std::size_t i = 0; i < BUCKETS; i++) {
+                _counts[i] += other._counts[i];
+            }
+            _total += other._total;
+            _min = std::min(_min, other._min);
+            _max = std::max(_max, other._max);
+            _sum += other._sum;
+            return *this;
+        }
+
+        //! Amount of counted values
+        std::uint64_t count() const { return _total; }
+
+        //! Smallest counted value, 0 if the histogram is empty
+        std::uint64_t min() const { return _total ? _min : 0u; }
+
+        //! Largest counted value
+        std::uint64_t max() const { return _max; }
+
+        //! Mean of counted values
+        double mean() const { return _total ? _sum / double(_total) : 0.0; }
+
+        /*!
+         * Returns the highest value of the bucket holding a percentile, never more than the largest counted value
+         * @param fraction Percentile in [0, 1], e.g. 0.99 for p99
+         * @return Value of the percentile, 0 if the histogram is empty
+         */
+        std::uint64_t percentile(double fraction) const {
+            if (_total == 0u) {
+                return 0u;
+            }
+            auto rank = std::max<std::uint64_t>(1u, std::uint64_t(std::ceil(fraction * double(_total))));
+            std::uint64_t seen = 0u;
+            for (std::size_t i = 0; i < BUCKETS; i++) {
+                seen += _counts[i];
+                if (seen >= rank) {
+                    return std::min(highest(i), _max);
+                }
+            }
+            return _max;
+        }
+
+        //! Calls a function with the lowest value and the count of every non-empty bucket
+        template<typename Func>
+        void visit(Func &&func) const {
+            for (std::size_t i = 0; i < BUCKETS; i++) {
+                if (_counts[i]) {
+                    func(lowest(i), _counts[i]);
+                }
+            }
+        }
+    };
+
+    //! Latencies of an operation issued under some condition
+    struct LatencyResult {
+        //! Name of the operation, e.g. "contains"
+        std::string operation;
+
+        //! Name of the condition, e.g. "cold"
+        std::string condition;
+
+        //! Mean time between scheduled arrivals in nanoseconds
+        double meanGapNs = 0.0;
+
+        //! Allocations made by operations
+        std::uint64_t allocations = 0u;
+
+        //! Time from the start to the end of an operation
+        LatencyHistogram service;
+
+        //! Time from the scheduled arrival to the end of an operation, including waiting for earlier operations
+        LatencyHistogram response;
+    };
+
+    //! Percentiles reported for every histogram
+    inline const std::vector<std::pair<std::string, double>> &latency_percentiles() {
+        static const std::vector<std::pair<std::string, double>> result{
+                {"p50", 0.5}, {"p90", 0.9}, {"p99", 0.99}, {"p99.9", 0.999},
+        };
+        return result;
+    }
+
+    /*!
+     * Writes latencies as a Markdown table
+     * @param out Stream to write to
+     * @param results Measured latencies
+     */
+    inline void write_latency_table(std::ostream &out, const std::vector<LatencyResult> &results) {
+        out << "| operation | condition | ops | allocs/op | p50 ns | p90 ns | p99 ns | p99.9 ns | max ns"
+               " | response p99 ns | response p99.9 ns | response max ns |\n"
+               "|---|---|--:|--:|--:|--:|--:|--:|--:|--:|--:|--:|\n";
+        for (const auto &r : results) {
+            double ops = r.service.count() ? double(r.service.count()) : 1.0;
+            out << "| " << r.operation << " | " << r.condition << " | " << r.service.count() << " | "
+                << format_fixed(double(r.allocations) / ops, 2);
+            for (const auto &p : latency_percentiles()) {
+                out << " | " << r.service.percentile(p.second);
+            }
+            out << " | " << r.service.max() << " | " << r.response.percentile(0.99) << " | "
+                << r.response.percentile(0.999) << " | " << r.response.max() << " |\n";
+        }
+    }
+
+    /*!
+     * Writes latencies as JSON, including the non-empty buckets of every histogram
+     * @param out Stream to write to
+     * @param context Free-form key-value description of the run
+     * @param results Measured latencies
+     */
+    inline void write_latency_json(std::ostream &out, const std::vector<std::pair<std::string, std::string>> &context,
+                                   const std::vector<LatencyResult> &results) {
+        auto write_histogram = [&](const char *name, const LatencyHistogram &histogram) {
+            out << "\"" << name << "\": {\"count\": " << histogram.count() << ", \"min\": " << histogram.min()
+                << ", \"mean\": " << histogram.mean();
+            for (const auto &p : latency_percentiles()) {
+                out << ", \"" << p.first << "\": " << histogram.percentile(p.second);
+            }
+            out << ", \"max\": " << histogram.max() << ", \"buckets\": [";
+            bool first = true;
+            histogram.visit([&](std::uint64_t value, std::uint64_t count) {
+                out << (first ? "" : ", ") << "[" << value << ", " << count << "]";
+                first = false;
+            });
+            out << "]}";
+        };
+
+        out << "{\n  \"context\": {";
+        for (std::size_t i = 0; i < context.size(); i++) {
+            out << (i ? ", " : "");
+            write_json_string(out, context[i].first);
+            out << ": ";
+            write_json_string(out, context[i].second);
+        }
+        out << "},\n  \"latencies\": [";
+        for (std::size_t i = 0; i < results.size(); i++) {
+            const auto &r = results[i];
+            out << (i ? ",\n" : "\n") << "    {\"operation\": ";
+            write_json_string(out, r.operation);
+            out << ", \"condition\": ";
+            write_json_string(out, r.condition);
+            out << ", \"mean_gap_ns\": " << r.meanGapNs << ", \"allocations\": " << r.allocations << ",\n     ";
+            write_histogram("service_ns", r.service);
+            out << ",\n     ";
+            write_histogram("response_ns", r.response);
+            out << "}";
+        }
+        out << "\n  ]\n}\n";
+    }
+
+}
+
+#endif // INTEGRALRANGE_BENCHLATENCY_H
@@ -0,0 +1,157 @@
+// Copyright 2019 Dmitry Valter
+// Copyright 2019 Sviatoslav Dmitriev
+// Distributed under the Boost Software License, Version 1.0.
+// See accompanying file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt
+
+#ifndef INTEGRALRANGE_BENCHMEMORY_H
+#define INTEGRALRANGE_BENCHMEMORY_H
+
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#ifdef __linux__
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+namespace ranges::bench {
+
+    //! Memory footprint of a set built in some representation
+    struct Footprint {
+        //! False if the representation cannot hold the dataset, e.g. values exceed its width
+        bool supported = false;
+
+        //! Amount of members
+        std::uint64_t members = 0u;
+
+        //! Amount of maximal runs of consecutive members
+        std::uint64_t ranges = 0u;
+
+        //! Heap bytes owned by the built set
+        std::uint64_t heapBytes = 0u;
+
+        //! Fastest build time in nanoseconds
+        double buildNs = 0.0;
+
+        //! Growth of the resident set during the first build in bytes, negative if not measurable
+        std::int64_t peakRssBytes = -1;
+    };
+
+    //! Row of the footprint table
+    struct FootprintRow {
+        std::string dist;
+        std::string impl;
+        std::string type;
+        Footprint footprint;
+    };
+
+    //! Reads a field of /proc/self/status in bytes, negative if it is not available
+    inline std::int64_t proc_status_bytes(const char *field) {
+        std::ifstream in("/proc/self/status");
+        std::string key;
+        std::int64_t value;
+        std::string unit;
+        while (in >> key) {
+            if (key == field && in >> value >> unit) {
+                return value * 1024;
+            }
+            in.ignore(4096, '\n');
+        }
+        return -1;
+    }
+
+    //! Resets the peak resident set size of the process to the current one, returns false if not supported
+    inline bool reset_peak_rss() {
+        std::ofstream out("/proc/self/clear_refs");
+        out << "5";
+        out.flush();
+        return bool(out);
+    }
+
+    //! Current resident set size in bytes, negative if not available
+    inline std::int64_t current_rss() {
+        return proc_status_bytes("VmRSS:");
+    }
+
+    //! Peak resident set size in bytes since the start or the last reset_peak_rss(), negative if not available
+    inline std::int64_t peak_rss() {
+        return proc_status_bytes("VmHWM:");
+    }
+
+    /*!
+     * Measures a footprint in a child process, so that peak RSS is not affected by memory the benchmark process
+     * and earlier measurements have touched. Falls back to an in-process measurement if fork() is not available.
+     * @param measure Callable returning a Footprint
+     */
+    template<typename Measure>
+    Footprint measure_isolated(Measure measure) {
+#ifdef __linux__
+        int fds[2];
+        if (pipe(fds) == 0) {
+            pid_t pid = fork();
+            if (pid == 0) {
+                close(fds[0]);
+                Footprint footprint = measure();
+                auto written = write(fds[1], &footprint, sizeof(footprint));
+                _exit(written == ssize_t(sizeof(footprint)) ? 0 : 1);
+            }
+            close(fds[1]);
+            if (pid > 0) {
+                Footprint footprint;
+                auto received = read(fds[0], &footprint, sizeof(footprint));
+                int status = 0;
+                waitpid(pid, &status, 0);
+                close(fds[0]);
+                if (received == ssize_t(sizeof(footprint)) && WIFEXITED(status) && WEXITSTATUS(status) == 0) {
+                    return footprint;
+                }
+                return {};
+            }
+            close(fds[0]);
+        }
+#endif
+        Footprint footprint = measure();
+        footprint.peakRssBytes = -1;
+        return footprint;
+    }
+
+    //! Formats a number with a fixed amount of decimals
+    inline std::string format_fixed(double value, int decimals) {
+        char buffer[64];
+        std::snprintf(buffer, sizeof(buffer), "%.*f", decimals, value);
+        return buffer;
+    }
+
+    /*!
+     * Writes footprints as a Markdown table
+     * @param out Stream to write to
+     * @param rows Measured footprints
+     */
+    inline void write_footprint_table(std::ostream &out, const std::vector<FootprintRow> &rows) {
+        out << "| dist | impl | type | members | ranges | heap bytes | bytes/member | bytes/range | build ns/member"
+               " | peak RSS KiB |\n"
+               "|---|---|---|--:|--:|--:|--:|--:|--:|--:|\n";
+        for (const auto &row : rows) {
+            const auto &f = row.footprint;
+            out << "| " << row.dist << " | " << row.impl << " | " << row.type << " | ";
+            if (!f.supported) {
+                out << "n/a | n/a | n/a | n/a | n/a | n/a | n/a |\n";
+                continue;
+            }
+            double members = f.members ? double(f.members) : 1.0;
+            double ranges = f.ranges ? double(f.ranges) : 1.0;
+            out << f.members << " | " << f.ranges << " | " << f.heapBytes << " | "
+                << format_fixed(double(f.heapBytes) / members, 3) << " | "
+                << format_fixed(double(f.heapBytes) / ranges, 2) << " | "
+                << format_fixed(f.buildNs / members, 2) << " | "
+                << (f.peakRssBytes < 0 ? std::string("n/a") : std::to_string(f.peakRssBytes / 1024)) << " |\n";
+        }
+    }
+
+}
+
+#endif // INTEGRALRANGE_BENCHMEMORY_H
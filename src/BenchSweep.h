@@ -0,0 +1,186 @@
+// Copyright 2019 Dmitry Valter
+// Copyright 2019 Sviatoslav Dmitriev
+// Distributed under the Boost Software License, Version 1.0.
+// See accompanying file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt
+
+#ifndef INTEGRALRANGE_BENCHSWEEP_H
+#define INTEGRALRANGE_BENCHSWEEP_H
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "BenchHarness.h"
+
+namespace ranges::bench {
+
+    //! Candidate complexity curve
+    struct Complexity {
+        //! Name in big-O notation, e.g. "O(n log n)"
+        std::string name;
+
+        //! Growth function
+        std::function<double(double)> curve;
+    };
+
+    //! Returns the candidate curves in the order of growth
+    inline const std::vector<Complexity> &complexities() {
+        static const std::vector<Complexity> result{
+                {"O(1)", [](double) { return 1.0; }},
+                {"O(log n)", [](double n) { return std::log2(std::max(n, 2.0)); }},
+                {"O(n)", [](double n) { return n; }},
+                {"O(n log n)", [](double n) { return n * std::log2(std::max(n, 2.0)); }},
+                {"O(n^2)", [](double n) { return n * n; }},
+                {"O(n^2 log n)", [](double n) { return n * n * std::log2(std::max(n, 2.0)); }},
+                {"O(n^3)", [](double n) { return n * n * n; }},
+        };
+        return result;
+    }
+
+    //! Fit of measurements to a complexity curve
+    struct ComplexityFit {
+        //! Name of the curve
+        std::string name;
+
+        //! Least-squares coefficient of the curve, in nanoseconds
+        double coefficient;
+
+        //! Root mean square of relative residuals
+        double error;
+    };
+
+    /*!
+     * Fits measurements to every candidate curve t = c * f(n). The coefficient minimizes squared relative
+     * residuals, so that small and large parameter values weigh equally.
+     * @param params Swept parameter values
+     * @param times Measured times
+     * @return Fits ordered from the best to the worst
+     */
+    inline std::vector<ComplexityFit> fit_complexity(const std::vector<double> &params,
+                                                     const std::vector<double> &times) {
+        std::vector<ComplexityFit> result;
+        for (const auto &complexity : complexities()) {
+            // Minimizing sum((c * f / t - 1)^2) gives c = sum(f / t) / sum((f / t)^2)
+            double linear = 0.0;
+            double square = 0.0;
+            for (std::size_t i = 0; i < params.size(); i++) {
+                double ratio = complexity.curve(params[i]) / times[i];
+                linear += ratio;
+                square += ratio * ratio;
+            }
+            double coefficient = square > 0.0 ? linear / square : 0.0;
+
+            double residuals = 0.0;
+            for (std::size_t i = 0; i < params.size(); i++) {
+                double residual = coefficient * complexity.curve(params[i]) / times[i] - 1.0;
+                residuals += residual * residual;
+            }
+            double error = params.empty() ? 0.0 : std::sqrt(residuals / double(params.size()));
+            result.push_back({complexity.name, coefficient, error});
+        }
+        std::stable_sort(result.begin(), result.end(), [](const ComplexityFit &a, const ComplexityFit &b) {
+            return a.error < b.error;
+        });
+        return result;
+    }
+
+    /*!
+     * Fits measurements to a power law t = c * n^k by linear regression in log-log space. Unlike the curve fits
+     * the exponent is not restricted to the candidates, so mixed terms like n^2 + n show up as k between 1 and 2.
+     * @param params Swept parameter values
+     * @param times Measured times
+     * @return Exponent k
+     */
+    inline double fit_exponent(const std::vector<double> &params, const std::vector<double> &times) {
+        double n = double(params.size());
+        double sumX = 0.0, sumY = 0.0, sumXX = 0.0, sumXY = 0.0;
+        for (std::size_t i = 0; i < params.size(); i++) {
+            double x = std::log(params[i]);
+            double y = std::log(times[i]);
+            sumX += x;
+            sumY += y;
+            sumXX += x * x;
+            sumXY += x * y;
+        }
+        double denominator = n * sumXX - sumX * sumX;
+        return denominator != 0.0 ? (n * sumXY - sumX * sumY) / denominator : 0.0;
+    }
+
+    //! Measurements of an operation over a swept parameter
+    struct Sweep {
+        //! Name of the operation, e.g. "unite_ranges"
+        std::string operation;
+
+        //! Name of the swept parameter
+        std::string param;
+
+        //! Fixed parameters
+        std::vector<std::pair<std::string, std::string>> fixed;
+
+        //! Swept parameter values
+        std::vector<double> values;
+
+        //! Measurements for every value
+        std::vector<CaseResult> results;
+
+        //! Fits ordered from the best to the worst
+        std::vector<ComplexityFit> fits;
+
+        //! Exponent of the power law fit
+        double exponent = 0.0;
+    };
+
+    /*!
+     * Writes sweeps as JSON
+     * @param out Stream to write to
+     * @param context Free-form key-value description of the run
+     * @param sweeps Measured sweeps
+     */
+    inline void write_sweeps(std::ostream &out, const std::vector<std::pair<std::string, std::string>> &context,
+                             const std::vector<Sweep> &sweeps) {
+        out << "{\n  \"context\": {";
+        for (std::size_t i = 0; i < context.size(); i++) {
+            out << (i ? ", " : "");
+            write_json_string(out, context[i].first);
+            out << ": ";
+            write_json_string(out, context[i].second);
+        }
+        out << "},\n  \"sweeps\": [";
+
+        for (std::size_t s = 0; s < sweeps.size(); s++) {
+            const auto &sweep = sweeps[s];
+            out << (s ? ",\n" : "\n") << "    {\"operation\": ";
+            write_json_string(out, sweep.operation);
+            out << ", \"param\": ";
+            write_json_string(out, sweep.param);
+            out << ", \"fixed\": {";
+            for (std::size_t i = 0; i < sweep.fixed.size(); i++) {
+                out << (i ? ", " : "");
+                write_json_string(out, sweep.fixed[i].first);
+                out << ": ";
+                write_json_string(out, sweep.fixed[i].second);
+            }
+            out << "},\n     \"points\": [";
+            for (std::size_t i = 0; i < sweep.values.size(); i++) {
+                const auto &r = sweep.results[i];
+                out << (i ? ", " : "") << "{\"value\": " << sweep.values[i] << ", \"ns_per_op\": " << r.median()
+                    << ", \"ns_per_op_min\": " << r.min() << ", \"items_per_iteration\": " << r.items << "}";
+            }
+            out << "],\n     \"exponent\": " << sweep.exponent << ", \"fits\": [";
+            for (std::size_t i = 0; i < sweep.fits.size(); i++) {
+                out << (i ? ", " : "") << "{\"complexity\": ";
+                write_json_string(out, sweep.fits[i].name);
+                out << ", \"coefficient_ns\": " << sweep.fits[i].coefficient << ", \"rms_error\": "
+                    << sweep.fits[i].error << "}";
+            }
+            out << "]}";
+        }
+        out << "\n  ]\n}\n";
+    }
+
+}
+
+#endif // INTEGRALRANGE_BENCHSWEEP_H
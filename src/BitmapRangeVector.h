@@ -0,0 +1,508 @@
+// Copyright 2019 Dmitry Valter
+// Copyright 2019 Sviatoslav Dmitriev
+// Distributed under the Boost Software License, Version 1.0.
+// See accompanying file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt
+
+#ifndef INTEGRALRANGE_BITMAPRANGEVECTOR_H
+#define INTEGRALRANGE_BITMAPRANGEVECTOR_H
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <limits>
+#include <memory>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "IntegralRangeVector.h"
+#include "RangeHooks.h"
+#include "RangeKernels.h"
+
+namespace ranges {
+
+    /**
+     * Set of 8-bit or 16-bit unsigned values stored as a fixed bitmap of the whole universe, 32 bytes or 8 KiB.
+     * It has the interface of IntegralRangeVector: iteration yields ranges of consecutive values, and it can be
+     * built from the same encoded words. Merges are word-parallel and the length is a popcount. All values but the
+     * largest one are usable, as the exclusive ending of a range containing it would not fit into T. Ranges and
+     * values may be added in any order.
+     *
+     * Use RangeSet<T> to get this container for small types and IntegralRangeVector for the others.
+     */
+    template<typename T>
+    class BitmapRangeVector {
+    public:
+        static_assert(std::is_unsigned_v<T> && std::numeric_limits<T>::digits <= 16);
+
+        //! Amount of values of T, the bit of the largest one is never set
+        static constexpr std::size_t UNIVERSE = std::size_t(std::numeric_limits<T>::max()) + 1u;
+
+        //! Amount of bitmap words
+        static constexpr std::size_t WORDS = UNIVERSE / 64u;
+
+        //! Type of value returned when iterating over the container
+        typedef std::pair<T, T> value_type;
+
+        //! Type of value used to calculate range size
+        typedef std::size_t size_type;
+
+        //! Type that represents difference between two positions in the container
+        typedef std::ptrdiff_t difference_type;
+
+        //! Type of the internal container
+        typedef std::array<std::uint64_t, WORDS> base_type;
+
+    private:
+        base_type _bits{};
+
+        //! Returns the first position not before the given one whose bit equals the given value
+        std::size_t find(std::size_t position, bool value) const {
+            std::size_t index = position / 64u;
+            if (index >= WORDS) {
+                return UNIVERSE;
+            }
+            std::uint64_t word = (value ? _bits[index] : ~_bits[index]) & (~std::uint64_t(0u) << (position % 64u));
+            while (word == 0u) {
+                if (++index == WORDS) {
+                    return UNIVERSE;
+                }
+                word = value ? _bits[index] : ~_bits[index];
+            }
+            return std::min(index * 64u + dispatch::lowest_bit(word), UNIVERSE);
+        }
+
+        //! Sets the bits of positions [begin, end)
+        void fill(std::size_t begin, std::size_t end) {
+            if (begin >= end) {
+                return;
+            }
+            std::size_t first = begin / 64u, last = (end - 1u) / 64u;
+            std::uint64_t head = ~std::uint64_t(0u) << (begin % 64u);
+            std::uint64_t tail = ~std::uint64_t(0u) >> (63u - (end - 1u) % 64u);
+            if (first == last) {
+                _bits[first] |= head & tail;
+                return;
+            }
+            _bits[first] |= head;
+            for (std::size_t i = first + 1u; i < last; i++) {
+                _bits[i] = ~std::uint64_t(0u);
+            }
+            _bits[last] |= tail;
+        }
+
+    public:
+
+        //! Class used to iterate over range container
+        class const_iterator {
+        public:
+
+            //! Default constructor - creates an end iterator
+            const_iterator() = default;
+
+            //! Type of values stored in the iterated container
+            typedef BitmapRangeVector::value_type value_type;
+
+            //! Reference to the stored value
+            typedef const value_type &reference;
+
+            //! Constant reference to the stored value
+            typedef const value_type &const_reference;
+
+            //! Pointer to the stored value
+            typedef const value_type *pointer;
+
+            //! Constant pointer to the stored value
+            typedef const value_type *const_pointer;
+
+            //! Difference between two iterators
+            typedef std::ptrdiff_t difference_type;
+
+            //! Iterator category
+            typedef std::input_iterator_tag iterator_category;
+
+        private:
+            const BitmapRangeVector *_owner = nullptr;
+            std::size_t _position = UNIVERSE;
+
+            value_type _current_value = {T(0u), T(0u)};
+
+            void calculate_value() {
+                _position = _owner->find(_position, true);
+                if (_position == UNIVERSE) {
+                    _current_value = {T(0u), T(0u)};
+                }
+                else {
+                    _current_value = {T(_position), T(_owner->find(_position, false))};
+                }
+            }
+
+            const_iterator(const BitmapRangeVector *owner, std::size_t position) : _owner(owner), _position(position) {
+                calculate_value();
+            }
+
+            friend class BitmapRangeVector<T>;
+
+        public:
+
+            //! Equals operator between two iterators
+            bool operator==(const const_iterator &other) const { return _position == other._position; }
+
+            //! Not equals operator between two iterators
+            bool operator!=(const const_iterator &other) const { return _position != other._position; }
+
+            //! Lesser than operator between two iterators
+            bool operator<(const const_iterator &other) const { return _position < other._position; }
+
+            //! Greater than operator between two iterators
+            bool operator>(const const_iterator &other) const { return _position > other._position; }
+
+            //! Lesser or equal operator between two iterators
+            bool operator<=(const const_iterator &other) const { return _position <= other._position; }
+
+            //! Greater or equal operator between two iterators
+            bool operator>=(const const_iterator &other) const { return _position >= other._position; }
+
+            //! Dereference operator
+            const_reference operator*() const {
+                assert(_position < UNIVERSE);
+
+                return _current_value;
+            }
+
+            //! Member access operator
+            const_pointer operator->() const {
+                assert(_position < UNIVERSE);
+
+                return &_current_value;
+            }
+
+            //! Postfix increment operator
+            const_iterator operator++(int) {
+                const_iterator result = *this;
+                ++(*this);
+                return result;
+            }
+
+            //! Prefix increment operator
+            const_iterator &operator++() {
+                if (_position < UNIVERSE) {
+                    _position = _current_value.second;
+                    calculate_value();
+                }
+                return *this;
+            }
+        };
+
+        //! Default constructor - creates an empty container
+        BitmapRangeVector() = default;
+
+        /*!
+         * Initializes container from words in the encoding of IntegralRangeVector
+         * @param vect Encoded words
+         */
+        template<typename Allocator>
+        BitmapRangeVector(const std::vector<T, Allocator> &vect) : BitmapRangeVector(vect.begin(), vect.end()) {}
+
+        /*!
+         * Initializes container from a range of words in the encoding of IntegralRangeVector
+         * @param first First word of the range
+         * @param last Past the last word of the range
+         */
+        template<typename InputIt>
+        BitmapRangeVector(InputIt first, InputIt last) {
+            constexpr T mask = IntegralRangeVector<T>::mask;
+            for (; first != last; ++first) {
+                T word = *first;
+                if (word & mask) {
+                    ++first;
+                    assert(first != last);
+                    push_back(value_type(T(word & ~mask), T(*first & ~mask)));
+                }
+                else {
+                    push_back(word);
+                }
+            }
+        }
+
+        //! Initializes container with the values of a range vector
+        template<typename Allocator>
+        explicit BitmapRangeVector(const IntegralRangeVector<T, Allocator> &other) {
+            for (const auto &range : other) {
+                push_back(range);
+            }
+        }
+
+        /*!
+         * Does nothing, the bitmap has a fixed size
+         * @param size Amount of range pairs to store in the container, ignored
+         */
+        void reserve(size_type /* size */) {}
+
+        /*!
+         * Adds a value range to the container
+         * @param val A value range to add
+         */
+        void push_back(value_type val) {
+            assert(val.first <= val.second);
+
+            fill(val.first, val.second);
+        }
+
+        /*!
+         * Adds a single value to the container
+         * @param val A value to add, anything but the largest value of T
+         * @throws std::out_of_range if the value is the largest value of T, which cannot be iterated as a range
+         */
+        void push_back(T val) {
+            if (val == std::numeric_limits<T>::max()) {
+                throw std::out_of_range("BitmapRangeVector cannot store the largest value of its type");
+            }
+
+            _bits[val / 64u] |= std::uint64_t(1u) << (val % 64u);
+        }
+
+        //! Equals operator for two bitmap containers
+        bool operator==(const BitmapRangeVector &other) const { return _bits == other._bits; }
+
+        //! Not equals operator for two bitmap containers
+        bool operator!=(const BitmapRangeVector &other) const { return _bits != other._bits; }
+
+        //! Returns a constant iterator pointing to the beginning of the container
+        const_iterator cbegin() const { return {this, 0u}; }
+
+        //! Returns a constant iterator pointing to the end of the container
+        const_iterator cend() const { return {this, UNIVERSE}; }
+
+        //! Returns an iterator pointing to the beginning of the container
+        const_iterator begin() const { return cbegin(); }
+
+        //! Returns an iterator pointing to the end of the container
+        const_iterator end() const { return cend(); }
+
+        //! Returns the internal bitmap, the value v is bit v % 64 of word v / 64
+        const base_type &getBase() const { return _bits; }
+
+        //! Converts the stored values to a vector
+        template<typename Allocator1 = std::allocator<T>>
+        std::vector<T, Allocator1> toVector(const Allocator1 allocator = Allocator1()) const {
+            std::vector<T, Allocator1> result(length(), T(0u), allocator);
+            T *out = result.data();
+            for (std::size_t i = 0; i < WORDS; i++) {
+                for (std::uint64_t word = _bits[i]; word; word &= word - 1u) {
+                    *(out++) = T(i * 64u + dispatch::lowest_bit(word));
+                }
+            }
+            return result;
+        }
+
+        /*!
+         * Creates a container from values in any order
+         * @param values Values to store
+         * @return Container storing the values
+         */
+        template<typename Allocator1>
+        static BitmapRangeVector fromVector(const std::vector<T, Allocator1> &values) {
+            BitmapRangeVector result;
+            for (T value : values) {
+                result.push_back(value);
+            }
+            return result;
+        }
+
+        //! Checks if a value is stored in the container
+        bool contains(T val) const {
+            return (_bits[val / 64u] >> (val % 64u)) & 1u;
+        }
+
+        //! Checks if the container is empty
+        bool empty() const {
+            for (auto word : _bits) {
+                if (word) {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        //! Returns an amount of individual values stored in a range container
+        size_type length() const {
+            return size_type(dispatch::kernels<T>().countBits(_bits.data(), WORDS));
+        }
+
+        /*!
+         * Calculates structural statistics of the stored ranges, encoding sizes describe IntegralRangeVector
+         * @return Range count, run and gap length histograms, span, density and sizes under different encodings
+         */
+        RangeStatistics analyze() const {
+            RangeStatistics result;
+            std::uint64_t first = 0u;
+            std::uint64_t previousEnd = 0u;
+            std::size_t words = 0u;
+
+            for (const auto &range : *this) {
+                std::uint64_t size = std::uint64_t(range.second - range.first);
+                if (result.ranges == 0u) {
+                    first = range.first;
+                }
+                else {
+                    result.gapLengths[RangeStatistics::bucket(range.first - previousEnd)]++;
+                }
+                result.singletons += size == 1u;
+                result.runLengths[RangeStatistics::bucket(size)]++;
+                result.ranges++;
+                result.length += size_type(size);
+                words += size == 1u ? 1u : 2u;
+                previousEnd = range.second;
+            }
+
+            result.span = previousEnd - first;
+            result.singletonRatio = result.ranges ? double(result.singletons) / double(result.ranges) : 0.0;
+            result.density = result.span ? double(result.length) / double(result.span) : 0.0;
+            result.rangeEncodingBytes = words * sizeof(T);
+            result.pairEncodingBytes = result.ranges * 2u * sizeof(T);
+            result.valueEncodingBytes = result.length * sizeof(T);
+            result.bitmapEncodingBytes = std::size_t((result.span + 7u) / 8u);
+            return result;
+        }
+
+        //! Adds the values of another set
+        BitmapRangeVector &operator|=(const BitmapRangeVector &other) {
+            for (std::size_t i = 0; i < WORDS; i++) {
+                _bits[i] |= other._bits[i];
+            }
+            return *this;
+        }
+
+        //! Keeps the values that are also in another set
+        BitmapRangeVector &operator&=(const BitmapRangeVector &other) {
+            for (std::size_t i = 0; i < WORDS; i++) {
+                _bits[i] &= other._bits[i];
+            }
+            return *this;
+        }
+
+        //! Removes the values of another set
+        BitmapRangeVector &operator-=(const BitmapRangeVector &other) {
+            for (std::size_t i = 0; i < WORDS; i++) {
+                _bits[i] &= ~other._bits[i];
+            }
+            return *this;
+        }
+
+        //! Returns the values of the universe that are not in the set, except the largest value of T
+        BitmapRangeVector operator~() const {
+            BitmapRangeVector result;
+            for (std::size_t i = 0; i < WORDS; i++) {
+                result._bits[i] = ~_bits[i];
+            }
+            result._bits[WORDS - 1u] &= ~std::uint64_t(0u) >> 1u;
+            return result;
+        }
+    };
+
+    //! Calculates a union of two bitmap sets
+    template<typename T>
+    BitmapRangeVector<T> operator|(BitmapRangeVector<T> a, const BitmapRangeVector<T> &b) {
+        return a |= b;
+    }
+
+    //! Calculates an intersection of two bitmap sets
+    template<typename T>
+    BitmapRangeVector<T> operator&(BitmapRangeVector<T> a, const BitmapRangeVector<T> &b) {
+        return a &= b;
+    }
+
+    //! Calculates values of the first bitmap set that are not in the second one
+    template<typename T>
+    BitmapRangeVector<T> operator-(BitmapRangeVector<T> a, const BitmapRangeVector<T> &b) {
+        return a -= b;
+    }
+
+    //! Calculates an intersection of any amount of bitmap sets word by word, see intersect_ranges() for others
+    template<typename T>
+    BitmapRangeVector<T> intersect_ranges(const std::vector<BitmapRangeVector<T>> &ranges,
+                                          OperationStats *stats = nullptr) {
+        INTEGRALRANGE_TRACE_SCOPE("intersect_ranges", "inputs", ranges.size());
+        StatsScope statsScope(stats);
+
+        if (ranges.empty()) {
+            return {};
+        }
+        BitmapRangeVector<T> result = ranges[0];
+        for (std::size_t i = 1; i < ranges.size(); i++) {
+            result &= ranges[i];
+        }
+        return result;
+    }
+
+    //! Calculates a union of any amount of bitmap sets word by word, see unite_ranges() for others
+    template<typename T>
+    BitmapRangeVector<T> unite_ranges(const std::vector<BitmapRangeVector<T>> &ranges,
+                                      OperationStats *stats = nullptr) {
+        INTEGRALRANGE_TRACE_SCOPE("unite_ranges", "inputs", ranges.size());
+        StatsScope statsScope(stats);
+
+        BitmapRangeVector<T> result;
+        for (const auto &set : ranges) {
+            result |= set;
+        }
+        return result;
+    }
+
+    //! Subtracts the other bitmap sets from the first one word by word, see subtract_ranges() for others
+    template<typename T>
+    BitmapRangeVector<T> subtract_ranges(const std::vector<BitmapRangeVector<T>> &ranges,
+                                         OperationStats *stats = nullptr) {
+        INTEGRALRANGE_TRACE_SCOPE("subtract_ranges", "inputs", ranges.size());
+        StatsScope statsScope(stats);
+
+        if (ranges.empty()) {
+            return {};
+        }
+        BitmapRangeVector<T> result = ranges[0];
+        for (std::size_t i = 1; i < ranges.size(); i++) {
+            result -= ranges[i];
+        }
+        return result;
+    }
+
+    //! Calculates an intersection of two bitmap sets
+    template<typename T>
+    BitmapRangeVector<T> intersect(const BitmapRangeVector<T> &a, const BitmapRangeVector<T> &b) {
+        return a & b;
+    }
+
+    //! Calculates a union of two bitmap sets
+    template<typename T>
+    BitmapRangeVector<T> unite(const BitmapRangeVector<T> &a, const BitmapRangeVector<T> &b) {
+        return a | b;
+    }
+
+    //! Calculates an intersection of any amount of bitmap sets
+    template<typename T, typename... Sets>
+    auto intersect(const BitmapRangeVector<T> &a, const BitmapRangeVector<T> &b, const Sets &... rest) {
+        return intersect(a & b, rest...);
+    }
+
+    //! Calculates a union of any amount of bitmap sets
+    template<typename T, typename... Sets>
+    auto unite(const BitmapRangeVector<T> &a, const BitmapRangeVector<T> &b, const Sets &... rest) {
+        return unite(a | b, rest...);
+    }
+
+    /**
+     * Range set with the most compact container for the value type: a bitmap for 8-bit and 16-bit values and the
+     * run encoding of IntegralRangeVector for wider ones
+     */
+    template<typename T>
+    using RangeSet = std::conditional_t<(std::numeric_limits<T>::digits <= 16), BitmapRangeVector<T>,
+                                        IntegralRangeVector<T>>;
+
+}
+
+#endif // INTEGRALRANGE_BITMAPRANGEVECTOR_H
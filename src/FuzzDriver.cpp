@@ -0,0 +1,62 @@
+// Copyright 2019 Dmitry Valter
+// Copyright 2019 Sviatoslav Dmitriev
+// Distributed under the Boost Software License, Version 1.0.
+// See accompanying file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt
+
+// Standalone driver for fuzz targets when libFuzzer is not available: replays inputs given as files or runs
+// the target on random inputs. Accepts the libFuzzer flags -runs=<n>, -seed=<n> and -max_len=<n>.
+
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <random>
+#include <string>
+#include <vector>
+
+extern "C" int LLVMFuzzerTestOneInput(const std::uint8_t *data, std::size_t size);
+
+int main(int argc, char **argv) {
+    std::size_t runs = 10000u;
+    std::uint64_t seed = 1u;
+    std::size_t maxLength = 512u;
+    std::vector<std::string> files;
+
+    for (int i = 1; i < argc; i++) {
+        if (std::strncmp(argv[i], "-runs=", 6) == 0) {
+            runs = std::stoul(argv[i] + 6);
+        }
+        else if (std::strncmp(argv[i], "-seed=", 6) == 0) {
+            seed = std::stoull(argv[i] + 6);
+        }
+        else if (std::strncmp(argv[i], "-max_len=", 9) == 0) {
+            maxLength = std::stoul(argv[i] + 9);
+        }
+        else if (argv[i][0] != '-') {
+            files.emplace_back(argv[i]);
+        }
+    }
+
+    if (!files.empty()) {
+        for (const auto &file : files) {
+            std::ifstream in(file, std::ios::binary);
+            std::vector<std::uint8_t> data((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+            std::cerr << "Running " << file << '\n';
+            LLVMFuzzerTestOneInput(data.data(), data.size());
+        }
+        return 0;
+    }
+
+    std::mt19937_64 engine(seed);
+    std::vector<std::uint8_t> data;
+    for (std::size_t run = 0; run < runs; run++) {
+        data.resize(std::uniform_int_distribution<std::size_t>(0u, maxLength)(engine));
+        for (auto &byte : data) {
+            byte = std::uint8_t(engine());
+        }
+        LLVMFuzzerTestOneInput(data.data(), data.size());
+    }
+    std::cerr << "Done " << runs << " runs\n";
+    return 0;
+}
@@ -0,0 +1,1306 @@
+// Copyright 2019 Dmitry Valter
+// Copyright 2019 Sviatoslav Dmitriev
+// Distributed under the Boost Software License, Version 1.0.
+// See accompanying file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt
+
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <new>
+#include <random>
+#include <sstream>
+#include <thread>
+
+#include <unistd.h>
+
+#include "BenchBaselines.h"
+#include "BenchCompare.h"
+#include "BenchCursors.h"
+#include "BenchDatasets.h"
+#include "BenchHarness.h"
+#include "BenchIndex.h"
+#include "BenchLatency.h"
+#include "BenchMemory.h"
+#include "BenchSweep.h"
+#include "BitmapRangeVector.h"
+#include "IntegralRangeVector.h"
+#include "RangeExpression.h"
+#include "RangeMerger.h"
+#include "RangeRecorder.h"
+
+using namespace ranges;
+using namespace ranges::bench;
+
+// Global allocation hooks feeding allocation_counters(). Every block is prefixed with its size so that frees
+// can be accounted for without sized deallocation. The hooks are not inlined, otherwise GCC checks the header
+// arithmetic against the allocations of inlined callers and reports false bound violations.
+
+namespace {
+
+    constexpr std::size_t ALLOCATION_HEADER = alignof(std::max_align_t);
+
+    __attribute__((noinline)) void *counted_allocate(std::size_t size) {
+        auto *block = static_cast<unsigned char *>(std::malloc(size + ALLOCATION_HEADER));
+        if (block == nullptr) {
+            return nullptr;
+        }
+        *reinterpret_cast<std::size_t *>(block) = size;
+
+        auto &counters = allocation_counters();
+        counters.allocations++;
+        counters.allocatedBytes += size;
+        counters.liveBytes += std::int64_t(size);
+        return block + ALLOCATION_HEADER;
+    }
+
+    __attribute__((noinline)) void counted_free(void *ptr) {
+        if (ptr == nullptr) {
+            return;
+        }
+        auto *block = static_cast<unsigned char *>(ptr) - ALLOCATION_HEADER;
+        allocation_counters().liveBytes -= std::int64_t(*reinterpret_cast<std::size_t *>(block));
+        std::free(block);
+    }
+
+}
+
+void *operator new(std::size_t size) {
+    if (auto *ptr = counted_allocate(size)) {
+        return ptr;
+    }
+    throw std::bad_alloc();
+}
+
+void *operator new[](std::size_t size) {
+    return operator new(size);
+}
+
+void *operator new(std::size_t size, const std::nothrow_t &) noexcept {
+    return counted_allocate(size);
+}
+
+void *operator new[](std::size_t size, const std::nothrow_t &) noexcept {
+    return counted_allocate(size);
+}
+
+void operator delete(void *ptr) noexcept {
+    counted_free(ptr);
+}
+
+void operator delete[](void *ptr) noexcept {
+    counted_free(ptr);
+}
+
+void operator delete(void *ptr, std::size_t) noexcept {
+    counted_free(ptr);
+}
+
+void operator delete[](void *ptr, std::size_t) noexcept {
+    counted_free(ptr);
+}
+
+namespace {
+
+    constexpr std::uint64_t DEFAULT_SEED = 0x1e3a1u;
+
+    //! Shape of a generated set
+    struct Shape {
+        std::size_t ranges;
+        double density;
+        double meanRun;
+    };
+
+    //! Generates a set of the given shape
+    template<typename T>
+    IntegralRangeVector<T> make_set(const Shape &shape, std::uint64_t seed) {
+        std::mt19937_64 engine(seed);
+        return gen::with_density<IntegralRangeVector<T>>(engine, shape.ranges, shape.density, shape.meanRun);
+    }
+
+    //! Generates a family of independent sets of the same shape
+    template<typename T>
+    std::vector<IntegralRangeVector<T>> make_sets(std::size_t count, const Shape &shape, std::uint64_t seed) {
+        std::vector<IntegralRangeVector<T>> result;
+        result.reserve(count);
+        for (std::size_t i = 0; i < count; i++) {
+            result.push_back(make_set<T>(shape, seed + i));
+        }
+        return result;
+    }
+
+    template<typename T>
+    const char *type_name() {
+        return sizeof(T) == 2 ? "uint16" : sizeof(T) == 4 ? "uint32" : "uint64";
+    }
+
+    std::string str(double value) {
+        std::ostringstream out;
+        out << value;
+        return out.str();
+    }
+
+    //! Reports operation counters of a single call
+    void report_stats(State &state, const OperationStats &stats) {
+        state.counter("cursor_advances", double(stats.cursorAdvances));
+        state.counter("head_comparisons", double(stats.headComparisons));
+        state.counter("emitted_ranges", double(stats.emittedRanges));
+        state.counter("coalesced_merges", double(stats.coalescedMerges));
+        state.counter("allocations", double(stats.allocations));
+        state.counter("reallocations", double(stats.reallocations));
+    }
+
+    //! Returns the amount of words of sets
+    template<typename T>
+    std::size_t total_size(const std::vector<IntegralRangeVector<T>> &sets) {
+        std::size_t result = 0u;
+        for (const auto &set : sets) {
+            result += set.getBase().size();
+        }
+        return result;
+    }
+
+    template<typename T>
+    void register_width(Registry &registry, std::uint64_t seed) {
+        std::vector<std::size_t> sizes{1000u};
+        if (sizeof(T) > 2) {
+            sizes.push_back(50000u);
+        }
+
+        for (auto ranges : sizes) {
+            for (double density : {0.1, 0.9}) {
+                Shape shape{ranges, density, 8.0};
+                std::vector<std::pair<std::string, std::string>> params{
+                        {"type", type_name<T>()}, {"ranges", std::to_string(ranges)}, {"density", str(density)}};
+
+                registry.add("push_back", params, [=](State &state) {
+                    auto values = make_set<T>(shape, seed).toVector();
+                    state.setItemsPerIteration(values.size());
+                    for (auto _ : state) {
+                        IntegralRangeVector<T> result;
+                        for (auto value : values) {
+                            result.push_back(value);
+                        }
+                        do_not_optimize(result.getBase().data());
+                    }
+                });
+
+                registry.add("push_back_range", params, [=](State &state) {
+                    auto source = make_set<T>(shape, seed);
+                    std::vector<std::pair<T, T>> pairs(source.begin(), source.end());
+                    state.setItemsPerIteration(pairs.size());
+                    for (auto _ : state) {
+                        IntegralRangeVector<T> result;
+                        for (auto pair : pairs) {
+                            result.push_back(pair);
+                        }
+                        do_not_optimize(result.getBase().data());
+                    }
+                });
+
+                registry.add("iterate", params, [=](State &state) {
+                    auto set = make_set<T>(shape, seed);
+                    state.setItemsPerIteration(set.getBase().size());
+                    for (auto _ : state) {
+                        std::uint64_t sum = 0;
+                        for (const auto &range : set) {
+                            sum += range.second - range.first;
+                        }
+                        do_not_optimize(sum);
+                    }
+                });
+
+                registry.add("length", params, [=](State &state) {
+                    auto set = make_set<T>(shape, seed);
+                    state.setItemsPerIteration(set.getBase().size());
+                    for (auto _ : state) {
+                        state.pauseTiming();
+                        IntegralRangeVector<T> copy(set.getBase());
+                        state.resumeTiming();
+                        do_not_optimize(copy.length());
+                    }
+                });
+
+                registry.add("from_words", params, [=](State &state) {
+                    auto set = make_set<T>(shape, seed);
+                    state.setItemsPerIteration(set.getBase().size());
+                    for (auto _ : state) {
+                        IntegralRangeVector<T> copy(set.getBase());
+                        do_not_optimize(copy.getBase().data());
+                    }
+                });
+
+                registry.add("contains", params, [=](State &state) {
+                    auto set = make_set<T>(shape, seed);
+                    std::mt19937_64 engine(seed);
+                    std::vector<T> values(1024u);
+                    // Values up to the last stored one, so that lookups hit both ranges and gaps
+                    std::uint64_t last = set.empty() ? 0u : set.getBase().back() & ~IntegralRangeVector<T>::mask;
+                    for (auto &value : values) {
+                        value = T(std::uniform_int_distribution<std::uint64_t>(0u, last)(engine));
+                    }
+                    state.setItemsPerIteration(values.size());
+                    for (auto _ : state) {
+                        std::size_t found = 0u;
+                        for (auto value : values) {
+                            found += set.contains(value) ? 1u : 0u;
+                        }
+                        do_not_optimize(found);
+                    }
+                });
+
+                registry.add("analyze", params, [=](State &state) {
+                    auto set = make_set<T>(shape, seed);
+                    state.setItemsPerIteration(set.getBase().size());
+                    for (auto _ : state) {
+                        auto stats = set.analyze();
+                        do_not_optimize(stats);
+                    }
+                });
+
+                registry.add("toVector", params, [=](State &state) {
+                    auto set = make_set<T>(shape, seed);
+                    state.setItemsPerIteration(set.getBase().size());
+                    for (auto _ : state) {
+                        auto values = set.toVector();
+                        do_not_optimize(values.data());
+                    }
+                });
+
+                for (std::size_t inputs : {2u, 8u, 32u}) {
+                    auto merge_params = params;
+                    merge_params.insert(merge_params.begin() + 1, {"inputs", std::to_string(inputs)});
+
+                    registry.add("intersect_ranges", merge_params, [=](State &state) {
+                        auto sets = make_sets<T>(inputs, shape, seed);
+                        std::size_t items = 0;
+                        for (const auto &set : sets) {
+                            items += set.getBase().size();
+                        }
+                        state.setItemsPerIteration(items);
+                        if constexpr (stats_enabled()) {
+                            OperationStats stats;
+                            intersect_ranges(sets, &stats);
+                            report_stats(state, stats);
+                        }
+                        for (auto _ : state) {
+                            auto result = intersect_ranges(sets);
+                            do_not_optimize(result.getBase().data());
+                        }
+                    });
+
+                    registry.add("unite_ranges", merge_params, [=](State &state) {
+                        auto sets = make_sets<T>(inputs, shape, seed);
+                        std::size_t items = 0;
+                        for (const auto &set : sets) {
+                            items += set.getBase().size();
+                        }
+                        state.setItemsPerIteration(items);
+                        if constexpr (stats_enabled()) {
+                            OperationStats stats;
+                            unite_ranges(sets, &stats);
+                            report_stats(state, stats);
+                        }
+                        for (auto _ : state) {
+                            auto result = unite_ranges(sets);
+                            do_not_optimize(result.getBase().data());
+                        }
+                    });
+
+                    // The same merges over the bitmaps RangeSet picks for narrow types
+                    if constexpr (std::is_same_v<RangeSet<T>, BitmapRangeVector<T>>) {
+                        registry.add("intersect_bitmap", merge_params, [=](State &state) {
+                            auto sets = make_sets<T>(inputs, shape, seed);
+                            state.setItemsPerIteration(total_size(sets));
+                            std::vector<BitmapRangeVector<T>> bitmaps(sets.begin(), sets.end());
+                            for (auto _ : state) {
+                                auto result = intersect_ranges(bitmaps);
+                                do_not_optimize(result.getBase().data());
+                            }
+                        });
+
+                        registry.add("unite_bitmap", merge_params, [=](State &state) {
+                            auto sets = make_sets<T>(inputs, shape, seed);
+                            state.setItemsPerIteration(total_size(sets));
+                            std::vector<BitmapRangeVector<T>> bitmaps(sets.begin(), sets.end());
+                            for (auto _ : state) {
+                                auto result = unite_ranges(bitmaps);
+                                do_not_optimize(result.getBase().data());
+                            }
+                        });
+                    }
+                }
+
+                // Two inputs merged by the variadic merges, next to the intersect_ranges and unite_ranges cases
+                auto pair_params = params;
+                pair_params.insert(pair_params.begin() + 1, {"inputs", "2"});
+                registry.add("intersect_variadic", pair_params, [=](State &state) {
+                    auto sets = make_sets<T>(2u, shape, seed);
+                    state.setItemsPerIteration(total_size(sets));
+                    for (auto _ : state) {
+                        auto result = intersect(sets[0], sets[1]);
+                        do_not_optimize(result.getBase().data());
+                    }
+                });
+
+                registry.add("unite_variadic", pair_params, [=](State &state) {
+                    auto sets = make_sets<T>(2u, shape, seed);
+                    state.setItemsPerIteration(total_size(sets));
+                    for (auto _ : state) {
+                        auto result = unite(sets[0], sets[1]);
+                        do_not_optimize(result.getBase().data());
+                    }
+                });
+
+                // The query (a | b) & c & ~d, once as separate merges and once as a fused expression
+                registry.add("query_merges", params, [=](State &state) {
+                    auto sets = make_sets<T>(4u, shape, seed);
+                    state.setItemsPerIteration(total_size(sets));
+                    for (auto _ : state) {
+                        typedef std::vector<IntegralRangeVector<T>> Sets;
+                        auto result = subtract_ranges(Sets{
+                                intersect_ranges(Sets{unite_ranges(Sets{sets[0], sets[1]}), sets[2]}), sets[3]});
+                        do_not_optimize(result.getBase().data());
+                    }
+                });
+
+                registry.add("query_expression", params, [=](State &state) {
+                    auto sets = make_sets<T>(4u, shape, seed);
+                    state.setItemsPerIteration(total_size(sets));
+                    for (auto _ : state) {
+                        IntegralRangeVector<T> result = (sets[0] | sets[1]) & sets[2] & ~sets[3];
+                        do_not_optimize(result.getBase().data());
+                    }
+                });
+            }
+        }
+    }
+
+    /*!
+     * Registers a decode loop over the encoding of a generated set using a cursor design
+     * @tparam Cursor Cursor design, see BenchCursors.h
+     */
+    template<typename T, typename Cursor>
+    void register_cursor(Registry &registry, const Dataset<IntegralRangeVector<T>> &dataset, std::uint64_t seed) {
+        constexpr std::size_t RANGES = 10000u;
+        auto make = dataset.make;
+        registry.add("decode", {{"impl", Cursor::name}, {"dist", dataset.name}, {"type", type_name<T>()}},
+                     [=](State &state) {
+                         auto set = make(1u, RANGES, seed)[0];
+                         const T *data = set.getBase().data();
+                         state.setItemsPerIteration(set.getBase().size());
+                         for (auto _ : state) {
+                             std::uint64_t sum = 0;
+                             for (Cursor cursor(data, data + set.getBase().size()); !cursor.done(); cursor.advance()) {
+                                 sum += (*cursor).second - (*cursor).first;
+                             }
+                             do_not_optimize(sum);
+                         }
+                     });
+    }
+
+    /*!
+     * Compares the cursor designs against IntegralRangeVector::const_iterator: a decode loop over every dataset
+     * family for each of them
+     */
+    template<typename T>
+    void register_cursors(Registry &registry, std::uint64_t seed) {
+        constexpr std::size_t RANGES = 10000u;
+        for (const auto &dataset : datasets<IntegralRangeVector<T>>()) {
+            auto make = dataset.make;
+            registry.add("decode", {{"impl", "iterator"}, {"dist", dataset.name}, {"type", type_name<T>()}},
+                         [=](State &state) {
+                             auto set = make(1u, RANGES, seed)[0];
+                             state.setItemsPerIteration(set.getBase().size());
+                             for (auto _ : state) {
+                                 std::uint64_t sum = 0;
+                                 for (const auto &range : set) {
+                                     sum += range.second - range.first;
+                                 }
+                                 do_not_optimize(sum);
+                             }
+                         });
+            register_cursor<T, BranchyCursor<T>>(registry, dataset, seed);
+            register_cursor<T, LookaheadCursor<T>>(registry, dataset, seed);
+            register_cursor<T, BranchlessCursor<T>>(registry, dataset, seed);
+            register_cursor<T, BufferedCursor<T>>(registry, dataset, seed);
+            register_cursor<T, UncheckedCursor<T>>(registry, dataset, seed);
+            register_cursor<T, BlockCursor<T>>(registry, dataset, seed);
+        }
+    }
+
+    /*!
+     * Compares a set representation against the others: every operation over every dataset family
+     * @tparam Impl Set representation, see BenchBaselines.h
+     */
+    template<typename T, typename Impl>
+    void register_representation(Registry &registry, std::uint64_t seed) {
+        typedef typename Impl::set_type set_type;
+        constexpr std::size_t RANGES = 2000u;
+
+        for (const auto &dataset : datasets<std::vector<T>>()) {
+            auto make = dataset.make;
+            auto build_sets = [=](std::size_t inputs, std::size_t &members) {
+                std::vector<set_type> result;
+                members = 0u;
+                for (const auto &values : make(inputs, RANGES, seed)) {
+                    members += values.size();
+                    result.push_back(Impl::build(values));
+                }
+                return result;
+            };
+
+            std::vector<std::pair<std::string, std::string>> params{
+                    {"impl", Impl::name}, {"dist", dataset.name}, {"type", type_name<T>()},
+                    {"ranges", std::to_string(RANGES)}};
+
+            registry.add("build", params, [=](State &state) {
+                auto values = make(1u, RANGES, seed)[0];
+                state.setItemsPerIteration(values.size());
+
+                auto before = allocation_counters().liveBytes;
+                auto footprint = Impl::build(values);
+                auto bytes = double(allocation_counters().liveBytes - before);
+                state.counter("bytes_per_value", values.empty() ? 0.0 : bytes / double(values.size()));
+
+                for (auto _ : state) {
+                    auto result = Impl::build(values);
+                    do_not_optimize(result);
+                }
+            });
+
+            registry.add("visit", params, [=](State &state) {
+                std::size_t members;
+                auto set = build_sets(1u, members)[0];
+                state.setItemsPerIteration(members);
+                for (auto _ : state) {
+                    std::uint64_t sum = 0u;
+                    Impl::visit(set, [&](T value) { sum += value; });
+                    do_not_optimize(sum);
+                }
+            });
+
+            registry.add("length", params, [=](State &state) {
+                std::size_t members;
+                auto set = build_sets(1u, members)[0];
+                state.setItemsPerIteration(members);
+                for (auto _ : state) {
+                    if constexpr (Impl::cached_length) {
+                        state.pauseTiming();
+                        set_type copy = set;
+                        state.resumeTiming();
+                        do_not_optimize(Impl::length(copy));
+                    }
+                    else {
+                        do_not_optimize(Impl::length(set));
+                    }
+                }
+            });
+
+            registry.add("toVector", params, [=](State &state) {
+                std::size_t members;
+                auto set = build_sets(1u, members)[0];
+                state.setItemsPerIteration(members);
+                for (auto _ : state) {
+                    auto values = Impl::toVector(set);
+                    do_not_optimize(values.data());
+                }
+            });
+
+            for (std::size_t inputs : {2u, 8u}) {
+                auto merge_params = params;
+                merge_params.push_back({"inputs", std::to_string(inputs)});
+
+                registry.add("intersect", merge_params, [=](State &state) {
+                    std::size_t members;
+                    auto sets = build_sets(inputs, members);
+                    state.setItemsPerIteration(members);
+                    for (auto _ : state) {
+                        auto result = Impl::intersect(sets);
+                        do_not_optimize(result);
+                    }
+                });
+
+                registry.add("unite", merge_params, [=](State &state) {
+                    std::size_t members;
+                    auto sets = build_sets(inputs, members);
+                    state.setItemsPerIteration(members);
+                    for (auto _ : state) {
+                        auto result = Impl::unite(sets);
+                        do_not_optimize(result);
+                    }
+                });
+            }
+        }
+    }
+
+    //! Command line settings
+    struct Settings {
+        Options options;
+        std::uint64_t seed = DEFAULT_SEED;
+        bool seedSet = false;
+        bool repetitionsSet = false;
+        std::string outFile;
+        std::string baselineFile;
+        double threshold = 0.05;
+        bool list = false;
+        bool perf = true;
+        bool memory = false;
+        std::size_t memoryRanges = 20000u;
+        std::string traceFile;
+        std::string recordFile;
+        std::string sweep;
+        bool index = false;
+        std::size_t queries = 20000u;
+        bool latency = false;
+        std::size_t latencySamples = 5000u;
+        double load = 0.5;
+    };
+
+    void usage(const char *argv0) {
+        std::cerr << "Usage: " << argv0 << " [options]\n"
+                  << "  --filter=<regex>       run cases whose name matches the expression\n"
+                  << "  --min-time=<seconds>   minimum time of a single repetition\n"
+                  << "  --repetitions=<n>      amount of measured repetitions of every case\n"
+                  << "  --seed=<n>             seed of the generated inputs\n"
+                  << "  --out=<file>           write JSON to the file instead of stdout\n"
+                  << "  --list                 list case names and exit\n"
+                  << "  --baseline=<file>      rerun cases of a previous JSON result and compare, exits with 2\n"
+                  << "                         if a significant slowdown is found\n"
+                  << "  --threshold=<ratio>    relative change ignored by the comparison, 0.05 by default\n"
+                  << "  --no-perf              do not read hardware performance counters\n"
+                  << "  --memory               measure memory footprints of every representation and write a\n"
+                  << "                         Markdown table, --filter applies to memory/impl:/dist:/type: names\n"
+                  << "  --ranges=<n>           approximate amount of ranges of memory mode sets, 20000 by default\n"
+                  << "  --sweep=<param>        measure intersect_ranges and unite_ranges while doubling one parameter\n"
+                  << "                         (inputs, ranges, overlap or threads) and fit complexity curves\n"
+                  << "  --trace=<file>         write spans of cases and repetitions in Chrome trace-event format,\n"
+                  << "                         merges are traced too if built with INTEGRALRANGE_TRACE\n"
+                  << "  --record=<file>        record merges and lookups for IntegralRangeReplay, requires a build\n"
+                  << "                         with INTEGRALRANGE_RECORD\n"
+                  << "  --index                run a query mix against a synthetic inverted index and write\n"
+                  << "                         queries per second and latencies\n"
+                  << "  --queries=<n>          amount of queries of the index mode, 20000 by default\n"
+                  << "  --latency              issue single operations at random arrival times and write latency\n"
+                  << "                         percentiles, --filter applies to latency/op:/condition: names\n"
+                  << "  --samples=<n>          amount of operations of every latency measurement, 5000 by default\n"
+                  << "  --load=<fraction>      ratio of the mean service time to the mean time between arrivals,\n"
+                  << "                         0.5 by default\n";
+    }
+
+    //! Writes output of a mode to the requested file or to stdout
+    template<typename Writer>
+    void write_output(const Settings &settings, Writer writer) {
+        if (settings.outFile.empty()) {
+            writer(std::cout);
+        }
+        else {
+            std::ofstream out(settings.outFile);
+            writer(out);
+        }
+    }
+
+    std::vector<CaseResult> run_cases(const std::vector<const Case *> &cases, const Options &options) {
+#ifndef NDEBUG
+        std::cerr << "***WARNING*** benchmark was built with assertions enabled, timings are not representative\n";
+#endif
+        std::vector<CaseResult> results;
+        for (auto c : cases) {
+            std::cerr << c->name() << std::flush;
+            results.push_back(measure(*c, options));
+            std::cerr << "  " << results.back().median() << " ns\n";
+        }
+        return results;
+    }
+
+    //! Lists available hardware counters for the context of a run
+    std::string perf_description(const PerfCounters *perf) {
+        if (perf == nullptr) {
+            return "disabled";
+        }
+        if (!perf->available()) {
+            return "unavailable";
+        }
+        std::string result;
+        for (const auto &name : perf->names()) {
+            result += (result.empty() ? "" : ",") + name;
+        }
+        return result;
+    }
+
+    //! Default mode: measures selected cases and writes JSON results
+    int run_benchmarks(const Registry &registry, const Settings &settings) {
+        auto results = run_cases(registry.select(settings.options.filter), settings.options);
+
+        std::vector<std::pair<std::string, std::string>> context{
+                {"seed", std::to_string(settings.seed)},
+                {"repetitions", std::to_string(settings.options.repetitions)},
+                {"min_time", str(settings.options.minTime)},
+                {"compiler", __VERSION__},
+                {"isa", dispatch::isa_name(dispatch::active_isa())},
+                {"perf_counters", perf_description(settings.options.perf)},
+#ifdef NDEBUG
+                {"assertions", "off"},
+#else
+                {"assertions", "on"},
+#endif
+        };
+
+        write_output(settings, [&](std::ostream &out) { write_json(out, context, results); });
+        return 0;
+    }
+
+    //! Builds sorted values in a representation and measures its footprint
+    template<typename T, typename Impl>
+    Footprint footprint_of(const std::vector<std::uint64_t> &source) {
+        constexpr std::size_t BUILD_REPETITIONS = 3u;
+
+        Footprint result;
+        if (!source.empty() && source.back() >= gen::value_limit<T>()) {
+            return result;
+        }
+        std::vector<T> values(source.begin(), source.end());
+        result.supported = true;
+        result.members = values.size();
+        for (std::size_t i = 0; i < values.size(); i++) {
+            result.ranges += i == 0 || values[i] != values[i - 1] + 1u;
+        }
+
+        bool rss = reset_peak_rss();
+        auto rssBefore = current_rss();
+        auto heapBefore = allocation_counters().liveBytes;
+        auto start = clock::now();
+        auto set = Impl::build(values);
+        double best = std::chrono::duration<double, std::nano>(clock::now() - start).count();
+        result.heapBytes = std::uint64_t(allocation_counters().liveBytes - heapBefore);
+        if (rss && rssBefore >= 0) {
+            result.peakRssBytes = peak_rss() - rssBefore;
+        }
+        do_not_optimize(set);
+
+        for (std::size_t i = 1; i < BUILD_REPETITIONS; i++) {
+            start = clock::now();
+            auto again = Impl::build(values);
+            do_not_optimize(again);
+            best = std::min(best, std::chrono::duration<double, std::nano>(clock::now() - start).count());
+        }
+        result.buildNs = best;
+        return result;
+    }
+
+    //! Representation measured by the memory mode
+    struct MemoryRepresentation {
+        std::string impl;
+        std::string type;
+        std::function<Footprint(const std::vector<std::uint64_t> &)> measure;
+    };
+
+    template<typename T, template<typename> class Impl>
+    MemoryRepresentation memory_representation() {
+        return {Impl<T>::name, type_name<T>(), footprint_of<T, Impl<T>>};
+    }
+
+    //! Memory mode: builds every dataset family in every representation and writes a Markdown table
+    int run_memory(const Settings &settings) {
+        const std::vector<MemoryRepresentation> representations{
+                memory_representation<std::uint16_t, RangeVectorImpl>(),
+                memory_representation<std::uint32_t, RangeVectorImpl>(),
+                memory_representation<std::uint64_t, RangeVectorImpl>(),
+                memory_representation<std::uint32_t, StdSetImpl>(),
+                memory_representation<std::uint32_t, SortedVectorImpl>(),
+                memory_representation<std::uint32_t, BitmapImpl>(),
+        };
+
+        std::regex filter(settings.options.filter);
+        std::vector<FootprintRow> rows;
+        for (const auto &dataset : datasets<std::vector<std::uint64_t>>()) {
+            std::vector<std::uint64_t> values;
+            for (const auto &representation : representations) {
+                FootprintRow row{dataset.name, representation.impl, representation.type, {}};
+                auto name = "memory/impl:" + row.impl + "/dist:" + row.dist + "/type:" + row.type;
+                if (!std::regex_search(name, filter)) {
+                    continue;
+                }
+                if (values.empty()) {
+                    values = dataset.make(1u, settings.memoryRanges, settings.seed)[0];
+                }
+                std::cerr << name << std::flush;
+                row.footprint = measure_isolated([&] { return representation.measure(values); });
+                std::cerr << "  " << row.footprint.heapBytes << " bytes\n";
+                rows.push_back(std::move(row));
+            }
+        }
+
+        write_output(settings, [&](std::ostream &out) { write_footprint_table(out, rows); });
+        return 0;
+    }
+
+    //! Parameters of sweep inputs, every sweep varies one of them
+    struct SweepShape {
+        std::size_t inputs = 8u;
+        std::size_t ranges = 2000u;
+        double overlap = 0.5;
+        std::size_t threads = 1u;
+
+        void set(const std::string &param, double value) {
+            if (param == "inputs") {
+                inputs = std::size_t(value);
+            }
+            else if (param == "ranges") {
+                ranges = std::size_t(value);
+            }
+            else if (param == "overlap") {
+                overlap = value;
+            }
+            else {
+                threads = std::size_t(value);
+            }
+        }
+
+        std::vector<std::pair<std::string, std::string>> params() const {
+            return {{"inputs", std::to_string(inputs)}, {"ranges", std::to_string(ranges)},
+                    {"overlap", str(overlap)}, {"threads", std::to_string(threads)}};
+        }
+    };
+
+    //! Values of a swept parameter, growing geometrically
+    std::vector<double> sweep_values(const std::string &param) {
+        std::vector<double> result;
+        if (param == "inputs") {
+            for (double n = 2; n <= 128; n *= 2) {
+                result.push_back(n);
+            }
+        }
+        else if (param == "ranges") {
+            for (double n = 500; n <= 64000; n *= 2) {
+                result.push_back(n);
+            }
+        }
+        else if (param == "overlap") {
+            for (double n = 1.0 / 64; n <= 1.0; n *= 2) {
+                result.push_back(n);
+            }
+        }
+        else if (param == "threads") {
+            for (double n = 1; n <= 16; n *= 2) {
+                result.push_back(n);
+            }
+        }
+        return result;
+    }
+
+    /*!
+     * Returns a body merging a correlated family of sets. With several threads every iteration runs the merge
+     * concurrently in each of them, including the thread start, so perfect scaling gives a constant time.
+     */
+    template<typename Merge>
+    Body sweep_body(const SweepShape &shape, std::uint64_t seed, Merge merge) {
+        return [=](State &state) {
+            std::mt19937_64 engine(seed);
+            auto sets = gen::correlated_family<IntegralRangeVector<std::uint32_t>>(engine, shape.inputs,
+                                                                                  shape.ranges, 8.0, 8.0,
+                                                                                  shape.overlap);
+            std::size_t words = 0u;
+            for (const auto &set : sets) {
+                words += set.getBase().size();
+            }
+            state.setItemsPerIteration(words * shape.threads);
+
+            for (auto _ : state) {
+                if (shape.threads == 1u) {
+                    auto result = merge(sets);
+                    do_not_optimize(result);
+                    continue;
+                }
+                std::vector<std::thread> threads;
+                for (std::size_t t = 0; t < shape.threads; t++) {
+                    threads.emplace_back([&] {
+                        auto result = merge(sets);
+                        do_not_optimize(result);
+                    });
+                }
+                for (auto &thread : threads) {
+                    thread.join();
+                }
+            }
+        };
+    }
+
+    //! Sweep mode: measures merges over geometrically growing values of a parameter and fits complexity curves
+    int run_sweep(const Settings &settings) {
+        auto values = sweep_values(settings.sweep);
+        if (values.empty()) {
+            std::cerr << "Unknown sweep parameter " << settings.sweep
+                      << ", expected inputs, ranges, overlap or threads\n";
+            return 1;
+        }
+
+        typedef IntegralRangeVector<std::uint32_t> Set;
+        typedef std::function<Set(const std::vector<Set> &)> Merge;
+        const std::vector<std::pair<std::string, Merge>> operations{
+                {"intersect_ranges", [](const std::vector<Set> &sets) { return intersect_ranges(sets); }},
+                {"unite_ranges", [](const std::vector<Set> &sets) { return unite_ranges(sets); }},
+        };
+
+        std::vector<Sweep> sweeps;
+        for (const auto &operation : operations) {
+            Sweep sweep{operation.first, settings.sweep, {}, values, {}, {}};
+            for (auto value : values) {
+                SweepShape shape;
+                shape.set(settings.sweep, value);
+                Case c{operation.first, shape.params(), sweep_body(shape, settings.seed, operation.second)};
+                std::cerr << c.name() << std::flush;
+                sweep.results.push_back(measure(c, settings.options));
+                std::cerr << "  " << sweep.results.back().median() << " ns\n";
+            }
+            for (auto &param : SweepShape().params()) {
+                if (param.first != settings.sweep) {
+                    sweep.fixed.push_back(param);
+                }
+            }
+
+            std::vector<double> times;
+            for (const auto &result : sweep.results) {
+                times.push_back(result.median());
+            }
+            sweep.fits = fit_complexity(values, times);
+            sweep.exponent = fit_exponent(values, times);
+            std::fprintf(stderr, "%s over %s: best fit %s (rms error %.1f%%), next %s (%.1f%%), power law n^%.2f\n",
+                         operation.first.c_str(), settings.sweep.c_str(), sweep.fits[0].name.c_str(),
+                         100.0 * sweep.fits[0].error, sweep.fits[1].name.c_str(), 100.0 * sweep.fits[1].error,
+                         sweep.exponent);
+            sweeps.push_back(std::move(sweep));
+        }
+
+        std::vector<std::pair<std::string, std::string>> context{
+                {"seed", std::to_string(settings.seed)},
+                {"repetitions", std::to_string(settings.options.repetitions)},
+                {"min_time", str(settings.options.minTime)},
+                {"compiler", __VERSION__},
+                {"isa", dispatch::isa_name(dispatch::active_isa())},
+                {"hardware_threads", std::to_string(std::thread::hardware_concurrency())},
+        };
+        write_output(settings, [&](std::ostream &out) { write_sweeps(out, context, sweeps); });
+        return 0;
+    }
+
+    //! Operation issued by the latency mode, gets a random engine to pick its inputs
+    struct LatencyOperation {
+        std::string name;
+        std::function<void(std::mt19937_64 &)> issue;
+    };
+
+    //! Condition the latency mode issues operations under, prepare runs between operations and is not measured
+    struct LatencyCondition {
+        std::string name;
+        std::function<void(std::mt19937_64 &)> prepare;
+    };
+
+    //! Size of the last level cache in bytes or a conservative guess if it is not known
+    std::size_t last_level_cache() {
+        long size = -1;
+#ifdef _SC_LEVEL3_CACHE_SIZE
+        size = sysconf(_SC_LEVEL3_CACHE_SIZE);
+#endif
+        return size > 0 ? std::size_t(size) : std::size_t(32u) << 20u;
+    }
+
+    std::uint64_t now_ns() {
+        return std::uint64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now().time_since_epoch()).count());
+    }
+
+    /*!
+     * Issues operations at exponentially distributed arrival times, so that they arrive like independent requests.
+     * The response time of an operation that arrives while an earlier one is running includes the wait, which
+     * closed-loop timing would hide. Time spent preparing a condition shifts the schedule instead of being counted.
+     */
+    LatencyResult measure_latency(const LatencyOperation &operation, const LatencyCondition &condition,
+                                  std::size_t samples, double meanGapNs, std::uint64_t seed) {
+        LatencyResult result{operation.name, condition.name, meanGapNs, 0u, {}, {}};
+        std::mt19937_64 engine(seed);
+        std::exponential_distribution<double> gap(1.0 / meanGapNs);
+
+        double arrival = double(now_ns());
+        for (std::size_t i = 0; i < samples; i++) {
+            std::uint64_t prepared = now_ns();
+            condition.prepare(engine);
+            arrival += double(now_ns() - prepared) + gap(engine);
+            auto scheduled = std::uint64_t(arrival);
+            std::uint64_t start = now_ns();
+            while (start < scheduled) {
+                start = now_ns();
+            }
+
+            auto allocations = allocation_counters().allocations;
+            operation.issue(engine);
+            std::uint64_t end = now_ns();
+            result.allocations += allocation_counters().allocations - allocations;
+
+            result.service.record(end - start);
+            result.response.record(end - scheduled);
+        }
+        return result;
+    }
+
+    //! Latency mode: issues single operations under several conditions and writes latency histograms
+    int run_latency(const Settings &settings) {
+        typedef IntegralRangeVector<std::uint32_t> Set;
+        std::mt19937_64 engine(settings.seed);
+
+        // Mostly ranges, so that lookups take the block decoding path of contains() rather than hitting singletons
+        auto lookupSet = gen::with_density<Set>(engine, 100000u, 0.5, 8.0);
+        auto lookupLimit = lookupSet.getBase().empty() ? 1u : lookupSet.getBase().back() & ~Set::mask;
+        std::vector<std::vector<Set>> smallSets;
+        for (std::size_t i = 0; i < 64u; i++) {
+            smallSets.push_back(gen::correlated_family<Set>(engine, 2u, 64u, 8.0, 8.0, 0.5));
+        }
+        auto largeSets = gen::correlated_family<Set>(engine, 8u, 5000u, 8.0, 8.0, 0.5);
+
+        const std::vector<LatencyOperation> operations{
+                {"contains", [&](std::mt19937_64 &e) {
+                    std::uniform_int_distribution<std::uint32_t> value(0u, lookupLimit);
+                    do_not_optimize(lookupSet.contains(value(e)));
+                }},
+                {"small_intersect", [&](std::mt19937_64 &e) {
+                    do_not_optimize(intersect_ranges(smallSets[e() % smallSets.size()]));
+                }},
+                {"large_union", [&](std::mt19937_64 &) { do_not_optimize(unite_ranges(largeSets)); }},
+        };
+
+        // Cold: every cache line of a buffer twice the last level cache is written before an operation
+        std::vector<unsigned char> flush(2u * last_level_cache());
+        // Churn: blocks of random sizes up to 1 MiB are replaced, so that the allocator splits, coalesces and
+        // returns memory to the system between operations
+        std::vector<std::unique_ptr<unsigned char[]>> blocks(256u);
+        const std::vector<LatencyCondition> conditions{
+                {"warm", [](std::mt19937_64 &) {}},
+                {"cold", [&](std::mt19937_64 &) {
+                    for (std::size_t i = 0; i < flush.size(); i += 64u) {
+                        flush[i]++;
+                    }
+                    clobber_memory();
+                }},
+                {"churn", [&](std::mt19937_64 &e) {
+                    std::uniform_real_distribution<double> exponent(4.0, 20.0);
+                    for (std::size_t i = 0; i < 16u; i++) {
+                        auto size = std::size_t(std::exp2(exponent(e)));
+                        auto &block = blocks[e() % blocks.size()];
+                        block.reset(new unsigned char[size]);
+                        block[0] = 1u;
+                    }
+                    clobber_memory();
+                }},
+        };
+
+        std::regex filter(settings.options.filter);
+        std::vector<LatencyResult> results;
+        for (const auto &operation : operations) {
+            for (const auto &condition : conditions) {
+                auto name = "latency/op:" + operation.name + "/condition:" + condition.name;
+                if (!std::regex_search(name, filter)) {
+                    continue;
+                }
+                // The arrival rate keeps the same utilization under every condition, a slower condition would
+                // otherwise overload the schedule of a faster one and the queue would grow without bound
+                auto calibration = measure_latency(operation, condition, 100u, 1.0, settings.seed);
+                double meanGapNs = std::max(calibration.service.mean(), 1.0) / settings.load;
+
+                std::cerr << name << std::flush;
+                results.push_back(measure_latency(operation, condition, settings.latencySamples, meanGapNs,
+                                                  settings.seed));
+                std::cerr << "  p99 " << results.back().service.percentile(0.99) << " ns\n";
+            }
+        }
+
+        write_latency_table(std::cerr, results);
+        std::vector<std::pair<std::string, std::string>> context{
+                {"seed", std::to_string(settings.seed)},
+                {"samples", std::to_string(settings.latencySamples)},
+                {"load", str(settings.load)},
+                {"flush_bytes", std::to_string(flush.size())},
+                {"compiler", __VERSION__},
+                {"isa", dispatch::isa_name(dispatch::active_isa())},
+        };
+        write_output(settings, [&](std::ostream &out) { write_latency_json(out, context, results); });
+        return 0;
+    }
+
+    //! Index mode: runs a query mix against a synthetic inverted index back to back
+    int run_index(const Settings &settings) {
+        constexpr std::size_t PAGE_SIZE = 10u;
+        std::mt19937_64 engine(settings.seed);
+
+        CorpusShape shape;
+        std::cerr << "Building " << shape.terms << " posting lists over " << shape.documents << " documents\n";
+        auto corpus = make_corpus(engine, shape);
+        std::uint64_t words = 0u;
+        for (const auto &postings : corpus) {
+            words += postings.getBase().size();
+        }
+        auto queries = make_queries(engine, corpus.size(), settings.queries);
+
+        // Warm-up pass over a part of the mix, so that the first measured queries do not fault in the corpus
+        for (std::size_t i = 0; i < std::min<std::size_t>(queries.size(), 1000u); i++) {
+            do_not_optimize(run_query(corpus, queries[i], PAGE_SIZE));
+        }
+
+        std::vector<IndexResult> results{{"all", 0.0, {}}, {"and", 0.0, {}}, {"or", 0.0, {}},
+                                         {"and_not", 0.0, {}}};
+        std::uint64_t start = now_ns();
+        for (const auto &query : queries) {
+            std::uint64_t begin = now_ns();
+            auto result = run_query(corpus, query, PAGE_SIZE);
+            std::uint64_t latency = now_ns() - begin;
+            do_not_optimize(result);
+
+            for (auto &r : results) {
+                if (r.kind == "all" || r.kind == query.kind) {
+                    r.latency.record(latency);
+                    r.meanMatches += double(result.matches);
+                }
+            }
+        }
+        double seconds = double(now_ns() - start) * 1e-9;
+        for (auto &r : results) {
+            r.meanMatches /= std::max(1.0, double(r.latency.count()));
+        }
+
+        std::fprintf(stderr, "%zu queries in %.3f s, %.0f queries/s\n", queries.size(), seconds,
+                     double(queries.size()) / std::max(seconds, 1e-9));
+        for (const auto &r : results) {
+            std::fprintf(stderr, "%-8s %6llu queries, mean %9.0f matches, p50 %9llu ns, p99 %9llu ns, "
+                                 "p99.9 %9llu ns, max %9llu ns\n", r.kind.c_str(),
+                         (unsigned long long) r.latency.count(), r.meanMatches,
+                         (unsigned long long) r.latency.percentile(0.5),
+                         (unsigned long long) r.latency.percentile(0.99),
+                         (unsigned long long) r.latency.percentile(0.999), (unsigned long long) r.latency.max());
+        }
+
+        std::vector<std::pair<std::string, std::string>> context{
+                {"seed", std::to_string(settings.seed)},
+                {"documents", std::to_string(shape.documents)},
+                {"terms", std::to_string(shape.terms)},
+                {"posting_words", std::to_string(words)},
+                {"page_size", std::to_string(PAGE_SIZE)},
+                {"compiler", __VERSION__},
+                {"isa", dispatch::isa_name(dispatch::active_isa())},
+        };
+        write_output(settings, [&](std::ostream &out) { write_index_json(out, context, seconds, results); });
+        return 0;
+    }
+
+    //! Comparison mode: reruns cases of a baseline result and tests the differences for significance
+    int run_comparison(const Registry &registry, const Settings &settings, const Baseline &baseline) {
+        std::vector<const Case *> cases;
+        std::vector<std::string> missing;
+        // Cases without baseline samples cannot be compared and are reported as missing
+        for (auto c : registry.select(settings.options.filter)) {
+            auto samples = baseline.samples.find(c->name());
+            if (samples != baseline.samples.end() && !samples->second.empty()) {
+                cases.push_back(c);
+            }
+        }
+        for (const auto &entry : baseline.samples) {
+            if (std::none_of(cases.begin(), cases.end(), [&](const Case *c) { return c->name() == entry.first; })) {
+                missing.push_back(entry.first);
+            }
+        }
+
+        std::vector<Comparison> comparisons;
+        for (const auto &result : run_cases(cases, settings.options)) {
+            auto name = result.source->name();
+            if (result.samples.empty()) {
+                missing.push_back(name);
+                continue;
+            }
+            comparisons.push_back(compare_samples(name, baseline.samples.at(name), result.samples,
+                                                  settings.threshold));
+        }
+
+        bool regression = false;
+        for (const auto &c : comparisons) {
+            std::fprintf(stderr, "%-80s %8.3fx [%6.3f, %6.3f] p=%.4f %s\n", c.name.c_str(), c.speedup, c.low,
+                         c.high, c.pValue, c.verdict.c_str());
+            regression |= c.verdict == "slower";
+        }
+
+        write_output(settings, [&](std::ostream &out) {
+            write_comparisons(out, comparisons, missing, settings.threshold);
+        });
+        return regression ? 2 : 0;
+    }
+
+}
+
+int main(int argc, char **argv) {
+    Settings settings;
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        auto value = [&](const char *prefix) -> const char * {
+            auto len = std::strlen(prefix);
+            return arg.compare(0, len, prefix) == 0 ? argv[i] + len : nullptr;
+        };
+
+        if (auto v = value("--filter=")) {
+            settings.options.filter = v;
+        }
+        else if (auto v = value("--min-time=")) {
+            settings.options.minTime = std::stod(v);
+        }
+        else if (auto v = value("--repetitions=")) {
+            settings.options.repetitions = std::max<std::size_t>(1u, std::stoul(v));
+            settings.repetitionsSet = true;
+        }
+        else if (auto v = value("--seed=")) {
+            settings.seed = std::stoull(v);
+            settings.seedSet = true;
+        }
+        else if (auto v = value("--out=")) {
+            settings.outFile = v;
+        }
+        else if (auto v = value("--baseline=")) {
+            settings.baselineFile = v;
+        }
+        else if (auto v = value("--threshold=")) {
+            settings.threshold = std::stod(v);
+        }
+        else if (arg == "--list") {
+            settings.list = true;
+        }
+        else if (arg == "--memory") {
+            settings.memory = true;
+        }
+        else if (auto v = value("--ranges=")) {
+            settings.memoryRanges = std::max<std::size_t>(1u, std::stoul(v));
+        }
+        else if (auto v = value("--sweep=")) {
+            settings.sweep = v;
+        }
+        else if (auto v = value("--trace=")) {
+            settings.traceFile = v;
+        }
+        else if (auto v = value("--record=")) {
+            settings.recordFile = v;
+        }
+        else if (arg == "--index") {
+            settings.index = true;
+        }
+        else if (auto v = value("--queries=")) {
+            settings.queries = std::max<std::size_t>(1u, std::stoul(v));
+        }
+        else if (arg == "--latency") {
+            settings.latency = true;
+        }
+        else if (auto v = value("--samples=")) {
+            settings.latencySamples = std::max<std::size_t>(1u, std::stoul(v));
+        }
+        else if (auto v = value("--load=")) {
+            settings.load = std::min(std::max(std::stod(v), 0.01), 1.0);
+        }
+        else if (arg == "--no-perf") {
+            settings.perf = false;
+        }
+        else {
+            usage(argv[0]);
+            return arg == "--help" ? 0 : 1;
+        }
+    }
+
+    Baseline baseline;
+    if (!settings.baselineFile.empty()) {
+        std::ifstream in(settings.baselineFile);
+        if (!in) {
+            std::cerr << "Cannot open " << settings.baselineFile << '\n';
+            return 1;
+        }
+        try {
+            baseline = read_baseline(in);
+        }
+        catch (const std::exception &e) {
+            std::cerr << settings.baselineFile << ": " << e.what() << '\n';
+            return 1;
+        }
+
+        // Inputs have to be generated exactly as they were for the baseline
+        if (!settings.seedSet && baseline.context.count("seed")) {
+            settings.seed = std::stoull(baseline.context.at("seed"));
+        }
+        if (!settings.repetitionsSet) {
+            settings.options.repetitions = 10u;
+        }
+    }
+
+    if (settings.memory) {
+        return run_memory(settings);
+    }
+    if (settings.latency) {
+        return run_latency(settings);
+    }
+    if (settings.index) {
+        return run_index(settings);
+    }
+
+    std::unique_ptr<PerfCounters> perf;
+    if (settings.perf && !settings.list) {
+        perf = std::make_unique<PerfCounters>();
+        if (!perf->available()) {
+            std::cerr << "Hardware performance counters are not available, reporting timings only\n";
+        }
+        settings.options.perf = perf.get();
+    }
+
+    Registry registry;
+    register_width<std::uint16_t>(registry, settings.seed);
+    register_width<std::uint32_t>(registry, settings.seed);
+    register_width<std::uint64_t>(registry, settings.seed);
+    register_cursors<std::uint32_t>(registry, settings.seed);
+    register_cursors<std::uint64_t>(registry, settings.seed);
+    register_representation<std::uint32_t, RangeVectorImpl<std::uint32_t>>(registry, settings.seed);
+    register_representation<std::uint32_t, StdSetImpl<std::uint32_t>>(registry, settings.seed);
+    register_representation<std::uint32_t, SortedVectorImpl<std::uint32_t>>(registry, settings.seed);
+    register_representation<std::uint32_t, BitmapImpl<std::uint32_t>>(registry, settings.seed);
+
+    if (settings.list) {
+        for (auto c : registry.select(settings.options.filter)) {
+            std::cout << c->name() << '\n';
+        }
+        return 0;
+    }
+
+    if (!settings.traceFile.empty()) {
+        start_tracing();
+    }
+    std::ofstream recording;
+    if (!settings.recordFile.empty()) {
+        if (!record_enabled()) {
+            std::cerr << "Recording is not compiled in, rebuild with INTEGRALRANGE_RECORD\n";
+            return 1;
+        }
+        recording.open(settings.recordFile, std::ios::binary);
+        start_recording(recording);
+    }
+    int result;
+    if (!settings.sweep.empty()) {
+        result = run_sweep(settings);
+    }
+    else if (!settings.baselineFile.empty()) {
+        result = run_comparison(registry, settings, baseline);
+    }
+    else {
+        result = run_benchmarks(registry, settings);
+    }
+    if (!settings.traceFile.empty()) {
+        stop_tracing();
+        std::ofstream out(settings.traceFile);
+        write_chrome_trace(out);
+    }
+    if (!settings.recordFile.empty()) {
+        stop_recording();
+    }
+    return result;
+}
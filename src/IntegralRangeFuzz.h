@@ -0,0 +1,541 @@
+// Copyright 2019 Dmitry Valter
+// Copyright 2019 Sviatoslav Dmitriev
+// Distributed under the Boost Software License, Version 1.0.
+// See accompanying file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt
+
+#ifndef INTEGRALRANGE_INTEGRALRANGEFUZZ_H
+#define INTEGRALRANGE_INTEGRALRANGEFUZZ_H
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <iterator>
+#include <utility>
+#include <vector>
+
+#include "BitmapRangeVector.h"
+#include "IntegralRangeVector.h"
+#include "KeyedRangeVector.h"
+#include "RangeExpression.h"
+#include "RangeMerger.h"
+#include "StaticRangeSet.h"
+
+//! Aborts with a message if a condition does not hold, so that the fuzzer records the input as a crash
+#define INTEGRALRANGE_FUZZ_CHECK(condition)                                                          \
+    do {                                                                                             \
+        if (!(condition)) {                                                                          \
+            std::fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #condition);      \
+            std::abort();                                                                            \
+        }                                                                                            \
+    } while (false)
+
+namespace ranges::fuzz {
+
+    //! Range of 64-bit values used by the reference model
+    typedef std::pair<std::uint64_t, std::uint64_t> Range;
+
+    //! Consumes fuzzer input, returning zeroes once the input is exhausted
+    class FuzzInput {
+        const std::uint8_t *_data;
+        std::size_t _size;
+
+    public:
+        FuzzInput(const std::uint8_t *data, std::size_t size) : _data(data), _size(size) {}
+
+        //! Checks if the whole input was consumed
+        bool empty() const { return _size == 0u; }
+
+        //! Consumes a byte
+        std::uint8_t byte() {
+            if (_size == 0u) {
+                return 0u;
+            }
+            _size--;
+            return *_data++;
+        }
+
+        //! Consumes a little-endian integer of the given type
+        template<typename T>
+        T integral() {
+            T result = 0u;
+            for (std::size_t i = 0; i < sizeof(T); i++) {
+                result = T(result | T(T(byte()) << (8u * i)));
+            }
+            return result;
+        }
+
+        //! Consumes a length: mostly short, occasionally long so that both singletons and wide runs are covered
+        std::uint64_t length() {
+            std::uint8_t head = byte();
+            switch (head >> 6u) {
+                case 0:
+                case 1:
+                    return head & 0x7fu;
+                case 2:
+                    return ((head & 0x3fu) << 8u) | byte();
+                default:
+                    return integral<std::uint32_t>() >> (head & 0x1fu);
+            }
+        }
+    };
+
+    //! Longest decoded run, the reference model expands runs into values so they are kept short
+    constexpr std::uint64_t MAX_RUN = 1024u;
+
+    /*!
+     * Decodes a sorted list of disjoint ranges below a limit. Zero gaps are produced, so adjacent ranges that are
+     * not coalesced appear in the decoded list.
+     * @param input Fuzzer input
+     * @param limit Upper bound of range ends, exclusive since an end equal to the mask is not encodable
+     */
+    inline std::vector<Range> decode_ranges(FuzzInput &input, std::uint64_t limit) {
+        std::vector<Range> result;
+        std::size_t count = input.byte();
+        std::uint64_t position = input.length();
+        for (std::size_t i = 0; i < count; i++) {
+            std::uint64_t end = position + 1u + std::min(input.length(), MAX_RUN - 1u);
+            if (end >= limit || end <= position) {
+                break;
+            }
+            result.push_back({position, end});
+            position = end + input.length();
+        }
+        return result;
+    }
+
+    //! Expands ranges into the sorted list of their values
+    inline std::vector<std::uint64_t> model_values(const std::vector<Range> &ranges) {
+        std::vector<std::uint64_t> result;
+        for (const auto &range : ranges) {
+            for (auto value = range.first; value < range.second; value++) {
+                result.push_back(value);
+            }
+        }
+        return result;
+    }
+
+    //! Reference intersection of sorted value lists
+    inline std::vector<std::uint64_t> model_intersection(const std::vector<std::vector<std::uint64_t>> &sets) {
+        if (sets.empty()) {
+            return {};
+        }
+        auto result = sets[0];
+        for (std::size_t i = 1; i < sets.size(); i++) {
+            std::vector<std::uint64_t> next;
+            std::set_intersection(result.begin(), result.end(), sets[i].begin(), sets[i].end(),
+                                  std::back_inserter(next));
+            result.swap(next);
+        }
+        return result;
+    }
+
+    //! Reference union of sorted value lists
+    inline std::vector<std::uint64_t> model_union(const std::vector<std::vector<std::uint64_t>> &sets) {
+        std::vector<std::uint64_t> result;
+        for (const auto &set : sets) {
+            std::vector<std::uint64_t> next;
+            std::set_union(result.begin(), result.end(), set.begin(), set.end(), std::back_inserter(next));
+            result.swap(next);
+        }
+        return result;
+    }
+
+    //! Reference difference of sorted value lists: values of the first list that are not in any other list
+    inline std::vector<std::uint64_t> model_difference(const std::vector<std::vector<std::uint64_t>> &sets) {
+        if (sets.empty()) {
+            return {};
+        }
+        auto result = sets[0];
+        for (std::size_t i = 1; i < sets.size(); i++) {
+            std::vector<std::uint64_t> next;
+            std::set_difference(result.begin(), result.end(), sets[i].begin(), sets[i].end(),
+                                std::back_inserter(next));
+            result.swap(next);
+        }
+        return result;
+    }
+
+    //! Collects the values of a range container into 64-bit values
+    template<typename Cont>
+    std::vector<std::uint64_t> values_of(const Cont &cont) {
+        std::vector<std::uint64_t> result;
+        for (auto it = cont.begin(); it != cont.end(); ++it) {
+            for (std::uint64_t value = get_first(it); value < std::uint64_t(get_last(it)); value++) {
+                result.push_back(value);
+            }
+        }
+        return result;
+    }
+
+    /*!
+     * Checks that kernels of every instruction set the CPU supports agree with scalar loops
+     * @param words Canonical encoding
+     * @param values Values the encoding holds
+     */
+    template<typename T, typename Allocator1, typename Allocator2>
+    void check_kernels(const std::vector<T, Allocator1> &words, const std::vector<T, Allocator2> &values) {
+        std::size_t run = values.empty() ? 0u : 1u;
+        while (run < values.size() && values[run] == T(values[0] + T(run))) {
+            run++;
+        }
+        T middle = values.empty() ? T(0u) : values[values.size() / 2u];
+        // Blocks ending in the middle of the words, where a range may be split
+        std::size_t blockSize = std::min(words.size(), words.size() / 2u + 1u);
+        std::vector<T> begins(blockSize), ends(blockSize), expectedBegins(blockSize), expectedEnds(blockSize);
+        dispatch::DecodedBlock expectedBlock = dispatch::decode_block_generic(words.data(), blockSize,
+                                                                              expectedBegins.data(),
+                                                                              expectedEnds.data());
+        auto notGreater = std::size_t(std::count_if(words.begin(), words.end(), [middle](T word) {
+            return T(word & T(~dispatch::word_mask<T>())) <= middle;
+        }));
+
+        for (std::size_t i = 0; i <= std::size_t(dispatch::detect_isa()); i++) {
+            const auto &kernels = dispatch::kernels_for<T>(dispatch::Isa(i));
+            INTEGRALRANGE_FUZZ_CHECK(kernels.rangeLength(words.data(), words.size()) == values.size());
+            INTEGRALRANGE_FUZZ_CHECK(kernels.countNotGreater(words.data(), words.size(), middle) == notGreater);
+            dispatch::DecodedBlock block = kernels.decodeBlock(words.data(), blockSize, begins.data(),
+                                                               ends.data());
+            INTEGRALRANGE_FUZZ_CHECK(block.ranges == expectedBlock.ranges && block.words == expectedBlock.words);
+            INTEGRALRANGE_FUZZ_CHECK(std::equal(begins.begin(), begins.begin() + std::ptrdiff_t(block.ranges),
+                                                expectedBegins.begin()));
+            INTEGRALRANGE_FUZZ_CHECK(std::equal(ends.begin(), ends.begin() + std::ptrdiff_t(block.ranges),
+                                                expectedEnds.begin()));
+            if (!values.empty()) {
+                INTEGRALRANGE_FUZZ_CHECK(kernels.runLength(values.data(), values.size()) == run);
+                std::vector<T> filled(run);
+                kernels.fillRun(filled.data(), values[0], run);
+                INTEGRALRANGE_FUZZ_CHECK(std::equal(filled.begin(), filled.end(), values.begin()));
+            }
+        }
+    }
+
+    /*!
+     * Checks that a container is canonical: ranges are non-empty, sorted and separated by gaps
+     * @param cont Range container
+     * @param expected Values the container has to hold
+     */
+    template<typename T, typename Allocator>
+    void check_container(const IntegralRangeVector<T, Allocator> &cont, const std::vector<std::uint64_t> &expected) {
+        std::size_t ranges = 0u;
+        std::uint64_t previousEnd = 0u;
+        for (const auto &range : cont) {
+            INTEGRALRANGE_FUZZ_CHECK(range.first < range.second);
+            INTEGRALRANGE_FUZZ_CHECK(ranges == 0u || previousEnd < range.first);
+            previousEnd = range.second;
+            ranges++;
+        }
+
+        INTEGRALRANGE_FUZZ_CHECK(values_of(cont) == expected);
+        INTEGRALRANGE_FUZZ_CHECK(cont.length() == expected.size());
+        INTEGRALRANGE_FUZZ_CHECK(cont.empty() == expected.empty());
+
+        auto toVector = cont.toVector();
+        INTEGRALRANGE_FUZZ_CHECK(std::equal(toVector.begin(), toVector.end(), expected.begin(), expected.end()));
+
+        for (std::uint64_t value : expected) {
+            INTEGRALRANGE_FUZZ_CHECK(cont.contains(T(value)));
+            for (std::uint64_t neighbour : {value - 1u, value + 1u}) {
+                if (neighbour < IntegralRangeVector<T, Allocator>::mask) {
+                    bool stored = std::binary_search(expected.begin(), expected.end(), neighbour);
+                    INTEGRALRANGE_FUZZ_CHECK(cont.contains(T(neighbour)) == stored);
+                }
+            }
+        }
+
+        auto stats = cont.analyze();
+        INTEGRALRANGE_FUZZ_CHECK(stats.ranges == ranges);
+        INTEGRALRANGE_FUZZ_CHECK(stats.length == expected.size());
+
+        INTEGRALRANGE_FUZZ_CHECK(IntegralRangeVector<T>::fromVector(toVector).getBase() ==
+                                 std::vector<T>(cont.getBase().begin(), cont.getBase().end()));
+        check_kernels(cont.getBase(), toVector);
+    }
+
+    /*!
+     * Checks that constexpr merges of the first two sets produce the encoding of the run-time merges
+     * @param rangeSets Sets checked against the reference model
+     */
+    template<typename T>
+    void check_static_merges(const std::vector<IntegralRangeVector<T>> &rangeSets) {
+        constexpr std::size_t CAPACITY = 1024u;
+        if (rangeSets.size() < 2u || rangeSets[0].getBase().size() > CAPACITY ||
+            rangeSets[1].getBase().size() > CAPACITY) {
+            return;
+        }
+
+        StaticRangeSet<T, CAPACITY> first, second;
+        for (const auto &range : rangeSets[0]) {
+            first.push_back(range);
+        }
+        for (const auto &range : rangeSets[1]) {
+            second.push_back(range);
+        }
+        auto words = [](const auto &set) { return std::vector<T>(set.data(), set.data() + set.size()); };
+        std::vector<IntegralRangeVector<T>> pair{rangeSets[0], rangeSets[1]};
+
+        INTEGRALRANGE_FUZZ_CHECK(words(first) == rangeSets[0].getBase());
+        INTEGRALRANGE_FUZZ_CHECK(words(unite(first, second)) == unite_ranges(pair).getBase());
+        INTEGRALRANGE_FUZZ_CHECK(words(intersect(first, second)) == intersect_ranges(pair).getBase());
+        INTEGRALRANGE_FUZZ_CHECK(words(subtract(first, second)) == subtract_ranges(pair).getBase());
+
+        // Generic merges fill a set of the operand type, which has room for the largest possible difference
+        std::vector<StaticRangeSet<T, 3u * CAPACITY>> sets{with_capacity<3u * CAPACITY>(first),
+                                                           with_capacity<3u * CAPACITY>(second)};
+        INTEGRALRANGE_FUZZ_CHECK(words(unite_ranges(sets)) == unite_ranges(pair).getBase());
+        INTEGRALRANGE_FUZZ_CHECK(words(intersect_ranges(sets)) == intersect_ranges(pair).getBase());
+        INTEGRALRANGE_FUZZ_CHECK(words(subtract_ranges(sets)) == subtract_ranges(pair).getBase());
+        for (const auto &range : rangeSets[0]) {
+            INTEGRALRANGE_FUZZ_CHECK(first.contains(range.first) && first.contains(T(range.second - 1u)));
+            INTEGRALRANGE_FUZZ_CHECK(first.contains(range.second) == rangeSets[0].contains(range.second));
+        }
+    }
+
+    /*!
+     * Checks that fused expressions over the first sets match the run-time merges
+     * @param rangeSets Sets checked against the reference model
+     */
+    template<typename T>
+    void check_expressions(const std::vector<IntegralRangeVector<T>> &rangeSets) {
+        typedef IntegralRangeVector<T> Cont;
+        const Cont &a = rangeSets[0];
+        const Cont &b = rangeSets[1 % rangeSets.size()];
+        const Cont &c = rangeSets[2 % rangeSets.size()];
+
+        Cont all;
+        all.push_back({T(0u), T(expr::Leaf<Cont>::LIMIT)});
+
+        INTEGRALRANGE_FUZZ_CHECK(Cont(a | b).getBase() == unite_ranges(std::vector<Cont>{a, b}).getBase());
+        INTEGRALRANGE_FUZZ_CHECK(Cont(a & b).getBase() == intersect_ranges(std::vector<Cont>{a, b}).getBase());
+        INTEGRALRANGE_FUZZ_CHECK(Cont(a - b).getBase() == subtract_ranges(std::vector<Cont>{a, b}).getBase());
+        INTEGRALRANGE_FUZZ_CHECK(Cont(~a).getBase() == subtract_ranges(std::vector<Cont>{all, a}).getBase());
+        INTEGRALRANGE_FUZZ_CHECK(Cont(~~a).getBase() == a.getBase());
+
+        Cont expected = subtract_ranges(std::vector<Cont>{intersect_ranges(std::vector<Cont>{
+                unite_ranges(std::vector<Cont>{a, b}), c}), b});
+        INTEGRALRANGE_FUZZ_CHECK(Cont((a | b) & c & ~b).getBase() == expected.getBase());
+        INTEGRALRANGE_FUZZ_CHECK(Cont(~(~a | ~b)).getBase() == intersect_ranges(std::vector<Cont>{a, b}).getBase());
+    }
+
+    /*!
+     * Checks that bitmaps of narrow types hold the values of the range vectors and merge like the reference model
+     * @param rangeSets Sets checked against the reference model
+     * @param intersection Expected intersection of the sets
+     * @param union_ Expected union of the sets
+     * @param difference Expected difference of the sets
+     */
+    template<typename T>
+    void check_bitmaps(const std::vector<IntegralRangeVector<T>> &rangeSets,
+                       const std::vector<std::uint64_t> &intersection, const std::vector<std::uint64_t> &union_,
+                       const std::vector<std::uint64_t> &difference) {
+        typedef BitmapRangeVector<T> Bitmap;
+        std::vector<Bitmap> bitmaps(rangeSets.begin(), rangeSets.end());
+        for (std::size_t i = 0; i < rangeSets.size(); i++) {
+            INTEGRALRANGE_FUZZ_CHECK(std::equal(bitmaps[i].begin(), bitmaps[i].end(),
+                                                rangeSets[i].begin(), rangeSets[i].end()));
+            INTEGRALRANGE_FUZZ_CHECK(bitmaps[i] == Bitmap(rangeSets[i].getBase()));
+            INTEGRALRANGE_FUZZ_CHECK(bitmaps[i].length() == rangeSets[i].length());
+            INTEGRALRANGE_FUZZ_CHECK(bitmaps[i].toVector() == rangeSets[i].toVector());
+            INTEGRALRANGE_FUZZ_CHECK((~bitmaps[i]).length() + bitmaps[i].length() == Bitmap::UNIVERSE - 1u);
+            for (std::size_t isa = 0; isa <= std::size_t(dispatch::detect_isa()); isa++) {
+                auto countBits = dispatch::kernels_for<T>(dispatch::Isa(isa)).countBits;
+                INTEGRALRANGE_FUZZ_CHECK(countBits(bitmaps[i].getBase().data(), Bitmap::WORDS) ==
+                                         rangeSets[i].length());
+            }
+        }
+
+        INTEGRALRANGE_FUZZ_CHECK(values_of(intersect_ranges(bitmaps)) == intersection);
+        INTEGRALRANGE_FUZZ_CHECK(values_of(unite_ranges(bitmaps)) == union_);
+        INTEGRALRANGE_FUZZ_CHECK(values_of(subtract_ranges(bitmaps)) == difference);
+    }
+
+    /*!
+     * Checks that signed values merge like the reference model: the sets are shifted to be centred on zero
+     * @param sets Decoded input sets, below 2^31
+     * @param intersection Expected intersection of the sets
+     * @param union_ Expected union of the sets
+     * @param difference Expected difference of the sets
+     */
+    inline void check_keys(const std::vector<std::vector<Range>> &sets,
+                           const std::vector<std::uint64_t> &intersection, const std::vector<std::uint64_t> &union_,
+                           const std::vector<std::uint64_t> &difference) {
+        typedef KeyedRangeVector<std::int32_t> Cont;
+        constexpr std::int64_t SHIFT = std::int64_t(1) << 30;
+        auto shifted = [](std::uint64_t value) { return std::int32_t(std::int64_t(value) - SHIFT); };
+        auto values = [&](const Cont &cont) {
+            std::vector<std::uint64_t> result;
+            for (auto value : cont.toVector()) {
+                result.push_back(std::uint64_t(std::int64_t(value) + SHIFT));
+            }
+            return result;
+        };
+
+        std::vector<Cont> keyed(sets.size());
+        for (std::size_t i = 0; i < sets.size(); i++) {
+            for (const auto &range : sets[i]) {
+                keyed[i].push_back({shifted(range.first), shifted(range.second)});
+            }
+            for (const auto &range : sets[i]) {
+                INTEGRALRANGE_FUZZ_CHECK(keyed[i].contains(shifted(range.first)));
+                INTEGRALRANGE_FUZZ_CHECK(keyed[i].contains(shifted(range.second - 1u)));
+            }
+        }
+
+        INTEGRALRANGE_FUZZ_CHECK(values(intersect_ranges(keyed)) == intersection);
+        INTEGRALRANGE_FUZZ_CHECK(values(unite_ranges(keyed)) == union_);
+        INTEGRALRANGE_FUZZ_CHECK(values(subtract_ranges(keyed)) == difference);
+    }
+
+    /*!
+     * Runs every merge implementation for a value type and compares results with the reference model
+     * @param sets Decoded input sets
+     */
+    template<typename T>
+    void check_merges(const std::vector<std::vector<Range>> &sets) {
+        std::vector<IntegralRangeVector<T>> rangeSets(sets.size());
+        std::vector<std::vector<T>> valueSets(sets.size());
+        std::vector<std::vector<std::pair<T, T>>> pairSets(sets.size());
+        std::vector<std::vector<std::uint64_t>> modelSets;
+
+        for (std::size_t i = 0; i < sets.size(); i++) {
+            for (const auto &range : sets[i]) {
+                std::pair<T, T> pair{T(range.first), T(range.second)};
+                // Alternate between range and per-value insertion to cover both push_back overloads
+                if ((range.first ^ range.second) & 1u) {
+                    rangeSets[i].push_back(pair);
+                }
+                else {
+                    for (auto value = pair.first; value < pair.second; value++) {
+                        rangeSets[i].push_back(value);
+                    }
+                }
+                insert_back(valueSets[i], pair);
+                pairSets[i].push_back(pair);
+            }
+            modelSets.push_back(model_values(sets[i]));
+            check_container(rangeSets[i], modelSets.back());
+        }
+
+        auto expectedIntersection = model_intersection(modelSets);
+        auto expectedUnion = model_union(modelSets);
+        auto expectedDifference = model_difference(modelSets);
+
+        auto intersected = intersect_ranges(rangeSets);
+        check_container(intersected, expectedIntersection);
+        OperationStats stats;
+        INTEGRALRANGE_FUZZ_CHECK(intersect_ranges(rangeSets, &stats) == intersected);
+
+        auto united = unite_ranges(rangeSets);
+        check_container(united, expectedUnion);
+        INTEGRALRANGE_FUZZ_CHECK(unite_ranges(rangeSets, &stats) == united);
+
+        auto subtracted = subtract_ranges(rangeSets);
+        check_container(subtracted, expectedDifference);
+        INTEGRALRANGE_FUZZ_CHECK(subtract_ranges(rangeSets, &stats) == subtracted);
+
+        INTEGRALRANGE_FUZZ_CHECK(values_of(intersect_ranges(valueSets)) == expectedIntersection);
+        INTEGRALRANGE_FUZZ_CHECK(values_of(unite_ranges(valueSets)) == expectedUnion);
+
+        INTEGRALRANGE_FUZZ_CHECK(values_of(intersect_ranges(pairSets)) == expectedIntersection);
+        INTEGRALRANGE_FUZZ_CHECK(values_of(unite_ranges(pairSets)) == expectedUnion);
+        INTEGRALRANGE_FUZZ_CHECK(values_of(subtract_ranges(valueSets)) == expectedDifference);
+        INTEGRALRANGE_FUZZ_CHECK(values_of(subtract_ranges(pairSets)) == expectedDifference);
+
+        check_static_merges(rangeSets);
+        check_expressions(rangeSets);
+        if constexpr (std::is_same_v<RangeSet<T>, BitmapRangeVector<T>>) {
+            check_bitmaps(rangeSets, expectedIntersection, expectedUnion, expectedDifference);
+        }
+        if constexpr (std::is_same_v<T, std::uint32_t>) {
+            check_keys(sets, expectedIntersection, expectedUnion, expectedDifference);
+        }
+
+        // Variadic merges read every input in a different representation
+        std::size_t second = 1u % sets.size(), third = 2u % sets.size();
+        std::vector<IntegralRangeVector<T>> triple{rangeSets[0], rangeSets[second], rangeSets[third]};
+        INTEGRALRANGE_FUZZ_CHECK(intersect(rangeSets[0], valueSets[second], pairSets[third]).getBase() ==
+                                 intersect_ranges(triple).getBase());
+        INTEGRALRANGE_FUZZ_CHECK(unite(rangeSets[0], valueSets[second], pairSets[third]).getBase() ==
+                                 unite_ranges(triple).getBase());
+    }
+
+    /*!
+     * Fuzz target for merges: decodes up to 8 sets and checks every merge implementation at every value width
+     * @param data Fuzzer input
+     * @param size Size of the input
+     */
+    inline void fuzz_merges(const std::uint8_t *data, std::size_t size) {
+        FuzzInput input(data, size);
+        std::uint8_t header = input.byte();
+        std::size_t count = 1u + (header & 7u);
+
+        // The limit follows the narrowest width the sets are checked with
+        bool wide = header & 0x80u;
+        std::uint64_t limit = wide ? IntegralRangeVector<std::uint32_t>::mask
+                                   : IntegralRangeVector<std::uint16_t>::mask;
+
+        std::vector<std::vector<Range>> sets;
+        for (std::size_t i = 0; i < count; i++) {
+            sets.push_back(decode_ranges(input, limit));
+        }
+
+        if (!wide) {
+            check_merges<std::uint16_t>(sets);
+        }
+        check_merges<std::uint32_t>(sets);
+        check_merges<std::uint64_t>(sets);
+    }
+
+    /*!
+     * Fuzz target for the encoding: builds containers from raw encoded words, including non-coalesced
+     * encodings push_back never produces (adjacent ranges, two-word ranges of a single value), and checks
+     * iteration, length(), analyze() and merges against a reference decoding
+     * @param data Fuzzer input
+     * @param size Size of the input
+     */
+    template<typename T>
+    void fuzz_encoding(const std::uint8_t *data, std::size_t size) {
+        typedef IntegralRangeVector<T> Vector;
+        FuzzInput input(data, size);
+        auto ranges = decode_ranges(input, Vector::mask);
+
+        std::vector<T> words;
+        for (const auto &range : ranges) {
+            if (range.second - range.first == 1u && (input.byte() & 1u) == 0u) {
+                words.push_back(T(range.first));
+            }
+            else {
+                words.push_back(T(range.first | Vector::mask));
+                words.push_back(T(range.second | Vector::mask));
+            }
+        }
+
+        Vector raw(words);
+        auto expected = model_values(ranges);
+
+        std::size_t index = 0u;
+        for (const auto &range : raw) {
+            INTEGRALRANGE_FUZZ_CHECK(index < ranges.size());
+            INTEGRALRANGE_FUZZ_CHECK(range.first == ranges[index].first);
+            INTEGRALRANGE_FUZZ_CHECK(range.second == ranges[index].second);
+            index++;
+        }
+        INTEGRALRANGE_FUZZ_CHECK(index == ranges.size());
+        INTEGRALRANGE_FUZZ_CHECK(raw.length() == expected.size());
+        INTEGRALRANGE_FUZZ_CHECK(raw.analyze().ranges == ranges.size());
+        INTEGRALRANGE_FUZZ_CHECK(raw.analyze().length == expected.size());
+
+        // Merging with itself and with the canonical form canonicalizes the encoding
+        Vector canonical;
+        for (const auto &range : raw) {
+            canonical.push_back(range);
+        }
+        check_container(canonical, expected);
+        INTEGRALRANGE_FUZZ_CHECK(values_of(unite_ranges(std::vector<Vector>{raw})) == expected);
+        check_container(unite_ranges(std::vector<Vector>{raw, raw}), expected);
+        check_container(intersect_ranges(std::vector<Vector>{raw, canonical}), expected);
+    }
+
+}
+
+#endif // INTEGRALRANGE_INTEGRALRANGEFUZZ_H
@@ -0,0 +1,27 @@
+// Copyright 2019 Dmitry Valter
+// Copyright 2019 Sviatoslav Dmitriev
+// Distributed under the Boost Software License, Version 1.0.
+// See accompanying file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt
+
+#include "IntegralRangeFuzz.h"
+
+extern "C" int LLVMFuzzerTestOneInput(const std::uint8_t *data, std::size_t size) {
+    if (size == 0u) {
+        return 0;
+    }
+
+    switch (data[0] & 3u) {
+        case 0:
+            ranges::fuzz::fuzz_encoding<std::uint8_t>(data + 1, size - 1);
+            break;
+        case 1:
+            ranges::fuzz::fuzz_encoding<std::uint16_t>(data + 1, size - 1);
+            break;
+        case 2:
+            ranges::fuzz::fuzz_encoding<std::uint32_t>(data + 1, size - 1);
+            break;
+        default:
+            ranges::fuzz::fuzz_encoding<std::uint64_t>(data + 1, size - 1);
+    }
+    return 0;
+}
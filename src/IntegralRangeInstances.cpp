@@ -0,0 +1,22 @@
+// Copyright 2019 Dmitry Valter
+// Copyright 2019 Sviatoslav Dmitriev
+// Distributed under the Boost Software License, Version 1.0.
+// See accompanying file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt
+
+#include "IntegralRangeVector.h"
+#include "RangeMerger.h"
+
+// Explicit instantiations of the IntegralRange library. Translation units built with INTEGRALRANGE_EXTERN_TEMPLATES
+// see them as extern templates and link to these definitions instead of instantiating the containers and merges for
+// the standard unsigned types themselves. Being the only place these instances are compiled, this file can also be
+// built with its own optimization flags, see INTEGRALRANGE_INSTANCES_FLAGS. Instruction set flags do not belong
+// there: the linker may keep inline functions compiled here for the whole program, the kernels are dispatched at
+// run time instead.
+
+namespace ranges {
+
+    INTEGRALRANGE_VECTOR_INSTANCES()
+
+    INTEGRALRANGE_MERGE_INSTANCES()
+
+}
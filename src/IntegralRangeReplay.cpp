@@ -0,0 +1,331 @@
+// Copyright 2019 Dmitry Valter
+// Copyright 2019 Sviatoslav Dmitriev
+// Distributed under the Boost Software License, Version 1.0.
+// See accompanying file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <tuple>
+#include <vector>
+
+#include "BenchHarness.h"
+#include "BenchMemory.h"
+#include "IntegralRangeVector.h"
+#include "RangeMerger.h"
+#include "RangeRecorder.h"
+
+using namespace ranges;
+using namespace ranges::bench;
+
+// Replays a recording of merges and lookups made with INTEGRALRANGE_RECORD. Sets are rebuilt from the snapshots
+// of the recording, then its calls are replayed with the current library and their latencies are compared to the
+// recorded ones. Operands of merges are copied before a call is timed, so that latencies cover the call alone like
+// the recorded ones.
+
+namespace {
+
+    constexpr std::size_t OPERATIONS = 5u;
+
+    struct Settings {
+        std::string recordingFile;
+        std::size_t threads = 1u;
+        std::size_t repeat = 1u;
+        std::string outFile;
+    };
+
+    template<typename T>
+    using SetMap = std::map<std::uint64_t, IntegralRangeVector<T>>;
+
+    //! Sets of a recording for every word width
+    typedef std::tuple<SetMap<std::uint8_t>, SetMap<std::uint16_t>, SetMap<std::uint32_t>,
+            SetMap<std::uint64_t>> Sets;
+
+    //! Latencies of calls in nanoseconds, by operation
+    typedef std::array<std::vector<std::uint64_t>, OPERATIONS> Latencies;
+
+    template<typename T>
+    void add_set(Sets &sets, std::uint64_t fingerprint, const RecordedSnapshot &snapshot) {
+        std::vector<T> words(snapshot.words.begin(), snapshot.words.end());
+        std::get<SetMap<T>>(sets).emplace(fingerprint, IntegralRangeVector<T>(std::move(words)));
+    }
+
+    Sets rebuild_sets(const Recording &recording) {
+        Sets sets;
+        for (const auto &snapshot : recording.snapshots) {
+            switch (snapshot.second.width) {
+                case 1u:
+                    add_set<std::uint8_t>(sets, snapshot.first, snapshot.second);
+                    break;
+                case 2u:
+                    add_set<std::uint16_t>(sets, snapshot.first, snapshot.second);
+                    break;
+                case 4u:
+                    add_set<std::uint32_t>(sets, snapshot.first, snapshot.second);
+                    break;
+                default:
+                    add_set<std::uint64_t>(sets, snapshot.first, snapshot.second);
+                    break;
+            }
+        }
+        return sets;
+    }
+
+    std::uint64_t now() {
+        return std::uint64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now().time_since_epoch()).count());
+    }
+
+    //! Replays a call and returns its latency
+    template<typename T>
+    std::uint64_t replay_call(const RecordedCall &call, const Sets &sets) {
+        const auto &map = std::get<SetMap<T>>(sets);
+        if (call.operation == RecordedOperation::contains) {
+            const auto &set = map.at(call.operands[0]);
+            auto value = T(call.value & ~IntegralRangeVector<T>::mask);
+            std::uint64_t start = now();
+            do_not_optimize(set.contains(value));
+            return now() - start;
+        }
+
+        std::vector<IntegralRangeVector<T>> operands;
+        operands.reserve(call.operands.size());
+        for (auto fingerprint : call.operands) {
+            operands.push_back(map.at(fingerprint));
+        }
+        std::uint64_t start = now();
+        if (call.operation == RecordedOperation::intersect) {
+            do_not_optimize(intersect_ranges(operands));
+        }
+        else if (call.operation == RecordedOperation::subtract) {
+            do_not_optimize(subtract_ranges(operands));
+        }
+        else {
+            do_not_optimize(unite_ranges(std::move(operands)));
+        }
+        return now() - start;
+    }
+
+    std::uint64_t replay_call(const RecordedCall &call, const Sets &sets) {
+        switch (call.width) {
+            case 1u:
+                return replay_call<std::uint8_t>(call, sets);
+            case 2u:
+                return replay_call<std::uint16_t>(call, sets);
+            case 4u:
+                return replay_call<std::uint32_t>(call, sets);
+            default:
+                return replay_call<std::uint64_t>(call, sets);
+        }
+    }
+
+    /*!
+     * Replays every step-th call starting from the first one
+     * @param recording Replayed recording
+     * @param sets Sets rebuilt from the recording
+     * @param first Position of the first replayed call
+     * @param step Distance between replayed calls
+     * @param repeat Amount of passes over the recording
+     * @param latencies Output of latencies
+     */
+    void replay_calls(const Recording &recording, const Sets &sets, std::size_t first, std::size_t step,
+                      std::size_t repeat, Latencies &latencies) {
+        for (std::size_t pass = 0; pass < repeat; pass++) {
+            for (std::size_t i = first; i < recording.calls.size(); i += step) {
+                const auto &call = recording.calls[i];
+                latencies[std::size_t(call.operation)].push_back(replay_call(call, sets));
+            }
+        }
+    }
+
+    //! Nearest-rank percentile of sorted samples
+    std::uint64_t percentile(const std::vector<std::uint64_t> &sorted, double fraction) {
+        if (sorted.empty()) {
+            return 0u;
+        }
+        auto rank = std::size_t(fraction * double(sorted.size()) + 0.999999);
+        return sorted[std::min(std::max<std::size_t>(rank, 1u), sorted.size()) - 1u];
+    }
+
+    //! Latency summary of an operation
+    struct Summary {
+        std::string operation;
+        std::uint64_t calls = 0u;
+        std::array<std::uint64_t, 3> recorded{};
+        std::array<std::uint64_t, 5> replayed{};
+    };
+
+    const double RECORDED_PERCENTILES[] = {0.5, 0.9, 0.99};
+    const double REPLAYED_PERCENTILES[] = {0.5, 0.9, 0.99, 0.999, 1.0};
+
+    std::vector<Summary> summarize(const Recording &recording, Latencies &replayed) {
+        Latencies recorded;
+        for (const auto &call : recording.calls) {
+            recorded[std::size_t(call.operation)].push_back(call.duration);
+        }
+
+        std::vector<Summary> result;
+        for (std::size_t op = 1; op < OPERATIONS; op++) {
+            if (replayed[op].empty()) {
+                continue;
+            }
+            std::sort(recorded[op].begin(), recorded[op].end());
+            std::sort(replayed[op].begin(), replayed[op].end());
+
+            Summary summary;
+            summary.operation = operation_name(RecordedOperation(op));
+            summary.calls = replayed[op].size();
+            for (std::size_t i = 0; i < summary.recorded.size(); i++) {
+                summary.recorded[i] = percentile(recorded[op], RECORDED_PERCENTILES[i]);
+            }
+            for (std::size_t i = 0; i < summary.replayed.size(); i++) {
+                summary.replayed[i] = percentile(replayed[op], REPLAYED_PERCENTILES[i]);
+            }
+            result.push_back(summary);
+        }
+        return result;
+    }
+
+    void write_table(std::ostream &out, const std::vector<Summary> &summaries) {
+        out << "| operation | calls | recorded p50 ns | recorded p90 ns | recorded p99 ns | p50 ns | p90 ns | p99 ns"
+               " | p99.9 ns | max ns |\n"
+               "|---|--:|--:|--:|--:|--:|--:|--:|--:|--:|\n";
+        for (const auto &s : summaries) {
+            out << "| " << s.operation << " | " << s.calls;
+            for (auto value : s.recorded) {
+                out << " | " << value;
+            }
+            for (auto value : s.replayed) {
+                out << " | " << value;
+            }
+            out << " |\n";
+        }
+    }
+
+    void write_summary_json(std::ostream &out, const Settings &settings, const Recording &recording,
+                            double seconds, std::uint64_t calls, const std::vector<Summary> &summaries) {
+        out << "{\n  \"context\": {\"recording\": ";
+        write_json_string(out, settings.recordingFile);
+        out << ", \"threads\": " << settings.threads << ", \"repeat\": " << settings.repeat << ", \"snapshots\": "
+            << recording.snapshots.size() << "},\n  \"seconds\": " << seconds << ", \"calls\": " << calls
+            << ", \"calls_per_second\": " << double(calls) / std::max(seconds, 1e-9) << ",\n  \"operations\": [";
+        for (std::size_t i = 0; i < summaries.size(); i++) {
+            const auto &s = summaries[i];
+            out << (i ? ",\n" : "\n") << "    {\"operation\": \"" << s.operation << "\", \"calls\": " << s.calls
+                << ", \"recorded_ns\": {\"p50\": " << s.recorded[0] << ", \"p90\": " << s.recorded[1]
+                << ", \"p99\": " << s.recorded[2] << "}, \"replayed_ns\": {\"p50\": " << s.replayed[0]
+                << ", \"p90\": " << s.replayed[1] << ", \"p99\": " << s.replayed[2] << ", \"p99.9\": "
+                << s.replayed[3] << ", \"max\": " << s.replayed[4] << "}}";
+        }
+        out << "\n  ]\n}\n";
+    }
+
+    void usage(const char *argv0) {
+        std::cerr << "Usage: " << argv0 << " <recording> [options]\n"
+                  << "  --threads=<n>          replay on n threads, calls are distributed round-robin\n"
+                  << "  --repeat=<n>           amount of passes over the recording, 1 by default\n"
+                  << "  --out=<file>           write JSON with the summary to the file\n";
+    }
+
+}
+
+int main(int argc, char **argv) {
+    Settings settings;
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        auto value = [&](const char *prefix) -> const char * {
+            auto len = std::strlen(prefix);
+            return arg.compare(0, len, prefix) == 0 ? argv[i] + len : nullptr;
+        };
+
+        try {
+            if (auto v = value("--threads=")) {
+                settings.threads = std::max<std::size_t>(1u, std::stoul(v));
+            }
+            else if (auto v = value("--repeat=")) {
+                settings.repeat = std::max<std::size_t>(1u, std::stoul(v));
+            }
+            else if (auto v = value("--out=")) {
+                settings.outFile = v;
+            }
+            else if (arg.compare(0, 2, "--") != 0 && settings.recordingFile.empty()) {
+                settings.recordingFile = arg;
+            }
+            else {
+                usage(argv[0]);
+                return arg == "--help" ? 0 : 1;
+            }
+        }
+        catch (const std::logic_error &) {
+            // Numbers that cannot be parsed or do not fit
+            usage(argv[0]);
+            return 1;
+        }
+    }
+    if (settings.recordingFile.empty()) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    Recording recording;
+    {
+        std::ifstream in(settings.recordingFile, std::ios::binary);
+        if (!in) {
+            std::cerr << "Cannot open " << settings.recordingFile << '\n';
+            return 1;
+        }
+        try {
+            recording = read_recording(in);
+        }
+        catch (const std::exception &e) {
+            std::cerr << settings.recordingFile << ": " << e.what() << '\n';
+            return 1;
+        }
+    }
+    Sets sets = rebuild_sets(recording);
+
+    std::vector<Latencies> latencies(settings.threads);
+    std::uint64_t start = now();
+    if (settings.threads == 1u) {
+        replay_calls(recording, sets, 0u, 1u, settings.repeat, latencies[0]);
+    }
+    else {
+        std::vector<std::thread> threads;
+        for (std::size_t t = 0; t < settings.threads; t++) {
+            threads.emplace_back([&, t] {
+                replay_calls(recording, sets, t, settings.threads, settings.repeat, latencies[t]);
+            });
+        }
+        for (auto &thread : threads) {
+            thread.join();
+        }
+    }
+    double seconds = double(now() - start) * 1e-9;
+
+    Latencies merged;
+    for (auto &thread : latencies) {
+        for (std::size_t op = 0; op < OPERATIONS; op++) {
+            merged[op].insert(merged[op].end(), thread[op].begin(), thread[op].end());
+        }
+    }
+    std::uint64_t calls = recording.calls.size() * settings.repeat;
+    auto summaries = summarize(recording, merged);
+
+    std::cout << calls << " calls on " << settings.threads << " threads in " << format_fixed(seconds, 3)
+              << " s, " << format_fixed(double(calls) / std::max(seconds, 1e-9), 0) << " calls/s\n\n";
+    write_table(std::cout, summaries);
+
+    if (!settings.outFile.empty()) {
+        std::ofstream out(settings.outFile);
+        write_summary_json(out, settings, recording, seconds, calls, summaries);
+    }
+    return 0;
+}
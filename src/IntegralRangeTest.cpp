@@ -6,11 +6,87 @@
 #define CATCH_CONFIG_MAIN
 #include <catch.hpp>
 
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <iterator>
+#include <numeric>
+#include <random>
+#include <set>
+#include <sstream>
+
 #include "RangeMerger.h"
+#include "BenchCompare.h"
+#include "BitmapRangeVector.h"
 #include "IntegralRangeVector.h"
+#include "KeyedRangeVector.h"
+#include "RangeExpression.h"
+#include "RangeGenerators.h"
+#include "RangeRecorder.h"
+#include "RangeTrace.h"
+#include "StaticRangeSet.h"
+
+#ifdef INTEGRALRANGE_CONTAINER
+#error "INTEGRALRANGE_CONTAINER is private to RangeMerger.h"
+#endif
 
 using namespace ranges;
 
+namespace {
+
+    //! Interval stored as its beginning and length, like in containers that are not built on pairs
+    struct Interval {
+        uint32_t start;
+        uint32_t length;
+
+        bool operator==(const Interval &other) const { return start == other.start && length == other.length; }
+    };
+
+    //! Enumeration with negative values
+    enum class Level : int8_t {
+        trace = -2, debug = -1, info = 0, warning = 1, error = 2
+    };
+
+    //! Allocator keeping the amount of bytes it holds in a shared counter
+    template<typename T>
+    struct CountingAllocator {
+        typedef T value_type;
+
+        std::size_t *allocated;
+
+        explicit CountingAllocator(std::size_t *allocated) : allocated(allocated) {}
+
+        template<typename U>
+        CountingAllocator(const CountingAllocator<U> &other) : allocated(other.allocated) {}
+
+        T *allocate(std::size_t n) {
+            *allocated += n * sizeof(T);
+            return std::allocator<T>().allocate(n);
+        }
+
+        void deallocate(T *pointer, std::size_t n) {
+            *allocated -= n * sizeof(T);
+            std::allocator<T>().deallocate(pointer, n);
+        }
+
+        bool operator==(const CountingAllocator &other) const { return allocated == other.allocated; }
+
+        bool operator!=(const CountingAllocator &other) const { return allocated != other.allocated; }
+    };
+
+}
+
+template<>
+struct ranges::range_traits<Interval> {
+    typedef uint32_t value_type;
+
+    static value_type begin(const Interval &range) { return range.start; }
+
+    static value_type end(const Interval &range) { return range.start + range.length; }
+
+    static Interval make(value_type begin, value_type end) { return {begin, end - begin}; }
+};
+
 SCENARIO("Integral range test", "[integral range test]") {
     REQUIRE(std::is_same_v<typename std::iterator_traits<IntegralRangeVector<uint64_t>::const_iterator>::iterator_category,
         std::input_iterator_tag>);
@@ -519,6 +595,14 @@ SCENARIO("Integral range test", "[integral range test]") {
                 REQUIRE(expected == interseted);
             }
         }
+
+        WHEN("Merger is called for difference") {
+            auto subtracted = subtract_ranges(ranges);
+
+            THEN("Result should be empty") {
+                REQUIRE(subtracted.empty());
+            }
+        }
     }
 
     GIVEN("One vector of range values") {
@@ -543,5 +627,1309 @@ SCENARIO("Integral range test", "[integral range test]") {
                 REQUIRE(expected == interseted);
             }
         }
+
+        WHEN("Merger is called for difference") {
+            ranges.push_back({ 2, 5 });
+            auto subtracted = subtract_ranges(ranges);
+
+            THEN("Result should match expected") {
+                std::vector<uint16_t> expected{ 1, 3 };
+
+                REQUIRE(expected == subtracted);
+            }
+        }
+    }
+}
+
+SCENARIO("Generated workloads", "[generators]") {
+    typedef uint32_t utype;
+    std::mt19937_64 engine(7);
+
+    auto check_canonical = [](const IntegralRangeVector<utype> &set) {
+        std::optional<std::pair<utype, utype>> previous;
+        for (const auto &range : set) {
+            REQUIRE(range.first < range.second);
+            if (previous) {
+                REQUIRE(previous->second < range.first);
+            }
+            previous = range;
+        }
+    };
+
+    GIVEN("Sets of every distribution") {
+        std::vector<IntegralRangeVector<utype>> sets;
+        sets.push_back(gen::uniform_sparse<IntegralRangeVector<utype>>(engine, 500, 4000));
+        sets.push_back(gen::dense_runs<IntegralRangeVector<utype>>(engine, 200, 16.0, 4.0));
+        sets.push_back(gen::with_density<IntegralRangeVector<utype>>(engine, 200, 0.3, 4.0));
+        sets.push_back(gen::clustered<IntegralRangeVector<utype>>(engine, 10, 64, 0.5, 300.0));
+        sets.push_back(gen::zipf_runs<IntegralRangeVector<utype>>(engine, 200, 1.1, 256, 1.5, 256));
+        sets.push_back(gen::alternating<IntegralRangeVector<utype>>(300, 1));
+
+        THEN("Generated sets are canonical") {
+            for (const auto &set : sets) {
+                REQUIRE_FALSE(set.empty());
+                check_canonical(set);
+            }
+            REQUIRE(sets[0].length() == 500);
+        }
+
+        THEN("Plain and range containers receive the same values") {
+            std::mt19937_64 first(11), second(11);
+            auto ranged = gen::zipf_runs<IntegralRangeVector<utype>>(first, 100, 1.1, 64, 1.1, 64);
+            auto plain = gen::zipf_runs<std::vector<utype>>(second, 100, 1.1, 64, 1.1, 64);
+            REQUIRE(ranged.toVector() == plain);
+        }
+
+        WHEN("Sets are merged") {
+            std::set<utype> united, intersected;
+            for (auto value : sets[0].toVector()) {
+                intersected.insert(value);
+            }
+            for (const auto &set : sets) {
+                auto values = set.toVector();
+                united.insert(values.begin(), values.end());
+
+                std::set<utype> next;
+                std::set_intersection(intersected.begin(), intersected.end(), values.begin(), values.end(),
+                                      std::inserter(next, next.end()));
+                intersected.swap(next);
+            }
+
+            THEN("Results match a std::set model") {
+                auto unionValues = unite_ranges(sets).toVector();
+                REQUIRE(std::vector<utype>(united.begin(), united.end()) == unionValues);
+
+                auto intersectionValues = intersect_ranges(sets).toVector();
+                REQUIRE(std::vector<utype>(intersected.begin(), intersected.end()) == intersectionValues);
+            }
+
+            THEN("Difference matches a std::set model") {
+                auto values = sets[1].toVector();
+                for (std::size_t i = 2; i < sets.size(); i++) {
+                    auto other = sets[i].toVector();
+                    values.insert(values.end(), other.begin(), other.end());
+                }
+                std::set<utype> subtracted(values.begin(), values.end());
+                std::vector<utype> expected;
+                for (auto value : sets[0].toVector()) {
+                    if (subtracted.count(value) == 0) {
+                        expected.push_back(value);
+                    }
+                }
+                auto difference = subtract_ranges(sets);
+                check_canonical(difference);
+                REQUIRE(difference.toVector() == expected);
+                REQUIRE(subtract_ranges(std::vector<IntegralRangeVector<utype>>{sets[0], sets[0]}).empty());
+            }
+        }
+    }
+
+    GIVEN("A correlated family") {
+        auto family = gen::correlated_family<IntegralRangeVector<utype>>(engine, 4, 400, 8.0, 8.0, 0.8);
+
+        THEN("Members are canonical and share ranges") {
+            REQUIRE(family.size() == 4);
+            for (const auto &set : family) {
+                check_canonical(set);
+            }
+            auto common = intersect_ranges(family);
+            REQUIRE(common.length() > 0);
+            REQUIRE(common.length() < family[0].length());
+        }
+    }
+}
+
+SCENARIO("Operation counters", "[stats]") {
+    typedef uint16_t utype;
+    std::vector<IntegralRangeVector<utype>> ranges(2);
+    insert_back(ranges[0], { 0, 10 });
+    insert_back(ranges[0], { 20, 30 });
+    insert_back(ranges[0], { 40, 41 });
+    insert_back(ranges[1], { 5, 25 });
+    insert_back(ranges[1], { 30, 45 });
+
+    WHEN("Merger is called for intersection with a stats output") {
+        OperationStats stats;
+        stats.emittedRanges = 100;
+        auto intersected = intersect_ranges(ranges, &stats);
+
+        THEN("Counters describe the call") {
+            REQUIRE(intersected.length() == 11);
+            if (stats_enabled()) {
+                REQUIRE(stats.emittedRanges == 3);
+                REQUIRE(stats.cursorAdvances == 4);
+                REQUIRE(stats.headComparisons == 2 * stats.cursorAdvances);
+                REQUIRE(stats.allocations >= 1);
+            }
+            else {
+                REQUIRE(stats.emittedRanges == 0);
+                REQUIRE(stats.cursorAdvances == 0);
+                REQUIRE(stats.headComparisons == 0);
+            }
+        }
+    }
+
+    WHEN("Merger is called for union with a stats output") {
+        OperationStats stats;
+        auto united = unite_ranges(ranges, &stats);
+
+        THEN("Counters describe the call") {
+            REQUIRE(united.length() == 45);
+            if (stats_enabled()) {
+                REQUIRE(stats.emittedRanges == 1);
+                REQUIRE(stats.coalescedMerges == 4);
+                REQUIRE(stats.cursorAdvances == 5);
+            }
+            else {
+                REQUIRE(stats.coalescedMerges == 0);
+            }
+        }
+    }
+
+    WHEN("Values are pushed one by one") {
+        reset_thread_stats();
+        IntegralRangeVector<utype> arr;
+        for (utype i = 0; i < 100; i++) {
+            arr.push_back(i);
+        }
+
+        THEN("Coalescing and growth are aggregated per thread") {
+            if (stats_enabled()) {
+                REQUIRE(thread_stats().coalescedMerges == 99);
+                REQUIRE(thread_stats().allocations == 1);
+                REQUIRE(thread_stats().reallocations >= 1);
+            }
+            else {
+                REQUIRE(thread_stats().coalescedMerges == 0);
+            }
+        }
+    }
+}
+
+SCENARIO("Structural statistics", "[analyze]") {
+    typedef uint32_t utype;
+
+    GIVEN("An empty container") {
+        IntegralRangeVector<utype> arr;
+        auto stats = arr.analyze();
+
+        THEN("Statistics are empty") {
+            REQUIRE(stats.ranges == 0);
+            REQUIRE(stats.length == 0);
+            REQUIRE(stats.span == 0);
+            REQUIRE(stats.density == 0.0);
+            REQUIRE(stats.rangeEncodingBytes == 0);
+        }
+    }
+
+    GIVEN("A container with singletons and ranges") {
+        IntegralRangeVector<utype> arr;
+        arr.push_back(utype(1));
+        arr.push_back({ 3, 7 });
+        arr.push_back(utype(10));
+        arr.push_back({ 20, 21 });
+        arr.push_back({ 40, 60 });
+        auto stats = arr.analyze();
+
+        THEN("Counts and histograms describe the ranges") {
+            REQUIRE(stats.ranges == 5);
+            REQUIRE(stats.singletons == 3);
+            REQUIRE(stats.singletonRatio == Approx(0.6));
+            REQUIRE(stats.length == arr.length());
+            REQUIRE(stats.length == 27);
+            REQUIRE(stats.span == 59);
+            REQUIRE(stats.density == Approx(27.0 / 59.0));
+
+            REQUIRE(stats.runLengths[0] == 3);
+            REQUIRE(stats.runLengths[2] == 1);
+            REQUIRE(stats.runLengths[4] == 1);
+
+            // Gaps of 1, 3, 9 and 19 values
+            REQUIRE(stats.gapLengths[0] == 1);
+            REQUIRE(stats.gapLengths[1] == 1);
+            REQUIRE(stats.gapLengths[3] == 1);
+            REQUIRE(stats.gapLengths[4] == 1);
+
+            REQUIRE(stats.rangeEncodingBytes == arr.getBase().size() * sizeof(utype));
+            REQUIRE(stats.pairEncodingBytes == 5 * 2 * sizeof(utype));
+            REQUIRE(stats.valueEncodingBytes == 27 * sizeof(utype));
+            REQUIRE(stats.bitmapEncodingBytes == 8);
+        }
+    }
+
+    GIVEN("A generated container") {
+        std::mt19937_64 engine(3);
+        auto arr = gen::zipf_runs<IntegralRangeVector<utype>>(engine, 1000, 1.2, 512, 1.2, 512);
+        auto stats = arr.analyze();
+
+        THEN("Statistics match iteration") {
+            REQUIRE(stats.ranges == size_t(std::distance(arr.begin(), arr.end())));
+            size_t runs = 0, gaps = 0;
+            for (size_t i = 0; i < RangeStatistics::BUCKETS; i++) {
+                runs += stats.runLengths[i];
+                gaps += stats.gapLengths[i];
+            }
+            REQUIRE(runs == stats.ranges);
+            REQUIRE(gaps == stats.ranges - 1);
+            REQUIRE(stats.length == IntegralRangeVector<utype>(arr.getBase()).length());
+        }
+    }
+}
+
+SCENARIO("Trace spans", "[trace]") {
+    typedef uint32_t utype;
+    std::vector<IntegralRangeVector<utype>> ranges(2);
+    insert_back(ranges[0], { 0, 10 });
+    insert_back(ranges[1], { 5, 25 });
+
+    WHEN("Spans are recorded") {
+        start_tracing(4);
+        {
+            TraceSpan span("query", "sets", 2);
+            REQUIRE(intersect_ranges(ranges).length() == 5);
+        }
+        stop_tracing();
+        {
+            TraceSpan span("ignored");
+        }
+
+        std::ostringstream out;
+        write_chrome_trace(out);
+        auto trace = out.str();
+
+        THEN("Completed spans are written as trace events") {
+            REQUIRE(trace.find("\"name\": \"query\", \"ph\": \"X\"") != std::string::npos);
+            REQUIRE(trace.find("\"args\": {\"sets\": 2}") != std::string::npos);
+            REQUIRE(trace.find("ignored") == std::string::npos);
+            REQUIRE((trace.find("\"name\": \"intersect_ranges\"") != std::string::npos) == trace_enabled());
+            REQUIRE(trace.find("\"dropped_events\": 0") != std::string::npos);
+        }
+    }
+
+    WHEN("More spans are recorded than a buffer holds") {
+        start_tracing(4);
+        const char *names[] = {"span0", "span1", "span2", "span3", "span4", "span5"};
+        for (auto name : names) {
+            TraceSpan span(name);
+        }
+        stop_tracing();
+
+        std::ostringstream out;
+        write_chrome_trace(out);
+        auto trace = out.str();
+
+        THEN("The latest spans are kept") {
+            REQUIRE(trace.find("span1") == std::string::npos);
+            REQUIRE(trace.find("span2") != std::string::npos);
+            REQUIRE(trace.find("span2") < trace.find("span5"));
+            REQUIRE(trace.find("\"dropped_events\": 2") != std::string::npos);
+        }
+    }
+}
+
+SCENARIO("Lookups", "[contains]") {
+    typedef uint32_t utype;
+    std::mt19937_64 engine(13);
+
+    GIVEN("Generated sets") {
+        std::vector<IntegralRangeVector<utype>> sets;
+        sets.push_back(gen::uniform_sparse<IntegralRangeVector<utype>>(engine, 300, 2000));
+        sets.push_back(gen::dense_runs<IntegralRangeVector<utype>>(engine, 100, 8.0, 4.0));
+        sets.push_back(gen::clustered<IntegralRangeVector<utype>>(engine, 10, 32, 0.5, 100.0));
+        sets.push_back(IntegralRangeVector<utype>());
+
+        THEN("Every value is found exactly if it is stored") {
+            for (const auto &set : sets) {
+                auto values = set.toVector();
+                std::set<utype> stored(values.begin(), values.end());
+                utype limit = values.empty() ? 10u : values.back() + 10u;
+                for (utype value = 0; value < limit; value++) {
+                    REQUIRE(set.contains(value) == (stored.count(value) == 1u));
+                }
+            }
+        }
+    }
+
+    GIVEN("Large sets of ranges without singletons, where every word is masked") {
+        // Ranges [4i, 4i + 2), the second set is shifted by a leading singleton so blocks start at range endings
+        IntegralRangeVector<utype> aligned, shifted;
+        StaticRangeSet<utype, 4096> fixed;
+        shifted.push_back(utype(0u));
+        for (utype i = 1; i < 200000u; i++) {
+            aligned.push_back({4u * i, 4u * i + 2u});
+            shifted.push_back({4u * i, 4u * i + 2u});
+            if (i < 2000u) {
+                fixed.push_back({4u * i, 4u * i + 2u});
+            }
+        }
+        IntegralRangeVector<utype> copied(shifted.getBase());
+
+        THEN("Lookups decode at most a block and find every value") {
+            auto stored = [](utype value, utype limit) {
+                return value >= 4u && value < 4u * limit && value % 4u < 2u;
+            };
+            for (utype value = 0; value < 800000u; value += 997u) {
+                for (utype offset = 0; offset < 4u; offset++) {
+                    REQUIRE(aligned.contains(value + offset) == stored(value + offset, 200000u));
+                    REQUIRE(shifted.contains(value + offset) ==
+                            (value + offset == 0u || stored(value + offset, 200000u)));
+                    REQUIRE(copied.contains(value + offset) == shifted.contains(value + offset));
+                }
+            }
+            for (utype value = 0; value < 8010u; value++) {
+                REQUIRE(fixed.contains(value) == stored(value, 2000u));
+            }
+        }
+    }
+
+    GIVEN("Sets with an allocator") {
+        typedef IntegralRangeVector<utype, CountingAllocator<utype>> Cont;
+        std::size_t allocated = 0u;
+        CountingAllocator<utype> allocator(&allocated);
+
+        THEN("Marks of blocks are allocated by it as well") {
+            {
+                // The leading singleton shifts the endings of ranges to the first words of blocks
+                Cont pushed(allocator);
+                pushed.push_back(utype(0u));
+                for (utype i = 1; i <= 1000u; i++) {
+                    pushed.push_back({4u * i, 4u * i + 2u});
+                }
+                REQUIRE(allocated > pushed.getBase().capacity() * sizeof(utype));
+
+                Cont copied(pushed.getBase(), allocator);
+                REQUIRE(allocated > (pushed.getBase().capacity() + copied.getBase().capacity()) * sizeof(utype));
+                REQUIRE(copied.contains(4001u));
+                REQUIRE_FALSE(copied.contains(4002u));
+            }
+            REQUIRE(allocated == 0u);
+        }
+    }
+
+    GIVEN("Adjacent ranges that are not coalesced") {
+        constexpr utype mask = IntegralRangeVector<utype>::mask;
+        IntegralRangeVector<utype> set(std::vector<utype>{1u, 3u | mask, 5u | mask, 5u | mask, 8u | mask, 9u});
+
+        THEN("Values at the boundaries are found") {
+            std::vector<bool> expected{false, true, false, true, true, true, true, true, false, true, false};
+            for (utype value = 0; value < expected.size(); value++) {
+                REQUIRE(set.contains(value) == expected[value]);
+            }
+        }
+    }
+}
+
+SCENARIO("Call recording", "[record]") {
+    typedef uint32_t utype;
+    std::vector<IntegralRangeVector<utype>> ranges(2);
+    insert_back(ranges[0], { 0, 10 });
+    insert_back(ranges[0], { 12, 13 });
+    insert_back(ranges[1], { 5, 25 });
+
+    RecordedVersion version;
+
+    WHEN("Calls are recorded") {
+        std::stringstream out(std::ios::in | std::ios::out | std::ios::binary);
+        start_recording(out);
+        {
+            RecordedMerge merge(RecordedOperation::intersect, ranges);
+        }
+        {
+            RecordedLookup lookup(ranges[1].getBase(), version, utype(7));
+        }
+        {
+            RecordedLookup lookup(ranges[1].getBase(), version, utype(30));
+        }
+        stop_recording();
+        {
+            RecordedLookup lookup(ranges[0].getBase(), version, utype(1));
+        }
+
+        auto recording = read_recording(out);
+
+        THEN("Snapshots rebuild the operands") {
+            REQUIRE(recording.snapshots.size() == 2);
+            for (const auto &range : ranges) {
+                const auto &snapshot = recording.snapshots.at(record::fingerprint(range.getBase()));
+                REQUIRE(snapshot.width == sizeof(utype));
+                REQUIRE(std::vector<utype>(snapshot.words.begin(), snapshot.words.end()) == range.getBase());
+            }
+        }
+
+        THEN("Calls are read back in order") {
+            REQUIRE(recording.calls.size() == 3);
+            REQUIRE(recording.calls[0].operation == RecordedOperation::intersect);
+            REQUIRE(recording.calls[0].operands.size() == 2);
+            REQUIRE(recording.calls[1].operation == RecordedOperation::contains);
+            REQUIRE(recording.calls[1].value == 7);
+            REQUIRE(recording.calls[2].value == 30);
+            REQUIRE(recording.calls[1].operands == recording.calls[2].operands);
+            REQUIRE(recording.calls[0].thread == recording.calls[2].thread);
+        }
+    }
+
+    WHEN("A set changes in place between lookups") {
+        std::vector<utype> words = ranges[0].getBase();
+        std::stringstream out(std::ios::in | std::ios::out | std::ios::binary);
+        start_recording(out);
+        {
+            RecordedLookup lookup(words, version, utype(11));
+        }
+        // Same storage, size and boundary words, different contents
+        words[1] = utype(11u | IntegralRangeVector<utype>::mask);
+        version.renew();
+        {
+            RecordedLookup lookup(words, version, utype(11));
+        }
+        stop_recording();
+        auto recording = read_recording(out);
+
+        THEN("The lookup after the change records the new contents") {
+            REQUIRE(recording.calls.size() == 2);
+            REQUIRE(recording.calls[1].operands[0] == record::fingerprint(words));
+            REQUIRE(recording.calls[0].operands != recording.calls[1].operands);
+            REQUIRE(recording.snapshots.count(record::fingerprint(words)) == 1);
+        }
+    }
+
+    WHEN("Merges of keyed containers are recorded") {
+        std::vector<KeyedRangeVector<int32_t>> offsets(2);
+        offsets[0].push_back({-20, 5});
+        offsets[1].push_back({-3, 40});
+        std::stringstream out(std::ios::in | std::ios::out | std::ios::binary);
+        start_recording(out);
+        {
+            RecordedMerge merge(RecordedOperation::unite, offsets);
+        }
+        stop_recording();
+        auto recording = read_recording(out);
+
+        THEN("Operands are recorded as their words of keys") {
+            REQUIRE(recording.calls.size() == 1);
+            REQUIRE(recording.calls[0].width == sizeof(key_type_t<int32_t>));
+            const auto &keys = offsets[0].getBase().getBase();
+            const auto &snapshot = recording.snapshots.at(record::fingerprint(keys));
+            REQUIRE(std::vector<key_type_t<int32_t>>(snapshot.words.begin(), snapshot.words.end()) == keys);
+        }
+    }
+
+    WHEN("Merges of no sets are recorded") {
+        std::stringstream out(std::ios::in | std::ios::out | std::ios::binary);
+        start_recording(out);
+        {
+            RecordedMerge merge(RecordedOperation::subtract, std::vector<IntegralRangeVector<utype>>{});
+        }
+        {
+            RecordedMerge merge(RecordedOperation::intersect, ranges);
+        }
+        stop_recording();
+        auto recording = read_recording(out);
+
+        THEN("They are read back without operands") {
+            REQUIRE(recording.calls.size() == 2);
+            REQUIRE(recording.calls[0].operation == RecordedOperation::subtract);
+            REQUIRE(recording.calls[0].width == sizeof(utype));
+            REQUIRE(recording.calls[0].operands.empty());
+            REQUIRE(recording.calls[1].operands.size() == 2);
+        }
+    }
+
+    WHEN("A recording is truncated") {
+        std::stringstream out(std::ios::in | std::ios::out | std::ios::binary);
+        start_recording(out);
+        {
+            RecordedMerge merge(RecordedOperation::unite, ranges);
+        }
+        stop_recording();
+        std::stringstream truncated(out.str().substr(0, out.str().size() - 3), std::ios::in | std::ios::binary);
+
+        THEN("Reading fails") {
+            REQUIRE_THROWS_AS(read_recording(truncated), std::runtime_error);
+        }
+    }
+
+    WHEN("A call has a wrong amount of operands") {
+        auto call = [&](RecordedOperation operation, std::size_t operands) {
+            std::stringstream out(std::ios::in | std::ios::out | std::ios::binary);
+            start_recording(out);
+            {
+                RecordedMerge merge(RecordedOperation::unite, ranges);
+            }
+            stop_recording();
+            const auto &words = ranges[0].getBase();
+            out.put('C');
+            out.put(char(operation));
+            out.put(char(sizeof(utype)));
+            record::write_varint(out, 0u);
+            record::write_varint(out, 0u);
+            record::write_varint(out, 5u);
+            record::write_varint(out, operands);
+            for (std::size_t i = 0; i < operands; i++) {
+                record::write_fixed(out, record::fingerprint(words));
+            }
+            return read_recording(out).calls.size();
+        };
+
+        THEN("Lookups need exactly one operand") {
+            REQUIRE(call(RecordedOperation::contains, 1u) == 2u);
+            REQUIRE_THROWS_AS(call(RecordedOperation::contains, 0u), std::runtime_error);
+            REQUIRE_THROWS_AS(call(RecordedOperation::contains, 2u), std::runtime_error);
+            REQUIRE(call(RecordedOperation::intersect, 2u) == 2u);
+            REQUIRE(call(RecordedOperation::intersect, 0u) == 2u);
+        }
+    }
+}
+
+SCENARIO("Static range sets", "[static]") {
+    typedef uint16_t utype;
+
+    GIVEN("Tables computed at compile time") {
+        static constexpr StaticRangeSet<utype, 4> wellKnown{{0u, 1024u}, {8080u, 8081u}};
+        static constexpr StaticRangeSet<utype, 4> registered{{1000u, 1100u}, {8081u, 8082u}};
+        static constexpr StaticRangeSet<utype, 2> dynamic{{30000u, 32767u}};
+
+        static constexpr auto reserved = unite(wellKnown, registered, dynamic);
+        static constexpr auto shared = intersect(wellKnown, registered);
+        static constexpr auto own = subtract(wellKnown, registered);
+        static constexpr auto table = with_capacity<reserved.size()>(reserved);
+
+        static_assert(reserved.capacity() == 10u);
+        static_assert(reserved.length() == 1100u + 2u + 2767u);
+        static_assert(reserved.contains(8081u) && !reserved.contains(8082u) && reserved.contains(30000u));
+        static_assert(shared.length() == 24u && shared.contains(1000u) && !shared.contains(8080u));
+        static_assert(own.length() == 1001u && !own.contains(1000u) && own.contains(8080u));
+        static_assert(table.capacity() == 6u && table.size() == 6u);
+        static_assert(std::is_trivially_copyable_v<StaticRangeSet<utype, 4>>);
+
+        THEN("Ranges are iterated at run time") {
+            std::vector<std::pair<utype, utype>> expected{{0u, 1100u}, {8080u, 8082u}, {30000u, 32767u}};
+            REQUIRE(std::vector<std::pair<utype, utype>>(table.begin(), table.end()) == expected);
+        }
+    }
+
+    GIVEN("Generated sets") {
+        std::mt19937_64 engine(17);
+        auto a = gen::with_density<IntegralRangeVector<utype>>(engine, 100, 0.4, 3.0);
+        auto b = gen::clustered<IntegralRangeVector<utype>>(engine, 8, 40, 0.5, 30.0);
+
+        StaticRangeSet<utype, 512> first, second;
+        for (const auto &range : a) {
+            first.push_back(range);
+        }
+        for (auto value : b.toVector()) {
+            second.push_back(value);
+        }
+
+        auto words = [](const auto &set) { return std::vector<utype>(set.data(), set.data() + set.size()); };
+
+        THEN("Encoding and merges match IntegralRangeVector") {
+            REQUIRE(words(first) == a.getBase());
+            REQUIRE(words(second) == b.getBase());
+
+            std::vector<IntegralRangeVector<utype>> sets{a, b};
+            REQUIRE(words(unite(first, second)) == unite_ranges(sets).getBase());
+            REQUIRE(words(intersect(first, second)) == intersect_ranges(sets).getBase());
+            REQUIRE(words(subtract(first, second)) == subtract_ranges(sets).getBase());
+            for (utype value = 0; value < 2000u; value++) {
+                REQUIRE(first.contains(value) == a.contains(value));
+            }
+        }
+
+        THEN("Vectors of sets are merged by the generic merges") {
+            std::vector<StaticRangeSet<utype, 512>> sets{first, second};
+            REQUIRE(unite_ranges(sets) == with_capacity<512>(unite(first, second)));
+            REQUIRE(intersect_ranges(sets) == with_capacity<512>(intersect(first, second)));
+            REQUIRE(subtract_ranges(sets) == with_capacity<512>(subtract(first, second)));
+        }
+    }
+
+    GIVEN("A set filled to its capacity") {
+        StaticRangeSet<utype, 4> set{{10u, 20u}, {30u, 40u}};
+        REQUIRE(set.full());
+
+        WHEN("A range that needs another word is appended") {
+            auto copy = set;
+
+            THEN("It is rejected and the set is unchanged") {
+                REQUIRE_FALSE(set.try_push_back(utype(45u)));
+                REQUIRE_THROWS_AS(set.push_back({45u, 50u}), std::length_error);
+                REQUIRE_THROWS_AS(set.push_back(utype(41u)), std::length_error);
+                REQUIRE(set == copy);
+            }
+        }
+
+        WHEN("A range that extends the last one is appended") {
+            set.push_back({40u, 50u});
+
+            THEN("It fits without new words") {
+                REQUIRE(set.size() == 4u);
+                REQUIRE(set.length() == 30u);
+            }
+        }
+
+        WHEN("The set is copied as raw bytes") {
+            StaticRangeSet<utype, 4> copy;
+            std::memcpy(&copy, &set, sizeof(set));
+
+            THEN("The copy is equal") {
+                REQUIRE(copy == set);
+                REQUIRE(copy.contains(30u));
+            }
+        }
+    }
+}
+
+SCENARIO("Custom range types", "[traits]") {
+    GIVEN("Containers of intervals described by range_traits") {
+        std::mt19937_64 engine(23);
+        std::vector<std::vector<Interval>> intervals;
+        std::vector<IntegralRangeVector<uint32_t>> sets;
+        for (int i = 0; i < 3; i++) {
+            sets.push_back(gen::with_density<IntegralRangeVector<uint32_t>>(engine, 200, 0.3 + 0.2 * i, 4.0));
+            intervals.emplace_back();
+            for (const auto &range : sets.back()) {
+                intervals.back().push_back({range.first, uint32_t(range.second - range.first)});
+            }
+        }
+
+        auto asIntervals = [](const IntegralRangeVector<uint32_t> &set) {
+            std::vector<Interval> result;
+            for (const auto &range : set) {
+                result.push_back({range.first, uint32_t(range.second - range.first)});
+            }
+            return result;
+        };
+
+        THEN("Intervals are range types and values are not") {
+            REQUIRE(is_range_type_v<Interval>);
+            REQUIRE(is_range_type_v<std::pair<uint32_t, uint32_t>>);
+            REQUIRE_FALSE(is_range_type_v<uint32_t>);
+        }
+
+        THEN("They are merged directly and match IntegralRangeVector") {
+            REQUIRE(intersect_ranges(intervals) == asIntervals(intersect_ranges(sets)));
+            REQUIRE(unite_ranges(intervals) == asIntervals(unite_ranges(sets)));
+            REQUIRE(subtract_ranges(intervals) == asIntervals(subtract_ranges(sets)));
+        }
+
+        THEN("Generators fill them") {
+            auto generated = gen::with_density<std::vector<Interval>>(engine, 50, 0.5, 2.0);
+            REQUIRE(!generated.empty());
+            for (size_t i = 1; i < generated.size(); i++) {
+                REQUIRE(generated[i - 1].start + generated[i - 1].length <= generated[i].start);
+            }
+        }
+    }
+}
+
+SCENARIO("Set expressions", "[expression]") {
+    typedef uint32_t utype;
+    typedef IntegralRangeVector<utype> Cont;
+
+    GIVEN("Generated sets") {
+        std::mt19937_64 engine(29);
+        auto a = gen::with_density<Cont>(engine, 300, 0.3, 4.0);
+        auto b = gen::with_density<Cont>(engine, 300, 0.5, 8.0);
+        auto c = gen::clustered<Cont>(engine, 10, 60, 0.6, 40.0);
+        auto d = gen::with_density<Cont>(engine, 200, 0.2, 2.0);
+
+        WHEN("A query is evaluated as an expression") {
+            OperationStats stats;
+            Cont fused = ((a | b) & c & ~d).evaluate(&stats);
+
+            THEN("It matches the result of separate merges") {
+                Cont expected = subtract_ranges(std::vector<Cont>{
+                        intersect_ranges(std::vector<Cont>{unite_ranges(std::vector<Cont>{a, b}), c}), d});
+                REQUIRE(fused.getBase() == expected.getBase());
+                if (stats_enabled()) {
+                    REQUIRE(stats.emittedRanges == expected.analyze().ranges);
+                }
+            }
+
+            THEN("Iteration yields the same ranges") {
+                auto expression = (a | b) & c & ~d;
+                std::vector<std::pair<utype, utype>> iterated;
+                OperationStats iteration;
+                {
+                    StatsScope statsScope(&iteration);
+                    iterated.assign(expression.begin(), expression.end());
+                }
+                REQUIRE(iterated == std::vector<std::pair<utype, utype>>(fused.begin(), fused.end()));
+                if (stats_enabled()) {
+                    // The end iterator reads no operands
+                    REQUIRE(iteration.cursorAdvances == stats.cursorAdvances);
+                }
+            }
+
+            THEN("Iterators compare equal at the same range") {
+                auto expression = (a | b) & c & ~d;
+                auto it = expression.begin();
+                auto copy = it;
+                REQUIRE(it == it);
+                REQUIRE(it == copy);
+                REQUIRE(it != expression.end());
+                ++copy;
+                REQUIRE(it != copy);
+                REQUIRE(++it == copy);
+                REQUIRE(std::find(expression.begin(), expression.end(), *copy) == copy);
+                REQUIRE(std::size_t(std::distance(expression.begin(), expression.end())) == fused.analyze().ranges);
+            }
+        }
+
+        WHEN("Operators are combined") {
+            Cont both = a & b;
+            Cont either = a | b;
+            Cont onlyA = a - b;
+
+            THEN("Set identities hold") {
+                REQUIRE(Cont(~(~a | ~b)).getBase() == both.getBase());
+                REQUIRE(Cont(~(~a & ~b)).getBase() == either.getBase());
+                REQUIRE(Cont(a & ~b).getBase() == onlyA.getBase());
+                REQUIRE(Cont(onlyA | both).getBase() == a.getBase());
+                REQUIRE(Cont(~~a).getBase() == a.getBase());
+                REQUIRE(Cont(a - a).empty());
+            }
+        }
+    }
+
+    GIVEN("Empty sets and bounds of the value type") {
+        Cont empty;
+        Cont last;
+        last.push_back({10u, 20u});
+        last.push_back({100u, expr::Leaf<Cont>::LIMIT});
+
+        THEN("Complements cover the values below the mask") {
+            Cont all = ~empty;
+            REQUIRE(std::vector<std::pair<utype, utype>>(all.begin(), all.end()) ==
+                    std::vector<std::pair<utype, utype>>{{0u, expr::Leaf<Cont>::LIMIT}});
+            Cont gaps = ~last;
+            REQUIRE(std::vector<std::pair<utype, utype>>(gaps.begin(), gaps.end()) ==
+                    std::vector<std::pair<utype, utype>>{{0u, 10u}, {20u, 100u}});
+            REQUIRE(Cont(empty | empty).empty());
+            REQUIRE(Cont(last & empty).empty());
+        }
+    }
+
+    GIVEN("A singleton at the limit, the largest value a set can store") {
+        constexpr utype limit = expr::Leaf<Cont>::LIMIT;
+        Cont edge;
+        edge.push_back({10u, 20u});
+        edge.push_back(limit);
+        REQUIRE(edge.contains(limit));
+
+        THEN("It is outside of the universe of complements") {
+            Cont gaps = ~edge;
+            REQUIRE(std::vector<std::pair<utype, utype>>(gaps.begin(), gaps.end()) ==
+                    std::vector<std::pair<utype, utype>>{{0u, 10u}, {20u, limit}});
+            REQUIRE_FALSE(gaps.contains(limit));
+            Cont twice = ~~edge;
+            REQUIRE(std::vector<std::pair<utype, utype>>(twice.begin(), twice.end()) ==
+                    std::vector<std::pair<utype, utype>>{{10u, 20u}});
+            REQUIRE(Cont(edge & ~edge).empty());
+        }
+    }
+}
+
+SCENARIO("Variadic merges of mixed sequences", "[variadic]") {
+    typedef uint32_t utype;
+    typedef IntegralRangeVector<utype> Cont;
+
+    GIVEN("A range vector, a sorted vector of values, a vector of pairs and a static set") {
+        std::mt19937_64 engine(31);
+        auto a = gen::with_density<Cont>(engine, 300, 0.6, 6.0);
+        auto b = gen::with_density<Cont>(engine, 300, 0.5, 3.0);
+        auto c = gen::clustered<Cont>(engine, 10, 60, 0.7, 40.0);
+        std::vector<utype> values = b.toVector();
+        std::vector<std::pair<utype, utype>> pairs(c.begin(), c.end());
+        StaticRangeSet<utype, 8> ports{{0u, 100u}, {500u, 900u}, {1500u, 1501u}};
+        Cont portSet(std::vector<utype>(ports.data(), ports.data() + ports.size()));
+
+        THEN("Intersection matches intersect_ranges") {
+            Cont expected = intersect_ranges(std::vector<Cont>{a, b, c});
+            REQUIRE(intersect(a, values, pairs).getBase() == expected.getBase());
+            REQUIRE(intersect(values, a).getBase() == intersect_ranges(std::vector<Cont>{a, b}).getBase());
+            REQUIRE(intersect(a, values, pairs, ports).getBase() ==
+                    intersect_ranges(std::vector<Cont>{a, b, c, portSet}).getBase());
+        }
+
+        THEN("Union matches unite_ranges") {
+            Cont expected = unite_ranges(std::vector<Cont>{a, b, c});
+            REQUIRE(unite(a, values, pairs).getBase() == expected.getBase());
+            REQUIRE(unite(pairs, ports).getBase() == unite_ranges(std::vector<Cont>{c, portSet}).getBase());
+        }
+
+        THEN("Set expressions are merged as views") {
+            REQUIRE(intersect(a | c, values).getBase() == Cont((a | c) & b).getBase());
+            REQUIRE(unite(a - c, pairs).getBase() == Cont(a | c).getBase());
+        }
+
+        THEN("Static sets still use the constexpr merges") {
+            REQUIRE(std::is_same_v<decltype(unite(ports, ports)), StaticRangeSet<utype, 16>>);
+            REQUIRE(std::is_same_v<decltype(intersect(ports, ports, ports)), StaticRangeSet<utype, 24>>);
+        }
+    }
+
+    GIVEN("Inputs without values") {
+        Cont empty;
+        std::vector<uint16_t> narrow{1u, 2u, 3u};
+
+        THEN("Results are empty or copy the other inputs, values are widened to the common type") {
+            REQUIRE(intersect(empty, narrow).empty());
+            auto united = unite(empty, narrow);
+            REQUIRE(std::is_same_v<decltype(united), IntegralRangeVector<uint32_t>>);
+            REQUIRE(united.toVector() == std::vector<utype>{1u, 2u, 3u});
+        }
+    }
+}
+
+SCENARIO("Kernel dispatch", "[dispatch]") {
+    typedef uint32_t utype;
+    std::mt19937_64 engine(37);
+    auto set = gen::with_density<IntegralRangeVector<utype>>(engine, 2000, 0.5, 4.0);
+    auto values = set.toVector();
+    dispatch::Isa detected = dispatch::detect_isa();
+    dispatch::Isa active = dispatch::active_isa();
+
+    GIVEN("Every instruction set the CPU supports") {
+        THEN("Containers behave the same with kernels bound to each of them") {
+            for (std::size_t i = 0; i <= std::size_t(detected); i++) {
+                REQUIRE(dispatch::force_isa(dispatch::Isa(i)));
+                REQUIRE(dispatch::active_isa() == dispatch::Isa(i));
+                REQUIRE(set.length() == values.size());
+                REQUIRE(set.toVector() == values);
+                REQUIRE(IntegralRangeVector<utype>::fromVector(values).getBase() == set.getBase());
+                for (utype value = 0; value <= values.back() + 1u; value += 7u) {
+                    REQUIRE(set.contains(value) == std::binary_search(values.begin(), values.end(), value));
+                }
+            }
+            dispatch::force_isa(active);
+        }
+
+        THEN("Unsupported instruction sets are not bound") {
+            if (detected != dispatch::Isa::avx512) {
+                REQUIRE_FALSE(dispatch::force_isa(dispatch::Isa::avx512));
+                REQUIRE(dispatch::active_isa() == active);
+            }
+            REQUIRE(std::string(dispatch::isa_name(dispatch::Isa::sse42)) == "sse4.2");
+        }
+    }
+
+    GIVEN("Runs crossing the blocks of the kernels") {
+        std::vector<utype> run(200);
+        std::iota(run.begin(), run.end(), 5u);
+        run.push_back(300u);
+
+        THEN("Runs are found at every offset") {
+            for (std::size_t i = 0; i <= std::size_t(detected); i++) {
+                const auto &kernels = dispatch::kernels_for<utype>(dispatch::Isa(i));
+                for (std::size_t offset = 0; offset < run.size() - 1u; offset++) {
+                    REQUIRE(kernels.runLength(run.data() + offset, run.size() - offset) == 200u - offset);
+                }
+            }
+        }
+
+        THEN("Lengths of encodings are found at every range boundary") {
+            const auto &words = set.getBase();
+            for (std::size_t i = 0; i <= std::size_t(detected); i++) {
+                const auto &kernels = dispatch::kernels_for<utype>(dispatch::Isa(i));
+                std::uint64_t length = 0u;
+                for (std::size_t position = 0; position < words.size();) {
+                    REQUIRE(kernels.rangeLength(words.data(), position) == length);
+                    constexpr utype mask = IntegralRangeVector<utype>::mask;
+                    bool masked = words[position] & mask;
+                    length += masked ? (words[position + 1u] & ~mask) - (words[position] & ~mask) : 1u;
+                    position += masked ? 2u : 1u;
+                }
+            }
+        }
+    }
+}
+
+SCENARIO("Bitmap sets of narrow types", "[bitmap]") {
+    typedef uint16_t utype;
+    typedef IntegralRangeVector<utype> Cont;
+    typedef BitmapRangeVector<utype> Bitmap;
+
+    REQUIRE(std::is_same_v<RangeSet<uint8_t>, BitmapRangeVector<uint8_t>>);
+    REQUIRE(std::is_same_v<RangeSet<utype>, Bitmap>);
+    REQUIRE(std::is_same_v<RangeSet<uint32_t>, IntegralRangeVector<uint32_t>>);
+    REQUIRE(sizeof(BitmapRangeVector<uint8_t>) == 32u);
+    REQUIRE(sizeof(Bitmap) == 8192u);
+
+    GIVEN("Generated range vectors and their bitmaps") {
+        std::mt19937_64 engine(41);
+        std::vector<Cont> sets;
+        sets.push_back(gen::with_density<Cont>(engine, 500, 0.4, 6.0));
+        sets.push_back(gen::with_density<Cont>(engine, 500, 0.6, 3.0));
+        sets.push_back(gen::uniform_sparse<Cont>(engine, 300, 30000));
+        std::vector<Bitmap> bitmaps(sets.begin(), sets.end());
+
+        THEN("Bitmaps hold the same ranges and values") {
+            for (std::size_t i = 0; i < sets.size(); i++) {
+                const Bitmap &bitmap = bitmaps[i];
+                REQUIRE(std::equal(bitmap.begin(), bitmap.end(), sets[i].begin(), sets[i].end()));
+                REQUIRE(bitmap == Bitmap(sets[i].getBase()));
+                REQUIRE(bitmap.length() == sets[i].length());
+                REQUIRE(bitmap.toVector() == sets[i].toVector());
+                REQUIRE(Bitmap::fromVector(sets[i].toVector()) == bitmap);
+                for (utype value = 0; value < 40000u; value += 3u) {
+                    REQUIRE(bitmap.contains(value) == (value < Cont::mask && sets[i].contains(value)));
+                }
+
+                auto expected = sets[i].analyze();
+                auto stats = bitmap.analyze();
+                REQUIRE(stats.ranges == expected.ranges);
+                REQUIRE(stats.singletons == expected.singletons);
+                REQUIRE(stats.span == expected.span);
+                REQUIRE(stats.rangeEncodingBytes == expected.rangeEncodingBytes);
+                REQUIRE(stats.runLengths == expected.runLengths);
+                REQUIRE(stats.gapLengths == expected.gapLengths);
+            }
+        }
+
+        THEN("Word-parallel merges match the range merges") {
+            auto same = [](const Bitmap &bitmap, const Cont &cont) {
+                return std::equal(bitmap.begin(), bitmap.end(), cont.begin(), cont.end());
+            };
+            REQUIRE(same(intersect_ranges(bitmaps), intersect_ranges(sets)));
+            REQUIRE(same(unite_ranges(bitmaps), unite_ranges(sets)));
+            REQUIRE(same(subtract_ranges(bitmaps), subtract_ranges(sets)));
+            REQUIRE(same(bitmaps[0] | bitmaps[1], Cont(sets[0] | sets[1])));
+            REQUIRE(same(bitmaps[0] - bitmaps[1], Cont(sets[0] - sets[1])));
+            REQUIRE(intersect(bitmaps[0], bitmaps[1], bitmaps[2]) == intersect_ranges(bitmaps));
+            REQUIRE(unite(bitmaps[0], bitmaps[1]) == unite_ranges(std::vector<Bitmap>{bitmaps[0], bitmaps[1]}));
+            REQUIRE(same(~~bitmaps[0], sets[0]));
+            REQUIRE((~bitmaps[0] & bitmaps[0]).empty());
+            REQUIRE(intersect(bitmaps[0], sets[1]).getBase() ==
+                    intersect_ranges(std::vector<Cont>{sets[0], sets[1]}).getBase());
+        }
+    }
+
+    GIVEN("Values above the usable range of IntegralRangeVector") {
+        Bitmap set;
+        set.push_back({40000u, 65535u});
+        set.push_back(utype(7u));
+        set.push_back({5u, 7u});
+
+        THEN("Every value but the largest one is stored") {
+            REQUIRE(set.length() == 25538u);
+            REQUIRE(set.contains(65534u));
+            REQUIRE_FALSE(set.contains(65535u));
+            REQUIRE(std::vector<std::pair<utype, utype>>(set.begin(), set.end()) ==
+                    std::vector<std::pair<utype, utype>>{{5u, 8u}, {40000u, 65535u}});
+            REQUIRE((~set).length() == 65535u - set.length());
+            REQUIRE((~Bitmap()).contains(65534u));
+        }
+
+        THEN("The largest value is rejected and iteration still ends") {
+            BitmapRangeVector<uint8_t> bytes;
+            bytes.push_back(uint8_t(254u));
+            REQUIRE_THROWS_AS(bytes.push_back(uint8_t(255u)), std::out_of_range);
+            REQUIRE_THROWS_AS(set.push_back(utype(65535u)), std::out_of_range);
+            REQUIRE(std::vector<std::pair<uint8_t, uint8_t>>(bytes.begin(), bytes.end()) ==
+                    std::vector<std::pair<uint8_t, uint8_t>>{{254u, 255u}});
+            REQUIRE(set.length() == 25538u);
+        }
+    }
+}
+
+SCENARIO("Keys of signed, enum and floating-point values", "[keys]") {
+    GIVEN("Ascending values of every mapped type") {
+        std::vector<int8_t> bytes(255);
+        std::iota(bytes.begin(), bytes.end(), int8_t(-128));
+        std::vector<int64_t> wide{-(int64_t(1) << 62), -1, 0, 1, (int64_t(1) << 62) - 1};
+        std::vector<Level> levels{Level::trace, Level::debug, Level::info, Level::warning, Level::error};
+        float inf = std::numeric_limits<float>::infinity();
+        std::vector<float> floats{-inf, -1e30f, -1.5f, -1e-40f, -0.0f, 0.0f, 1e-40f, 1.0f, 1.5f, 3e38f, inf};
+
+        THEN("Keys are strictly ascending and convert back to the values") {
+            auto check = [](const auto &values) {
+                typedef typename std::decay_t<decltype(values)>::value_type K;
+                for (std::size_t i = 0; i < values.size(); i++) {
+                    auto key = key_traits<K>::to_key(values[i]);
+                    REQUIRE(key < IntegralRangeVector<key_type_t<K>>::mask);
+                    REQUIRE(std::memcmp(&values[i], &static_cast<const K &>(key_traits<K>::from_key(key)),
+                                        sizeof(K)) == 0);
+                    if (i > 0) {
+                        REQUIRE(key_traits<K>::to_key(values[i - 1]) < key);
+                    }
+                }
+            };
+            check(bytes);
+            check(wide);
+            check(levels);
+            check(floats);
+            REQUIRE(key_traits<int32_t>::to_key(std::numeric_limits<int32_t>::min()) == 0u);
+            REQUIRE(std::is_same_v<key_type_t<int16_t>, uint32_t>);
+            REQUIRE(std::is_same_v<key_type_t<Level>, uint16_t>);
+        }
+    }
+
+    GIVEN("Containers of signed values") {
+        KeyedRangeVector<int32_t> a, b;
+        a.push_back({-100, -50});
+        a.push_back(-7);
+        a.push_back({0, 10});
+        b.push_back({-60, -5});
+        b.push_back({5, std::numeric_limits<int32_t>::max()});
+
+        THEN("Ranges, values and lookups are in the domain of values") {
+            REQUIRE(std::vector<std::pair<int32_t, int32_t>>(a.begin(), a.end()) ==
+                    std::vector<std::pair<int32_t, int32_t>>{{-100, -50}, {-7, -6}, {0, 10}});
+            REQUIRE(a.length() == 61u);
+            REQUIRE(a.contains(-100));
+            REQUIRE_FALSE(a.contains(-50));
+            REQUIRE(a.contains(-7));
+            REQUIRE_FALSE(a.contains(10));
+            auto values = a.toVector();
+            REQUIRE(values.front() == -100);
+            REQUIRE(values.back() == 9);
+            REQUIRE(KeyedRangeVector<int32_t>::fromVector(values) == a);
+        }
+
+        THEN("Merges compare keys and match merges of pairs") {
+            typedef std::vector<KeyedRangeVector<int32_t>> Sets;
+            typedef std::vector<std::pair<int32_t, int32_t>> Pairs;
+            auto pairs = [](const KeyedRangeVector<int32_t> &set) { return Pairs(set.begin(), set.end()); };
+
+            REQUIRE(pairs(intersect_ranges(Sets{a, b})) == Pairs{{-60, -50}, {-7, -6}, {5, 10}});
+            REQUIRE(pairs(unite_ranges(Sets{a, b})) ==
+                    Pairs{{-100, -5}, {0, std::numeric_limits<int32_t>::max()}});
+            REQUIRE(pairs(subtract_ranges(Sets{a, b})) == Pairs{{-100, -60}, {0, 5}});
+            REQUIRE(intersect_ranges(std::vector<Pairs>{pairs(a), pairs(b)}) == pairs(intersect_ranges(Sets{a, b})));
+            REQUIRE(intersect(a, pairs(b)).getBase() == intersect_ranges(Sets{a, b}).getBase().getBase());
+        }
+    }
+
+    GIVEN("Containers of enumerations and floating-point values") {
+        KeyedRangeVector<Level> verbose;
+        verbose.push_back({Level::trace, Level::info});
+        KeyedRangeVector<float> readings;
+        readings.push_back(-2.5f);
+        readings.push_back(0.0f);
+        readings.push_back(1.25f);
+
+        THEN("Values are stored in order") {
+            REQUIRE(verbose.toVector() == std::vector<Level>{Level::trace, Level::debug});
+            REQUIRE(verbose.contains(Level::debug));
+            REQUIRE_FALSE(verbose.contains(Level::info));
+            REQUIRE(readings.toVector() == std::vector<float>{-2.5f, 0.0f, 1.25f});
+            REQUIRE(readings.contains(1.25f));
+            REQUIRE_FALSE(readings.contains(-0.0f));
+        }
+    }
+
+    GIVEN("Values outside of the domain of keys") {
+        const int64_t limit = int64_t(1) << 62;
+
+        THEN("The domain is checked without converting the values") {
+            REQUIRE(key_traits<int64_t>::in_domain(-limit));
+            REQUIRE(key_traits<int64_t>::in_domain(limit - 1));
+            REQUIRE_FALSE(key_traits<int64_t>::in_domain(limit));
+            REQUIRE_FALSE(key_traits<int64_t>::in_domain(-limit - 1));
+            REQUIRE_FALSE(key_traits<int64_t>::in_domain(std::numeric_limits<int64_t>::min()));
+            REQUIRE(key_traits<int32_t>::in_domain(std::numeric_limits<int32_t>::min()));
+            REQUIRE(key_traits<int32_t>::in_domain(std::numeric_limits<int32_t>::max()));
+            REQUIRE(key_traits<uint64_t>::in_domain(std::numeric_limits<uint64_t>::max() >> 1));
+            REQUIRE_FALSE(key_traits<uint64_t>::in_domain(std::numeric_limits<uint64_t>::max()));
+            REQUIRE(key_traits<Level>::in_domain(Level::trace));
+            REQUIRE(key_traits<float>::in_domain(std::numeric_limits<float>::quiet_NaN()));
+        }
+
+        THEN("Checked insertions reject them and lookups do not find them") {
+            KeyedRangeVector<int64_t> wide;
+            REQUIRE(wide.try_push_back({-limit, -limit + 10}));
+            REQUIRE_FALSE(wide.try_push_back({0, limit}));
+            REQUIRE_FALSE(wide.try_push_back(limit));
+            REQUIRE(wide.try_push_back(limit - 1));
+            REQUIRE(std::vector<std::pair<int64_t, int64_t>>(wide.begin(), wide.end()) ==
+                    std::vector<std::pair<int64_t, int64_t>>{{-limit, -limit + 10}, {limit - 1, limit}});
+            REQUIRE_FALSE(wide.contains(std::numeric_limits<int64_t>::min()));
+            REQUIRE_FALSE(wide.contains(limit));
+        }
+    }
+}
+
+template<typename T>
+static void require_decoded_blocks(const IntegralRangeVector<T> &set) {
+    const auto &words = set.getBase();
+    std::vector<std::pair<T, T>> ranges(set.begin(), set.end());
+    std::vector<T> begins(words.size()), ends(words.size());
+
+    for (std::size_t i = 0; i <= std::size_t(dispatch::detect_isa()); i++) {
+        const auto &kernels = dispatch::kernels_for<T>(dispatch::Isa(i));
+        std::size_t range = 0u;
+        for (std::size_t position = 0; position < words.size(); range++) {
+            // Blocks end at every offset, including in the middle of a range
+            for (std::size_t size = 0; size <= std::min<std::size_t>(words.size() - position, 40u); size++) {
+                auto block = kernels.decodeBlock(words.data() + position, size, begins.data(), ends.data());
+                bool decoded = block.words <= size && block.words + 1u >= size && block.ranges <= block.words;
+                for (std::size_t k = 0; decoded && k < block.ranges; k++) {
+                    decoded = std::make_pair(begins[k], ends[k]) == ranges[range + k];
+                }
+                REQUIRE(decoded);
+            }
+            position += (words[position] & IntegralRangeVector<T>::mask) ? 2u : 1u;
+        }
+
+        auto block = kernels.decodeBlock(words.data(), words.size(), begins.data(), ends.data());
+        REQUIRE(block.words == words.size());
+        REQUIRE(block.ranges == ranges.size());
+    }
+}
+
+SCENARIO("Block decoding", "[decode]") {
+    std::mt19937_64 engine(43);
+    dispatch::Isa active = dispatch::active_isa();
+
+    GIVEN("Range vectors mixing ranges and singletons") {
+        auto narrow = gen::with_density<IntegralRangeVector<uint32_t>>(engine, 300, 0.5, 2.0);
+        auto wide = gen::with_density<IntegralRangeVector<uint64_t>>(engine, 300, 0.3, 2.0);
+        auto small = gen::with_density<IntegralRangeVector<uint16_t>>(engine, 100, 0.5, 2.0);
+
+        THEN("Every instruction set decodes the same ranges from any block") {
+            require_decoded_blocks(narrow);
+            require_decoded_blocks(wide);
+            require_decoded_blocks(small);
+        }
+
+        THEN("The public decoder splits the words into blocks") {
+            const auto &words = narrow.getBase();
+            std::array<uint32_t, 64> begins, ends;
+            std::vector<std::pair<uint32_t, uint32_t>> decoded;
+            for (std::size_t i = 0; i < words.size();) {
+                auto block = decode_block(words.data() + i, std::min(words.size() - i, begins.size()),
+                                          begins.data(), ends.data());
+                for (std::size_t k = 0; k < block.ranges; k++) {
+                    decoded.emplace_back(begins[k], ends[k]);
+                }
+                i += block.words;
+            }
+            REQUIRE(std::equal(decoded.begin(), decoded.end(), narrow.begin(), narrow.end()));
+        }
+    }
+
+    GIVEN("Merges and statistics reading decoded blocks") {
+        typedef IntegralRangeVector<uint32_t> Cont;
+        std::vector<Cont> sets;
+        sets.push_back(gen::with_density<Cont>(engine, 400, 0.6, 3.0));
+        sets.push_back(gen::with_density<Cont>(engine, 400, 0.7, 2.0));
+        sets.push_back(gen::with_density<Cont>(engine, 400, 0.8, 1.0));
+
+        THEN("Results do not depend on the instruction set") {
+            dispatch::force_isa(dispatch::Isa::baseline);
+            Cont intersection = intersect_ranges(sets);
+            Cont together = unite_ranges(sets);
+            RangeStatistics statistics = sets[0].analyze();
+
+            for (std::size_t i = 0; i <= std::size_t(dispatch::detect_isa()); i++) {
+                REQUIRE(dispatch::force_isa(dispatch::Isa(i)));
+                REQUIRE(intersect_ranges(sets) == intersection);
+                REQUIRE(unite_ranges(sets) == together);
+                REQUIRE(intersect(sets[0], sets[1], sets[2]) == intersection);
+                RangeStatistics decoded = sets[0].analyze();
+                REQUIRE(decoded.ranges == statistics.ranges);
+                REQUIRE(decoded.singletons == statistics.singletons);
+                REQUIRE(decoded.runLengths == statistics.runLengths);
+                REQUIRE(decoded.gapLengths == statistics.gapLengths);
+            }
+            dispatch::force_isa(active);
+
+            std::vector<uint32_t> expected;
+            auto first = sets[0].toVector(), second = sets[1].toVector(), third = sets[2].toVector();
+            std::vector<uint32_t> both;
+            std::set_intersection(first.begin(), first.end(), second.begin(), second.end(), std::back_inserter(both));
+            std::set_intersection(both.begin(), both.end(), third.begin(), third.end(), std::back_inserter(expected));
+            REQUIRE(intersection.toVector() == expected);
+        }
+    }
+}
+
+SCENARIO("Benchmark comparisons", "[compare]") {
+    using namespace ranges::bench;
+
+    GIVEN("Small samples without ties") {
+        THEN("The exact distribution of U gives the p-value") {
+            REQUIRE(mann_whitney({1, 2, 3}, {4, 5, 6}) == Approx(2.0 / 20.0));
+            REQUIRE(mann_whitney({4, 5, 6}, {1, 2, 3}) == Approx(2.0 / 20.0));
+            REQUIRE(mann_whitney({1, 3, 5}, {2, 4, 6}) == Approx(14.0 / 20.0));
+            REQUIRE(mann_whitney({1, 2, 3, 4, 5}, {6, 7, 8, 9, 10}) == Approx(2.0 / 252.0));
+            REQUIRE(mann_whitney({}, {1, 2}) == 1.0);
+        }
+    }
+
+    GIVEN("Samples too large for the exact distribution") {
+        std::vector<double> odd, even;
+        for (int i = 0; i < 21; i++) {
+            odd.push_back(2 * i + 1);
+            even.push_back(2 * i + 2);
+        }
+
+        THEN("The normal approximation with continuity correction gives the p-value") {
+            // U = 210, mean 220.5, variance 21 * 21 * 43 / 12
+            REQUIRE(mann_whitney(odd, even) == Approx(0.8013832));
+        }
+    }
+
+    GIVEN("Samples with ties") {
+        THEN("Ties get mean ranks and the variance is corrected") {
+            // U = 2, variance 16 / 12 * (9 - 60 / 56)
+            REQUIRE(mann_whitney({1, 2, 3, 3}, {3, 3, 4, 5}) == Approx(0.0907236));
+            REQUIRE(mann_whitney({5, 5, 5}, {5, 5, 5}) == 1.0);
+        }
+    }
+
+    GIVEN("Samples of a case twice as fast") {
+        std::vector<double> baseline = {10, 20, 40}, current = {5, 10, 20};
+
+        THEN("The Hodges-Lehmann shift and its interval come from the pairwise ratios") {
+            // Sorted ratios are 0.5, 1, 1, 2, 2, 2, 4, 4, 8
+            auto wide = compare_samples("case", baseline, current, 0.05);
+            REQUIRE(wide.name == "case");
+            REQUIRE(wide.baseline == 20.0);
+            REQUIRE(wide.current == 10.0);
+            REQUIRE(wide.speedup == Approx(2.0));
+            REQUIRE(wide.low == Approx(0.5));
+            REQUIRE(wide.high == Approx(8.0));
+            REQUIRE(wide.verdict == "same");
+
+            auto narrow = compare_samples("case", baseline, current, 0.05, 0.5);
+            REQUIRE(narrow.speedup == Approx(2.0));
+            REQUIRE(narrow.low == Approx(1.0));
+            REQUIRE(narrow.high == Approx(4.0));
+        }
+
+        THEN("Significant changes above the threshold get a verdict") {
+            std::vector<double> slow, fast;
+            for (int i = 0; i < 10; i++) {
+                slow.push_back(200 + i);
+                fast.push_back(100 + i);
+            }
+            REQUIRE(compare_samples("case", slow, fast, 0.05).verdict == "faster");
+            REQUIRE(compare_samples("case", fast, slow, 0.05).verdict == "slower");
+            REQUIRE(compare_samples("case", slow, fast, 1.5).verdict == "same");
+        }
+    }
+
+    GIVEN("Baseline documents") {
+        THEN("Samples and context are read") {
+            std::istringstream in(R"({"context": {"host": "a\u0062c"}, "benchmarks": [
+                {"name": "merge", "samples_ns": [1.5, 2e3, -1]}, {"name": "skipped"}, {"name": "empty",
+                "samples_ns": []}]})");
+            auto baseline = read_baseline(in);
+            REQUIRE(baseline.context.at("host") == "abc");
+            REQUIRE(baseline.samples.size() == 2u);
+            REQUIRE(baseline.samples.at("merge") == std::vector<double>{1.5, 2000.0, -1.0});
+            REQUIRE(baseline.samples.at("empty").empty());
+        }
+
+        THEN("Malformed documents are rejected") {
+            for (const char *text : {"", "{", "{\"benchmarks\": [}", "{\"benchmarks\": [x]}", "[1, 2",
+                                     "{\"a\" 1}", "\"open", "\"\\uzz\"", "{} {}", "{\"benchmarks\": [1,]}",
+                                     "{\"context\": {}}"}) {
+                std::istringstream in(text);
+                REQUIRE_THROWS_AS(read_baseline(in), std::runtime_error);
+            }
+        }
     }
 }
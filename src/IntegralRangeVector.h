@@ -6,14 +6,68 @@
 #ifndef INTEGRALRANGE_INTEGRALRANGEVECTOR_H
 #define INTEGRALRANGE_INTEGRALRANGEVECTOR_H
 
+#include <algorithm>
+#include <array>
 #include <cassert>
+#include <cstdint>
 #include <limits>
+#include <memory>
 #include <optional>
 #include <utility>
 #include <vector>
 
+#include "RangeHooks.h"
+#include "RangeKernels.h"
+
 namespace ranges {
 
+    //! Structural statistics of a set of values, see IntegralRangeVector::analyze()
+    struct RangeStatistics {
+        //! Amount of histogram buckets, bucket k counts lengths in [2^k, 2^(k+1))
+        static constexpr std::size_t BUCKETS = 64u;
+
+        //! Amount of maximal ranges of values
+        std::size_t ranges = 0u;
+
+        //! Amount of ranges consisting of a single value
+        std::size_t singletons = 0u;
+
+        //! Fraction of ranges that consist of a single value
+        double singletonRatio = 0.0;
+
+        //! Amount of values in the set
+        std::size_t length = 0u;
+
+        //! Distance between the first value and the end of the last range
+        std::uint64_t span = 0u;
+
+        //! Fraction of the span covered by values
+        double density = 0.0;
+
+        //! Histogram of range lengths
+        std::array<std::size_t, BUCKETS> runLengths{};
+
+        //! Histogram of distances between ranges, bucket 0 also counts zero gaps between unmerged ranges
+        std::array<std::size_t, BUCKETS> gapLengths{};
+
+        //! Size in bytes of the range encoding used by IntegralRangeVector
+        std::size_t rangeEncodingBytes = 0u;
+
+        //! Size in bytes of a vector of begin/end pairs
+        std::size_t pairEncodingBytes = 0u;
+
+        //! Size in bytes of a sorted vector of values
+        std::size_t valueEncodingBytes = 0u;
+
+        //! Size in bytes of a bitmap covering the span
+        std::size_t bitmapEncodingBytes = 0u;
+
+        //! Returns the histogram bucket of a length
+        static constexpr std::size_t bucket(std::uint64_t length) {
+            return length == 0u ? 0u : std::size_t(63 - __builtin_clzll(length));
+        }
+    };
+
     /**
      * Class to store a set of unsigned integral values in a range format
      */
@@ -25,6 +79,13 @@ namespace ranges {
         //! Mask that is applied to the beginning and ending of the range
         static constexpr T mask = std::numeric_limits<T>::max() ^(std::numeric_limits<T>::max() >> 1);
 
+        //! Amount of words contains() counts with a vectorized kernel instead of halving them further, and the size
+        //! of the blocks it decodes from their first range boundary
+        static constexpr std::size_t LOOKUP_WINDOW = 64u;
+
+        //! Amount of words decoded at once by analyze(), toVector() and the cursors of merges, see decode_block()
+        static constexpr std::size_t DECODE_BLOCK = 64u;
+
         //! Type of value returned when iterating over the container
         typedef std::pair<T, T> value_type;
 
@@ -37,6 +98,68 @@ namespace ranges {
     private:
         std::vector<T, Allocator> _rangeVect;
         mutable std::optional<size_type> _length;
+        //! Bit b is set if the word at b * LOOKUP_WINDOW ends a range, missing bits are clear
+        std::vector<std::uint64_t, typename std::allocator_traits<Allocator>::template rebind_alloc<std::uint64_t>>
+                _blockEnds;
+#ifdef INTEGRALRANGE_RECORD
+        RecordedVersion _version;
+#endif
+
+        /*!
+         * Calls a function for the bounds of every stored range, decoding DECODE_BLOCK words at once. A masked last
+         * word is visited as a singleton.
+         */
+        template<typename Visit>
+        void decode(Visit visit) const {
+            std::array<T, DECODE_BLOCK> begins, ends;
+            auto decodeBlock = dispatch::kernels<T>().decodeBlock;
+            const T *data = _rangeVect.data();
+            const std::size_t size = _rangeVect.size();
+
+            std::size_t i = 0u;
+            while (i < size) {
+                dispatch::DecodedBlock block = decodeBlock(data + i, std::min(size - i, DECODE_BLOCK),
+                                                           begins.data(), ends.data());
+                for (std::size_t range = 0; range < block.ranges; range++) {
+                    visit(begins[range], ends[range]);
+                }
+                i += block.words;
+                if (block.words == 0u) {
+                    visit(T(data[i] & ~mask), T((data[i] & ~mask) + 1u));
+                    i++;
+                }
+            }
+        }
+
+        //! Marks the last word if it ends a range and starts a block, called after words are appended
+        void mark_back() {
+            std::size_t last = _rangeVect.size() - 1u;
+            if (last % LOOKUP_WINDOW == 0u && (_rangeVect[last] & mask)) {
+                std::size_t block = last / LOOKUP_WINDOW;
+                _blockEnds.resize(block / 64u + 1u);
+                _blockEnds[block / 64u] |= std::uint64_t(1u) << (block % 64u);
+            }
+        }
+
+        //! Marks the blocks starting with the ending of a range, called after the words are replaced
+        void mark_blocks() {
+            _blockEnds.clear();
+            for (std::size_t i = 0; i < _rangeVect.size(); i++) {
+                if ((_rangeVect[i] & mask) && i + 1u < _rangeVect.size()) {
+                    i++;
+                    if (i % LOOKUP_WINDOW == 0u) {
+                        std::size_t block = i / LOOKUP_WINDOW;
+                        _blockEnds.resize(block / 64u + 1u);
+                        _blockEnds[block / 64u] |= std::uint64_t(1u) << (block % 64u);
+                    }
+                }
+            }
+        }
+
+        //! Checks if the first word of a block ends a range
+        bool block_end(std::size_t block) const {
+            return block / 64u < _blockEnds.size() && (_blockEnds[block / 64u] >> (block % 64u)) & 1u;
+        }
 
     public:
 
@@ -156,14 +279,18 @@ namespace ranges {
          * @param vect Vector to initialize container with
          */
         IntegralRangeVector(const std::vector<T, Allocator> &vect, const Allocator& allocator = Allocator())
-                : _rangeVect(vect, allocator) {}
+                : _rangeVect(vect, allocator), _blockEnds(allocator) {
+            mark_blocks();
+        }
 
         /*!
          * Initializes container by moving a vector into the container
          * @param vect Vector to initialize container with
          */
         IntegralRangeVector(std::vector<T, Allocator> &&vect, const Allocator& allocator = Allocator())
-                : _rangeVect(std::move(vect), allocator) {}
+                : _rangeVect(std::move(vect), allocator), _blockEnds(allocator) {
+            mark_blocks();
+        }
 
         /*!
          * Initializes container by copying value range
@@ -172,11 +299,13 @@ namespace ranges {
          */
         template <typename InputIt>
         IntegralRangeVector(InputIt first, InputIt last, const Allocator& allocator = Allocator())
-                : _rangeVect(first, last, allocator) {}
+                : _rangeVect(first, last, allocator), _blockEnds(allocator) {
+            mark_blocks();
+        }
 
         //! Default constructor - creates an empty container
         IntegralRangeVector(const Allocator& allocator = Allocator())
-                : _rangeVect(allocator), _length(0u) {}
+                : _rangeVect(allocator), _length(0u), _blockEnds(allocator) {}
 
         //! Copy constructor
         IntegralRangeVector(const IntegralRangeVector &other) = default;
@@ -207,6 +336,10 @@ namespace ranges {
             assert((val.first & mask) == 0);
             assert((val.second & mask) == 0);
 
+            GrowthCounter<decltype(_rangeVect)> growth(_rangeVect);
+            GrowthCounter<decltype(_blockEnds)> blockGrowth(_blockEnds);
+            INTEGRALRANGE_RECORD_CHANGE(_version);
+
             if (_length != std::nullopt) {
                 *_length += (val.second - val.first);
             }
@@ -214,11 +347,14 @@ namespace ranges {
             if (!_rangeVect.empty() && val.second - val.first > 0) {
                 if ((_rangeVect.back() & mask) > 0 && (_rangeVect.back() & ~mask) == val.first) {
                     _rangeVect.back() = (val.second | mask);
+                    INTEGRALRANGE_STAT(coalescedMerges, 1u);
                     return;
                 }
                 else if ((_rangeVect.back() & mask) == 0 && (_rangeVect.back() & ~mask) == val.first - 1) {
                     _rangeVect.back() |= mask;
                     _rangeVect.push_back(val.second | mask);
+                    mark_back();
+                    INTEGRALRANGE_STAT(coalescedMerges, 1u);
                     return;
                 }
             }
@@ -231,6 +367,7 @@ namespace ranges {
                 default:
                     _rangeVect.push_back(val.first | mask);
                     _rangeVect.push_back(val.second | mask);
+                    mark_back();
             }
         }
 
@@ -241,6 +378,10 @@ namespace ranges {
         void push_back(typename value_type::first_type val) {
             assert((val & mask) == 0);
 
+            GrowthCounter<decltype(_rangeVect)> growth(_rangeVect);
+            GrowthCounter<decltype(_blockEnds)> blockGrowth(_blockEnds);
+            INTEGRALRANGE_RECORD_CHANGE(_version);
+
             if (_length != std::nullopt) {
                 ++(*_length);
             }
@@ -248,11 +389,14 @@ namespace ranges {
             if (!_rangeVect.empty()) {
                 if ((_rangeVect.back() & mask) > 0 && (_rangeVect.back() & ~mask) == val) {
                     _rangeVect.back() = ((val + 1) | mask);
+                    INTEGRALRANGE_STAT(coalescedMerges, 1u);
                     return;
                 }
                 else if ((_rangeVect.back() & mask) == 0 && (_rangeVect.back() & ~mask) == val - 1) {
                     _rangeVect.back() |= mask;
                     _rangeVect.push_back((val + 1) | mask);
+                    mark_back();
+                    INTEGRALRANGE_STAT(coalescedMerges, 1u);
                     return;
                 }
             }
@@ -283,17 +427,77 @@ namespace ranges {
         //! Converts the stored ranges to a vector of contiguous values
         template<typename Allocator1 = Allocator>
         std::vector<T, Allocator1> toVector(const Allocator1 allocator = Allocator1()) const {
-            std::vector<T, Allocator1> result(allocator);
-            result.reserve(_rangeVect.size());
-            for (const auto &range : *this) {
-                result.reserve(result.size() + (range.second - range.first));
-                for (auto i = range.first; i < range.second; i++) {
-                    result.push_back(i);
-                }
+            std::vector<T, Allocator1> result(length(), T(0u), allocator);
+            auto fillRun = dispatch::kernels<T>().fillRun;
+            T *out = result.data();
+            decode([&](T begin, T end) {
+                fillRun(out, begin, std::size_t(end - begin));
+                out += end - begin;
+            });
+            return result;
+        }
+
+        /*!
+         * Creates a container from strictly ascending values, runs of consecutive values are found by a kernel
+         * @param values Values to store
+         * @param allocator Allocator of the container
+         * @return Container storing the values
+         */
+        template<typename Allocator1>
+        static IntegralRangeVector fromVector(const std::vector<T, Allocator1> &values,
+                                              const Allocator &allocator = Allocator()) {
+            IntegralRangeVector result(allocator);
+            auto runLength = dispatch::kernels<T>().runLength;
+            for (std::size_t i = 0; i < values.size();) {
+                std::size_t run = runLength(values.data() + i, values.size() - i);
+                result.push_back(value_type(values[i], T(values[i] + run)));
+                i += run;
             }
             return result;
         }
 
+        /*!
+         * Checks if a value is stored in the container. The last encoded value not greater than the searched one is
+         * found with a binary search that hands the last LOOKUP_WINDOW words to a vectorized count. Whether it
+         * begins or ends a range is found by decoding its block of LOOKUP_WINDOW words from the first range boundary
+         * of the block, which is known from the marks of blocks starting with the ending of a range.
+         * @param val Value to look up
+         * @return True if the value is stored
+         */
+        bool contains(typename value_type::first_type val) const {
+            assert((val & mask) == 0);
+            INTEGRALRANGE_RECORD_LOOKUP(_rangeVect, _version, val);
+
+            const T *data = _rangeVect.data();
+            std::size_t low = 0u, high = _rangeVect.size();
+            while (high - low > LOOKUP_WINDOW) {
+                std::size_t middle = low + (high - low) / 2u;
+                if (T(data[middle] & ~mask) <= val) {
+                    low = middle + 1u;
+                }
+                else {
+                    high = middle;
+                }
+            }
+            low += dispatch::kernels<T>().countNotGreater(data + low, high - low, val);
+            if (low == 0u) {
+                return false;
+            }
+            std::size_t position = low - 1u;
+
+            if ((data[position] & mask) == 0) {
+                return data[position] == val;
+            }
+
+            std::size_t block = position / LOOKUP_WINDOW;
+            std::size_t word = block * LOOKUP_WINDOW + (block_end(block) ? 1u : 0u);
+            while (word < position) {
+                word += (data[word] & mask) ? 2u : 1u;
+            }
+            // Decoding stops at the position only if it begins a range
+            return word == position && position + 1u < _rangeVect.size() && val < T(data[position + 1u] & ~mask);
+        }
+
         //! Checks if the container is empty
         bool empty() const {
             return _rangeVect.empty();
@@ -302,16 +506,65 @@ namespace ranges {
         //! Returns an amount of individual values stored in a range container
         size_type length() const {
             if (_length == std::nullopt) {
-                _length = 0u;
-                for (const auto &range : *this) {
-                    *_length += (range.second - range.first);
-                }
+                _length = size_type(dispatch::kernels<T>().rangeLength(_rangeVect.data(), _rangeVect.size()));
             }
 
             return *_length;
         }
+
+        /*!
+         * Calculates structural statistics of the stored ranges in a single pass over the encoded values
+         * @return Range count, run and gap length histograms, span, density and sizes under different encodings
+         */
+        RangeStatistics analyze() const {
+            RangeStatistics result;
+            const std::size_t size = _rangeVect.size();
+
+            std::uint64_t length = 0u;
+            std::uint64_t first = 0u;
+            std::uint64_t previousEnd = 0u;
+
+            decode([&](std::uint64_t begin, std::uint64_t end) {
+                if (result.ranges == 0u) {
+                    first = begin;
+                }
+                else {
+                    result.gapLengths[RangeStatistics::bucket(begin - previousEnd)]++;
+                }
+                result.runLengths[RangeStatistics::bucket(end - begin)]++;
+                result.ranges++;
+                length += end - begin;
+                previousEnd = end;
+            });
+            // Every range takes two words and every singleton one
+            result.singletons = 2u * result.ranges - size;
+
+            _length = size_type(length);
+
+            result.length = size_type(length);
+            result.span = previousEnd - first;
+            result.singletonRatio = result.ranges ? double(result.singletons) / double(result.ranges) : 0.0;
+            result.density = result.span ? double(length) / double(result.span) : 0.0;
+            result.rangeEncodingBytes = size * sizeof(T);
+            result.pairEncodingBytes = result.ranges * 2u * sizeof(T);
+            result.valueEncodingBytes = result.length * sizeof(T);
+            result.bitmapEncodingBytes = std::size_t((result.span + 7u) / 8u);
+            return result;
+        }
     };
 
+// Instances for the standard unsigned types, defined by IntegralRangeInstances.cpp. Prefix is `extern` for the
+// declarations that keep other translation units from instantiating them again and empty for the definitions.
+#define INTEGRALRANGE_VECTOR_INSTANCES(prefix) \
+    prefix template class IntegralRangeVector<std::uint8_t>; \
+    prefix template class IntegralRangeVector<std::uint16_t>; \
+    prefix template class IntegralRangeVector<std::uint32_t>; \
+    prefix template class IntegralRangeVector<std::uint64_t>;
+
+#ifdef INTEGRALRANGE_EXTERN_TEMPLATES
+    INTEGRALRANGE_VECTOR_INSTANCES(extern)
+#endif
+
 }
 
 #endif // INTEGRALRANGE_INTEGRALRANGEVECTOR_H
@@ -0,0 +1,296 @@
+// Copyright 2019 Dmitry Valter
+// Copyright 2019 Sviatoslav Dmitriev
+// Distributed under the Boost Software License, Version 1.0.
+// See accompanying file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt
+
+#ifndef INTEGRALRANGE_KEYEDRANGEVECTOR_H
+#define INTEGRALRANGE_KEYEDRANGEVECTOR_H
+
+#include <cstddef>
+#include <iterator>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "IntegralRangeVector.h"
+#include "RangeKeys.h"
+#include "RangeMerger.h"
+
+namespace ranges {
+
+    template<typename K>
+    class KeyedRangeVector;
+
+    /**
+     * Iterator over the ranges of a KeyedRangeVector. Dereferencing it converts the bounds of the current range to
+     * values, while the merges read the keys through get_first() and get_last() without converting them.
+     */
+    template<typename K>
+    class KeyedRangeIterator {
+    public:
+        //! Type of values stored in the iterated container
+        typedef std::pair<K, K> value_type;
+
+        //! Reference to the stored value
+        typedef const value_type &reference;
+
+        //! Constant reference to the stored value
+        typedef const value_type &const_reference;
+
+        //! Pointer to the stored value
+        typedef const value_type *pointer;
+
+        //! Constant pointer to the stored value
+        typedef const value_type *const_pointer;
+
+        //! Difference between two iterators
+        typedef std::ptrdiff_t difference_type;
+
+        //! Iterator category
+        typedef std::input_iterator_tag iterator_category;
+
+        //! Iterator over the ranges of keys
+        typedef typename IntegralRangeVector<key_type_t<K>>::const_iterator base_iterator;
+
+    private:
+        base_iterator _base_iter;
+        mutable value_type _current_value;
+
+        explicit KeyedRangeIterator(base_iterator base_iter) : _base_iter(base_iter) {}
+
+        friend class KeyedRangeVector<K>;
+
+    public:
+
+        //! Default constructor - creates an end iterator
+        KeyedRangeIterator() = default;
+
+        //! Returns the current range of keys
+        const std::pair<key_type_t<K>, key_type_t<K>> &keys() const { return *_base_iter; }
+
+        //! Equals operator between two iterators
+        bool operator==(const KeyedRangeIterator &other) const { return _base_iter == other._base_iter; }
+
+        //! Not equals operator between two iterators
+        bool operator!=(const KeyedRangeIterator &other) const { return _base_iter != other._base_iter; }
+
+        //! Lesser than operator between two iterators
+        bool operator<(const KeyedRangeIterator &other) const { return _base_iter < other._base_iter; }
+
+        //! Greater than operator between two iterators
+        bool operator>(const KeyedRangeIterator &other) const { return _base_iter > other._base_iter; }
+
+        //! Lesser or equal operator between two iterators
+        bool operator<=(const KeyedRangeIterator &other) const { return _base_iter <= other._base_iter; }
+
+        //! Greater or equal operator between two iterators
+        bool operator>=(const KeyedRangeIterator &other) const { return _base_iter >= other._base_iter; }
+
+        //! Dereference operator
+        const_reference operator*() const {
+            _current_value = {key_traits<K>::from_key(_base_iter->first), key_traits<K>::from_key(_base_iter->second)};
+            return _current_value;
+        }
+
+        //! Member access operator
+        const_pointer operator->() const {
+            return &**this;
+        }
+
+        //! Postfix increment operator
+        KeyedRangeIterator operator++(int) {
+            KeyedRangeIterator result = *this;
+            ++_base_iter;
+            return result;
+        }
+
+        //! Prefix increment operator
+        KeyedRangeIterator &operator++() {
+            ++_base_iter;
+            return *this;
+        }
+    };
+
+    /**
+     * Range container of values that are not unsigned integers: signed integers, enumerations, floating-point
+     * values or any type key_traits are specialized for. Values are stored as their keys in an IntegralRangeVector,
+     * converted on insertion and on reads only:
+     *
+     *     KeyedRangeVector<std::int32_t> offsets;
+     *     offsets.push_back({-16, 16});
+     *     offsets.contains(-3);                                    // true
+     *     auto common = intersect_ranges(std::vector<KeyedRangeVector<std::int32_t>>{offsets, other});
+     *
+     * Merges of these containers compare keys read by get_first() and get_last() below, only the bounds of emitted
+     * ranges are converted to values and back. Every range ends with the value following its last one, so the
+     * largest value of K cannot be stored.
+     *
+     * Only values in the domain of key_traits<K>::in_domain() can be stored: 64-bit signed integers in
+     * [-2^62, 2^62) and unsigned integers with the highest bit clear. push_back() and fromVector() assert this,
+     * try_push_back() checks it in every build and contains() reports values outside of the domain as missing.
+     * Doubles cannot be stored, see key_traits.
+     */
+    template<typename K>
+    class KeyedRangeVector {
+    public:
+        //! Unsigned keys of the values
+        typedef key_type_t<K> key_type;
+
+        //! Container of the keys
+        typedef IntegralRangeVector<key_type> base_type;
+
+        //! Type of value returned when iterating over the container
+        typedef std::pair<K, K> value_type;
+
+        //! Type of value used to calculate range size
+        typedef std::size_t size_type;
+
+        //! Type that represents difference between two positions in the container
+        typedef std::ptrdiff_t difference_type;
+
+        //! Class used to iterate over range container
+        typedef KeyedRangeIterator<K> const_iterator;
+
+    private:
+        base_type _keys;
+
+    public:
+
+        //! Default constructor - creates an empty container
+        KeyedRangeVector() = default;
+
+        //! Initializes container with ranges of keys
+        explicit KeyedRangeVector(base_type keys) : _keys(std::move(keys)) {}
+
+        /*!
+         * Reserves a space in the container
+         * @param size Amount of range pairs to store in the container
+         */
+        void reserve(size_type size) { _keys.reserve(size); }
+
+        /*!
+         * Appends a value range to the end of the container
+         * @param val A value range to append
+         */
+        void push_back(value_type val) {
+            _keys.push_back({key_traits<K>::to_key(val.first), key_traits<K>::to_key(val.second)});
+        }
+
+        /*!
+         * Appends a single value to the end of the container
+         * @param val A value to append
+         */
+        void push_back(K val) { _keys.push_back(key_traits<K>::to_key(val)); }
+
+        /*!
+         * Appends a value range to the end of the container if both of its bounds have keys
+         * @param val A value range to append
+         * @return False if a bound is outside of the domain of keys, the container is left unchanged then
+         */
+        bool try_push_back(value_type val) {
+            if (!key_traits<K>::in_domain(val.first) || !key_traits<K>::in_domain(val.second)) {
+                return false;
+            }
+            push_back(val);
+            return true;
+        }
+
+        /*!
+         * Appends a single value to the end of the container if it has a key
+         * @param val A value to append
+         * @return False if the value is outside of the domain of keys, the container is left unchanged then
+         */
+        bool try_push_back(K val) {
+            if (!key_traits<K>::in_domain(val)) {
+                return false;
+            }
+            push_back(val);
+            return true;
+        }
+
+        //! Equals operator for two containers
+        bool operator==(const KeyedRangeVector &other) const { return _keys == other._keys; }
+
+        //! Not equals operator for two containers
+        bool operator!=(const KeyedRangeVector &other) const { return _keys != other._keys; }
+
+        //! Returns a constant iterator pointing to the beginning of the container
+        const_iterator cbegin() const { return const_iterator(_keys.cbegin()); }
+
+        //! Returns a constant iterator pointing to the end of the container
+        const_iterator cend() const { return const_iterator(_keys.cend()); }
+
+        //! Returns an iterator pointing to the beginning of the container
+        const_iterator begin() const { return cbegin(); }
+
+        //! Returns an iterator pointing to the end of the container
+        const_iterator end() const { return cend(); }
+
+        //! Returns the container of keys
+        const base_type &getBase() const { return _keys; }
+
+        //! Converts the stored ranges to a vector of values
+        template<typename Allocator1 = std::allocator<K>>
+        std::vector<K, Allocator1> toVector(const Allocator1 allocator = Allocator1()) const {
+            std::vector<K, Allocator1> result(allocator);
+            result.reserve(length());
+            for (const auto &range : _keys) {
+                for (key_type key = range.first; key < range.second; key++) {
+                    result.push_back(key_traits<K>::from_key(key));
+                }
+            }
+            return result;
+        }
+
+        /*!
+         * Creates a container from strictly ascending values
+         * @param values Values to store
+         * @return Container storing the values
+         */
+        template<typename Allocator1>
+        static KeyedRangeVector fromVector(const std::vector<K, Allocator1> &values) {
+            std::vector<key_type> keys(values.size());
+            for (std::size_t i = 0; i < values.size(); i++) {
+                keys[i] = key_traits<K>::to_key(values[i]);
+            }
+            return KeyedRangeVector(base_type::fromVector(keys));
+        }
+
+        //! Checks if a value is stored in the container
+        bool contains(K val) const {
+            return key_traits<K>::in_domain(val) && _keys.contains(key_traits<K>::to_key(val));
+        }
+
+        //! Checks if the container is empty
+        bool empty() const { return _keys.empty(); }
+
+        //! Returns an amount of individual values stored in a range container
+        size_type length() const { return _keys.length(); }
+
+        //! Calculates structural statistics of the stored ranges in the domain of keys
+        RangeStatistics analyze() const { return _keys.analyze(); }
+    };
+
+    //! Get the key the range on a current iterator position begins with
+    template<typename K>
+    key_type_t<K> get_first(const KeyedRangeIterator<K> &it) {
+        return it.keys().first;
+    }
+
+    //! Get the key the range on a current iterator position ends with
+    template<typename K>
+    key_type_t<K> get_last(const KeyedRangeIterator<K> &it) {
+        return it.keys().second;
+    }
+
+    //! Cursor over the keys of a KeyedRangeVector, they are decoded block by block like those of a range vector
+    template<typename K>
+    class SequenceCursor<KeyedRangeVector<K>> : public SequenceCursor<IntegralRangeVector<key_type_t<K>>> {
+    public:
+        explicit SequenceCursor(const KeyedRangeVector<K> &seq)
+                : SequenceCursor<IntegralRangeVector<key_type_t<K>>>(seq.getBase()) {}
+    };
+
+}
+
+#endif // INTEGRALRANGE_KEYEDRANGEVECTOR_H
@@ -0,0 +1,127 @@
+// Copyright 2019 Dmitry Valter
+// Copyright 2019 Sviatoslav Dmitriev
+// Distributed under the Boost Software License, Version 1.0.
+// See accompanying file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt
+
+#ifndef INTEGRALRANGE_PERFCOUNTERS_H
+#define INTEGRALRANGE_PERFCOUNTERS_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#ifdef __linux__
+#include <cstring>
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace ranges::bench {
+
+    //! Snapshot of a hardware counter
+    struct PerfReading {
+        //! Counted events
+        std::uint64_t value = 0u;
+
+        //! Time the counter was enabled
+        std::uint64_t enabled = 0u;
+
+        //! Time the counter was actually scheduled on the PMU, less than enabled if counters were multiplexed
+        std::uint64_t running = 0u;
+
+        //! Accumulates the difference between two snapshots
+        void add(const PerfReading &start, const PerfReading &stop) {
+            value += stop.value - start.value;
+            enabled += stop.enabled - start.enabled;
+            running += stop.running - start.running;
+        }
+
+        //! Amount of events extrapolated to the whole enabled time
+        double scaled() const {
+            if (running == 0u) {
+                return 0.0;
+            }
+            return double(value) * double(enabled) / double(running);
+        }
+    };
+
+    /**
+     * Hardware counters of the calling thread read with perf_event_open. Counters that cannot be opened, e.g. in
+     * containers, under restrictive perf_event_paranoid or in virtual machines without a virtualized PMU, are
+     * skipped, and available() is false if none could be opened. Counting is restricted to user space.
+     */
+    class PerfCounters {
+        std::vector<std::string> _names;
+        std::vector<int> _fds;
+
+#ifdef __linux__
+        void open(const char *name, std::uint32_t type, std::uint64_t config) {
+            perf_event_attr attr;
+            std::memset(&attr, 0, sizeof(attr));
+            attr.size = sizeof(attr);
+            attr.type = type;
+            attr.config = config;
+            attr.exclude_kernel = 1;
+            attr.exclude_hv = 1;
+            attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+            int fd = int(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+            if (fd >= 0) {
+                _names.emplace_back(name);
+                _fds.push_back(fd);
+            }
+        }
+
+        static constexpr std::uint64_t cache_miss(std::uint64_t cache) {
+            return cache | (PERF_COUNT_HW_CACHE_OP_READ << 8u) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16u);
+        }
+#endif
+
+    public:
+        //! Opens every supported counter
+        PerfCounters() {
+#ifdef __linux__
+            open("cycles", PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES);
+            open("instructions", PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS);
+            open("branch_misses", PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES);
+            open("l1d_misses", PERF_TYPE_HW_CACHE, cache_miss(PERF_COUNT_HW_CACHE_L1D));
+            open("llc_misses", PERF_TYPE_HW_CACHE, cache_miss(PERF_COUNT_HW_CACHE_LL));
+#endif
+        }
+
+        PerfCounters(const PerfCounters &) = delete;
+
+        PerfCounters &operator=(const PerfCounters &) = delete;
+
+        ~PerfCounters() {
+#ifdef __linux__
+            for (int fd : _fds) {
+                close(fd);
+            }
+#endif
+        }
+
+        //! Checks if at least one counter is available
+        bool available() const { return !_fds.empty(); }
+
+        //! Names of the available counters
+        const std::vector<std::string> &names() const { return _names; }
+
+        //! Reads all available counters, readings are in the order of names()
+        void read(std::vector<PerfReading> &readings) const {
+            readings.resize(_fds.size());
+#ifdef __linux__
+            for (std::size_t i = 0; i < _fds.size(); i++) {
+                std::uint64_t buffer[3] = {0u, 0u, 0u};
+                if (::read(_fds[i], buffer, sizeof(buffer)) == ssize_t(sizeof(buffer))) {
+                    readings[i] = {buffer[0], buffer[1], buffer[2]};
+                }
+            }
+#endif
+        }
+    };
+
+}
+
+#endif // INTEGRALRANGE_PERFCOUNTERS_H
@@ -0,0 +1,555 @@
+// Copyright 2019 Dmitry Valter
+// Copyright 2019 Sviatoslav Dmitriev
+// Distributed under the Boost Software License, Version 1.0.
+// See accompanying file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt
+
+#ifndef INTEGRALRANGE_RANGEEXPRESSION_H
+#define INTEGRALRANGE_RANGEEXPRESSION_H
+
+#include <algorithm>
+#include <cstddef>
+#include <iterator>
+#include <limits>
+#include <optional>
+#include <type_traits>
+#include <utility>
+
+#include "IntegralRangeVector.h"
+#include "RangeHooks.h"
+#include "RangeMerger.h"
+
+namespace ranges {
+
+    /*
+     * Lazy set algebra over IntegralRangeVector. Operators build a tree of expression nodes that only refer to their
+     * operands, the tree is evaluated when it is converted to a container or iterated:
+     *
+     *     IntegralRangeVector<std::uint32_t> result = (a | b) & c & ~d;
+     *
+     * Every node evaluates through a cursor that pulls ranges from the cursors of its children, so the whole tree
+     * is computed in a single sweep: every operand is read once and no intermediate containers are built.
+     * Cursors produce canonical ranges, they ascend and are neither empty, overlapping nor adjacent.
+     *
+     * Expressions keep references to their operands, so they must not outlive them. Assigning an expression
+     * to `auto` keeps references to temporaries of the full expression as well.
+     */
+    namespace expr {
+
+        //! Checks if a type is an expression node
+        template<typename Test, typename = void>
+        struct is_node : std::false_type {};
+
+        template<typename Test>
+        struct is_node<Test, std::void_t<typename Test::expression_tag>> : std::true_type {};
+
+        template<typename Test>
+        constexpr bool is_node_v = is_node<Test>::value;
+
+        /**
+         * Base of expression nodes: conversion to a container, evaluation and iteration over the result
+         * @tparam Derived Type of the node
+         * @tparam Cont Type of containers of the leaves
+         */
+        template<typename Derived, typename Cont>
+        class Node {
+        public:
+            //! Marks expression nodes
+            typedef void expression_tag;
+
+            //! Type of the container an expression is evaluated to
+            typedef Cont container_type;
+
+            //! Integral type of the values
+            typedef typename range_traits<typename Cont::value_type>::value_type range_type;
+
+            //! Type of value returned when iterating over the result
+            typedef std::pair<range_type, range_type> value_type;
+
+            /**
+             * Exclusive upper bound of values, the universe complements are taken in. It is the largest range ending
+             * an IntegralRangeVector can encode: a gap ending above it could not be stored, so a singleton of LIMIT
+             * itself is outside of the universe and is dropped by a complement.
+             */
+            static constexpr range_type LIMIT = std::numeric_limits<range_type>::max() >> 1;
+
+            /**
+             * Iterator over ranges of the result, evaluates the expression as it is advanced. The end iterator holds
+             * no cursor, so comparing against it does not read the operands. Emitted ranges are disjoint and
+             * ascending, so the current range identifies the position of an iterator that is not at the end.
+             */
+            template<typename Cursor>
+            class const_iterator {
+            public:
+                typedef Node::value_type value_type;
+                typedef const value_type &reference;
+                typedef const value_type *pointer;
+                typedef std::ptrdiff_t difference_type;
+                typedef std::input_iterator_tag iterator_category;
+
+            private:
+                std::optional<Cursor> _cursor;
+                bool _end = true;
+                value_type _current_value = {range_type(0u), range_type(0u)};
+
+                void calculate_value() {
+                    _end = !_cursor->valid();
+                    if (!_end) {
+                        _current_value = {_cursor->first(), _cursor->second()};
+                    }
+                }
+
+            public:
+                //! Creates the end iterator
+                const_iterator() = default;
+
+                //! Creates an iterator over the ranges of a cursor
+                explicit const_iterator(Cursor cursor) : _cursor(std::move(cursor)), _end(false) {
+                    calculate_value();
+                }
+
+                //! Iterators are equal when both are at the end or both are at the same range
+                bool operator==(const const_iterator &other) const {
+                    return _end == other._end && (_end || _current_value == other._current_value);
+                }
+
+                bool operator!=(const const_iterator &other) const { return !(*this == other); }
+
+                reference operator*() const { return _current_value; }
+
+                pointer operator->() const { return &_current_value; }
+
+                const_iterator &operator++() {
+                    _cursor->advance();
+                    calculate_value();
+                    return *this;
+                }
+
+                const_iterator operator++(int) {
+                    const_iterator result = *this;
+                    ++*this;
+                    return result;
+                }
+            };
+
+            //! Returns an iterator evaluating the expression
+            auto begin() const {
+                return const_iterator<decltype(self().cursor())>(self().cursor());
+            }
+
+            //! Returns the end iterator
+            auto end() const {
+                return const_iterator<decltype(self().cursor())>();
+            }
+
+            /*!
+             * Evaluates the expression
+             * @param stats Optional output of operation counters collected during the call
+             * @return Container with the result
+             */
+            Cont evaluate(OperationStats *stats = nullptr) const {
+                INTEGRALRANGE_TRACE_SCOPE("evaluate_expression", "inputs", self().leaves());
+                StatsScope statsScope(stats);
+
+                Cont result;
+                for (auto cursor = self().cursor(); cursor.valid(); cursor.advance()) {
+                    insert_back(result, {cursor.first(), cursor.second()});
+                    INTEGRALRANGE_STAT(emittedRanges, 1u);
+                }
+                return result;
+            }
+
+            //! Evaluates the expression on assignment to a container
+            operator Cont() const { return evaluate(); }
+
+        private:
+            const Derived &self() const { return static_cast<const Derived &>(*this); }
+        };
+
+        //! Operand of an expression
+        template<typename Cont>
+        class Leaf : public Node<Leaf<Cont>, Cont> {
+            const Cont *_container;
+
+        public:
+            typedef typename Node<Leaf<Cont>, Cont>::range_type range_type;
+
+            //! Reads ranges of the container, adjacent or overlapping ones are coalesced
+            class Cursor {
+                typename Cont::const_iterator _iter;
+                typename Cont::const_iterator _end;
+                range_type _first = 0u;
+                range_type _second = 0u;
+                bool _valid = false;
+
+            public:
+                explicit Cursor(const Cont &container) : _iter(container.begin()), _end(container.end()) {
+                    advance();
+                }
+
+                bool valid() const { return _valid; }
+
+                range_type first() const { return _first; }
+
+                range_type second() const { return _second; }
+
+                void advance() {
+                    _valid = false;
+                    for (; _iter != _end; ++_iter) {
+                        INTEGRALRANGE_STAT(cursorAdvances, 1u);
+                        range_type begin = get_first(_iter);
+                        range_type end = get_last(_iter);
+                        if (begin >= end) {
+                            continue;
+                        }
+                        if (_valid && begin > _second) {
+                            return;
+                        }
+                        if (!_valid) {
+                            _first = begin;
+                            _second = end;
+                            _valid = true;
+                        }
+                        else {
+                            _second = std::max(_second, end);
+                        }
+                    }
+                }
+            };
+
+            explicit Leaf(const Cont &container) : _container(&container) {}
+
+            Cursor cursor() const { return Cursor(*_container); }
+
+            std::size_t leaves() const { return 1u; }
+        };
+
+        //! Union of two expressions
+        template<typename Left, typename Right>
+        class Union : public Node<Union<Left, Right>, typename Left::container_type> {
+            Left _left;
+            Right _right;
+
+        public:
+            typedef typename Left::range_type range_type;
+
+            class Cursor {
+                decltype(std::declval<const Left &>().cursor()) _left;
+                decltype(std::declval<const Right &>().cursor()) _right;
+                range_type _first = 0u;
+                range_type _second = 0u;
+                bool _valid = false;
+
+            public:
+                Cursor(const Union &node) : _left(node._left.cursor()), _right(node._right.cursor()) {
+                    advance();
+                }
+
+                bool valid() const { return _valid; }
+
+                range_type first() const { return _first; }
+
+                range_type second() const { return _second; }
+
+                void advance() {
+                    _valid = _left.valid() || _right.valid();
+                    if (!_valid) {
+                        return;
+                    }
+                    if (!_right.valid() || (_left.valid() && _left.first() <= _right.first())) {
+                        _first = _left.first();
+                        _second = _left.second();
+                        _left.advance();
+                    }
+                    else {
+                        _first = _right.first();
+                        _second = _right.second();
+                        _right.advance();
+                    }
+
+                    // Both sides are canonical, so a range can only be extended by alternating between them
+                    for (bool extended = true; extended;) {
+                        extended = false;
+                        if (_left.valid() && _left.first() <= _second) {
+                            _second = std::max(_second, _left.second());
+                            _left.advance();
+                            extended = true;
+                        }
+                        if (_right.valid() && _right.first() <= _second) {
+                            _second = std::max(_second, _right.second());
+                            _right.advance();
+                            extended = true;
+                        }
+                    }
+                }
+            };
+
+            Union(Left left, Right right) : _left(std::move(left)), _right(std::move(right)) {}
+
+            Cursor cursor() const { return Cursor(*this); }
+
+            std::size_t leaves() const { return _left.leaves() + _right.leaves(); }
+        };
+
+        //! Intersection of two expressions
+        template<typename Left, typename Right>
+        class Intersection : public Node<Intersection<Left, Right>, typename Left::container_type> {
+            Left _left;
+            Right _right;
+
+        public:
+            typedef typename Left::range_type range_type;
+
+            class Cursor {
+                decltype(std::declval<const Left &>().cursor()) _left;
+                decltype(std::declval<const Right &>().cursor()) _right;
+                range_type _first = 0u;
+                range_type _second = 0u;
+                bool _valid = false;
+
+            public:
+                Cursor(const Intersection &node) : _left(node._left.cursor()), _right(node._right.cursor()) {
+                    advance();
+                }
+
+                bool valid() const { return _valid; }
+
+                range_type first() const { return _first; }
+
+                range_type second() const { return _second; }
+
+                void advance() {
+                    while (_left.valid() && _right.valid()) {
+                        range_type begin = std::max(_left.first(), _right.first());
+                        range_type end = std::min(_left.second(), _right.second());
+                        range_type leftEnd = _left.second();
+                        range_type rightEnd = _right.second();
+                        if (leftEnd <= rightEnd) {
+                            _left.advance();
+                        }
+                        if (rightEnd <= leftEnd) {
+                            _right.advance();
+                        }
+                        if (begin < end) {
+                            _first = begin;
+                            _second = end;
+                            _valid = true;
+                            return;
+                        }
+                    }
+                    _valid = false;
+                }
+            };
+
+            Intersection(Left left, Right right) : _left(std::move(left)), _right(std::move(right)) {}
+
+            Cursor cursor() const { return Cursor(*this); }
+
+            std::size_t leaves() const { return _left.leaves() + _right.leaves(); }
+        };
+
+        //! Values of the left expression that are not in the right one
+        template<typename Left, typename Right>
+        class Difference : public Node<Difference<Left, Right>, typename Left::container_type> {
+            Left _left;
+            Right _right;
+
+        public:
+            typedef typename Left::range_type range_type;
+
+            class Cursor {
+                decltype(std::declval<const Left &>().cursor()) _left;
+                decltype(std::declval<const Right &>().cursor()) _right;
+                range_type _first = 0u;
+                range_type _second = 0u;
+                bool _valid = false;
+
+                // Part of the current left range that is not processed yet
+                range_type _restBegin = 0u;
+                range_type _restEnd = 0u;
+                bool _rest = false;
+
+            public:
+                Cursor(const Difference &node) : _left(node._left.cursor()), _right(node._right.cursor()) {
+                    advance();
+                }
+
+                bool valid() const { return _valid; }
+
+                range_type first() const { return _first; }
+
+                range_type second() const { return _second; }
+
+                void advance() {
+                    for (;;) {
+                        if (!_rest) {
+                            if (!_left.valid()) {
+                                _valid = false;
+                                return;
+                            }
+                            _restBegin = _left.first();
+                            _restEnd = _left.second();
+                            _rest = true;
+                            _left.advance();
+                        }
+
+                        while (_right.valid() && _right.second() <= _restBegin) {
+                            _right.advance();
+                        }
+
+                        if (!_right.valid() || _right.first() >= _restEnd) {
+                            _first = _restBegin;
+                            _second = _restEnd;
+                            _valid = true;
+                            _rest = false;
+                            return;
+                        }
+
+                        // The subtracted range may cut the next left range too, so it is kept until it ends
+                        range_type cutBegin = _right.first();
+                        range_type begin = _restBegin;
+                        _restBegin = _right.second();
+                        _rest = _restBegin < _restEnd;
+                        if (cutBegin > begin) {
+                            _first = begin;
+                            _second = cutBegin;
+                            _valid = true;
+                            return;
+                        }
+                    }
+                }
+            };
+
+            Difference(Left left, Right right) : _left(std::move(left)), _right(std::move(right)) {}
+
+            Cursor cursor() const { return Cursor(*this); }
+
+            std::size_t leaves() const { return _left.leaves() + _right.leaves(); }
+        };
+
+        //! Values below Node::LIMIT that are not in an expression, see Node::LIMIT for the domain
+        template<typename Operand>
+        class Complement : public Node<Complement<Operand>, typename Operand::container_type> {
+            Operand _operand;
+
+        public:
+            typedef typename Operand::range_type range_type;
+
+            class Cursor {
+                decltype(std::declval<const Operand &>().cursor()) _operand;
+                range_type _first = 0u;
+                range_type _second = 0u;
+                bool _valid = false;
+
+                // Beginning of the next gap, the last gap ends at the limit
+                range_type _next = 0u;
+                bool _last = false;
+
+            public:
+                explicit Cursor(const Complement &node) : _operand(node._operand.cursor()) {
+                    advance();
+                }
+
+                bool valid() const { return _valid; }
+
+                range_type first() const { return _first; }
+
+                range_type second() const { return _second; }
+
+                void advance() {
+                    while (!_last) {
+                        _first = _next;
+                        if (_operand.valid()) {
+                            _second = _operand.first();
+                            _next = _operand.second();
+                            _operand.advance();
+                        }
+                        else {
+                            _second = Complement::LIMIT;
+                            _last = true;
+                        }
+                        if (_first < _second) {
+                            _valid = true;
+                            return;
+                        }
+                    }
+                    _valid = false;
+                }
+            };
+
+            explicit Complement(Operand operand) : _operand(std::move(operand)) {}
+
+            Cursor cursor() const { return Cursor(*this); }
+
+            std::size_t leaves() const { return _operand.leaves(); }
+
+            //! Returns the complemented expression
+            const Operand &operand() const { return _operand; }
+        };
+
+        //! Checks if a type can be an operand of the operators: a range vector or an expression node
+        template<typename Operand>
+        struct is_operand : is_node<Operand> {};
+
+        template<typename T, typename Allocator>
+        struct is_operand<IntegralRangeVector<T, Allocator>> : std::true_type {};
+
+        template<typename Left, typename Right>
+        constexpr bool are_operands_v = is_operand<std::decay_t<Left>>::value && is_operand<std::decay_t<Right>>::value;
+
+        //! Wraps a range vector into a leaf, nodes are returned unchanged
+        template<typename Operand>
+        auto node(const Operand &operand) {
+            if constexpr (is_node_v<Operand>) {
+                return operand;
+            }
+            else {
+                return Leaf<Operand>(operand);
+            }
+        }
+
+        template<typename Operand>
+        using node_t = decltype(node(std::declval<const Operand &>()));
+
+        template<typename Left, typename Right>
+        void check_operands() {
+            static_assert(std::is_same_v<typename node_t<Left>::container_type, typename node_t<Right>::container_type>,
+                          "operands of an expression must be containers of the same type");
+        }
+    }
+
+    //! Builds a lazy union of two range vectors or expressions
+    template<typename Left, typename Right, std::enable_if_t<expr::are_operands_v<Left, Right>, bool> = true>
+    auto operator|(const Left &left, const Right &right) {
+        expr::check_operands<Left, Right>();
+        return expr::Union<expr::node_t<Left>, expr::node_t<Right>>(expr::node(left), expr::node(right));
+    }
+
+    //! Builds a lazy intersection of two range vectors or expressions
+    template<typename Left, typename Right, std::enable_if_t<expr::are_operands_v<Left, Right>, bool> = true>
+    auto operator&(const Left &left, const Right &right) {
+        expr::check_operands<Left, Right>();
+        return expr::Intersection<expr::node_t<Left>, expr::node_t<Right>>(expr::node(left), expr::node(right));
+    }
+
+    //! Intersection with a complement is evaluated as a difference, without walking the gaps of the complement
+    template<typename Left, typename Right, std::enable_if_t<expr::are_operands_v<Left, Right>, bool> = true>
+    auto operator&(const Left &left, const expr::Complement<Right> &right) {
+        expr::check_operands<Left, Right>();
+        return expr::Difference<expr::node_t<Left>, Right>(expr::node(left), right.operand());
+    }
+
+    //! Builds a lazy difference of two range vectors or expressions
+    template<typename Left, typename Right, std::enable_if_t<expr::are_operands_v<Left, Right>, bool> = true>
+    auto operator-(const Left &left, const Right &right) {
+        expr::check_operands<Left, Right>();
+        return expr::Difference<expr::node_t<Left>, expr::node_t<Right>>(expr::node(left), expr::node(right));
+    }
+
+    //! Builds a lazy complement of a range vector or an expression, values are taken below Node::LIMIT
+    template<typename Operand, std::enable_if_t<expr::is_operand<Operand>::value, bool> = true>
+    auto operator~(const Operand &operand) {
+        return expr::Complement<expr::node_t<Operand>>(expr::node(operand));
+    }
+}
+
+#endif // INTEGRALRANGE_RANGEEXPRESSION_H
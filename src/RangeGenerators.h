@@ -0,0 +1,308 @@
+// Copyright 2019 Dmitry Valter
+// Copyright 2019 Sviatoslav Dmitriev
+// Distributed under the Boost Software License, Version 1.0.
+// See accompanying file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt
+
+#ifndef INTEGRALRANGE_RANGEGENERATORS_H
+#define INTEGRALRANGE_RANGEGENERATORS_H
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <random>
+#include <vector>
+
+#include "RangeMerger.h"
+
+namespace ranges::gen {
+
+    //! Integral type of the values stored in a container (plain values or ranges described by range_traits)
+    template<typename Cont, typename = void>
+    struct range_value {
+        typedef typename Cont::value_type type;
+    };
+
+    template<typename Cont>
+    struct range_value<Cont, std::enable_if_t<is_range_v<typename Cont::value_type>>> {
+        typedef typename range_traits<typename Cont::value_type>::value_type type;
+    };
+
+    template<typename Cont>
+    using range_value_t = typename range_value<Cont>::type;
+
+    /*!
+     * Exclusive upper bound of generated values. Values are kept below the range mask of the type so that every
+     * generated set can be stored in an IntegralRangeVector as well as in plain containers.
+     */
+    template<typename T>
+    constexpr std::uint64_t value_limit() {
+        return std::uint64_t(std::numeric_limits<T>::max() >> 1);
+    }
+
+    /**
+     * Zipf distribution over [1, n]: P(k) is proportional to 1 / k^s
+     */
+    template<typename IntType = std::uint64_t>
+    class zipf_distribution {
+        std::vector<double> _cdf;
+
+    public:
+        //! Type of generated values
+        typedef IntType result_type;
+
+        /*!
+         * Creates a distribution
+         * @param n Largest value that can be generated
+         * @param s Exponent, larger values make small results more likely
+         */
+        zipf_distribution(IntType n, double s) : _cdf(n) {
+            assert(n > 0);
+            double sum = 0;
+            for (IntType k = 0; k < n; k++) {
+                sum += 1.0 / std::pow(double(k + 1), s);
+                _cdf[k] = sum;
+            }
+            for (auto &value : _cdf) {
+                value /= sum;
+            }
+        }
+
+        //! Generates a value
+        template<typename Engine>
+        IntType operator()(Engine &engine) const {
+            double u = std::uniform_real_distribution<double>(0.0, 1.0)(engine);
+            auto pos = std::lower_bound(_cdf.begin(), _cdf.end(), u);
+            return IntType(std::min<std::ptrdiff_t>(pos - _cdf.begin(), _cdf.size() - 1) + 1);
+        }
+
+        //! Largest value that can be generated
+        IntType max() const { return IntType(_cdf.size()); }
+    };
+
+    /*!
+     * Generates ranges whose run and gap lengths are drawn from the given distributions
+     * @tparam Cont Output container type
+     * @param engine Random number engine
+     * @param ranges Amount of ranges to generate, less are generated if the value limit is reached
+     * @param run Distribution of run lengths, results are clamped to at least 1
+     * @param gap Distribution of gap lengths, results are clamped to at least 1 so runs never coalesce
+     * @param start First value of the first run
+     * @return Generated set
+     */
+    template<typename Cont, typename Engine, typename RunDist, typename GapDist>
+    Cont runs(Engine &engine, std::size_t ranges, RunDist run, GapDist gap, std::uint64_t start = 0u) {
+        typedef range_value_t<Cont> value_type;
+        constexpr auto LIMIT = value_limit<value_type>();
+
+        Cont result;
+        std::uint64_t position = start;
+        for (std::size_t i = 0; i < ranges; i++) {
+            std::uint64_t end = position + std::max<std::uint64_t>(1u, std::uint64_t(run(engine)));
+            if (end > LIMIT || end < position) {
+                break;
+            }
+            insert_back(result, {value_type(position), value_type(end)});
+            position = end + std::max<std::uint64_t>(1u, std::uint64_t(gap(engine)));
+        }
+        return result;
+    }
+
+    /*!
+     * Generates distinct values uniformly distributed over [0, universe)
+     * @tparam Cont Output container type
+     * @param engine Random number engine
+     * @param count Amount of values to generate
+     * @param universe Exclusive upper bound of the values
+     * @return Generated set, adjacent values are coalesced into ranges by range containers
+     */
+    template<typename Cont, typename Engine>
+    Cont uniform_sparse(Engine &engine, std::size_t count, std::uint64_t universe) {
+        typedef range_value_t<Cont> value_type;
+        universe = std::min(universe, value_limit<value_type>());
+        count = std::size_t(std::min<std::uint64_t>(count, universe));
+
+        std::vector<std::uint64_t> values;
+        values.reserve(count);
+        std::uniform_int_distribution<std::uint64_t> dist(0u, universe - 1);
+        while (values.size() < count) {
+            while (values.size() < count) {
+                values.push_back(dist(engine));
+            }
+            std::sort(values.begin(), values.end());
+            values.erase(std::unique(values.begin(), values.end()), values.end());
+        }
+
+        Cont result;
+        for (auto value : values) {
+            insert_back(result, {value_type(value), value_type(value + 1u)});
+        }
+        return result;
+    }
+
+    /*!
+     * Generates long runs separated by short gaps, both geometrically distributed
+     * @tparam Cont Output container type
+     * @param engine Random number engine
+     * @param ranges Amount of ranges to generate
+     * @param meanRun Mean run length
+     * @param meanGap Mean gap length
+     * @return Generated set
+     */
+    template<typename Cont, typename Engine>
+    Cont dense_runs(Engine &engine, std::size_t ranges, double meanRun, double meanGap) {
+        // Geometric distribution counts failures, shifting it by one makes the mean 1/p
+        auto shifted = [](double mean) {
+            return [dist = std::geometric_distribution<std::uint64_t>(1.0 / std::max(1.0, mean))](
+                    Engine &e) mutable { return dist(e) + 1u; };
+        };
+        return runs<Cont>(engine, ranges, shifted(meanRun), shifted(meanGap));
+    }
+
+    /*!
+     * Generates a set of given density, i.e. covering the given fraction of its span
+     * @tparam Cont Output container type
+     * @param engine Random number engine
+     * @param ranges Amount of ranges to generate
+     * @param density Covered fraction of the span, in (0, 1)
+     * @param meanRun Mean run length
+     * @return Generated set
+     */
+    template<typename Cont, typename Engine>
+    Cont with_density(Engine &engine, std::size_t ranges, double density, double meanRun) {
+        return dense_runs<Cont>(engine, ranges, meanRun, meanRun * (1.0 - density) / density);
+    }
+
+    /*!
+     * Generates bursts of values: clusters of uniformly distributed values separated by large empty regions
+     * @tparam Cont Output container type
+     * @param engine Random number engine
+     * @param clusters Amount of clusters
+     * @param clusterSpan Size of the region occupied by a cluster
+     * @param clusterFill Fraction of the cluster region occupied by values
+     * @param meanDistance Mean distance between the clusters
+     * @return Generated set
+     */
+    template<typename Cont, typename Engine>
+    Cont clustered(Engine &engine, std::size_t clusters, std::uint64_t clusterSpan, double clusterFill,
+                   double meanDistance) {
+        typedef range_value_t<Cont> value_type;
+        constexpr auto LIMIT = value_limit<value_type>();
+
+        std::geometric_distribution<std::uint64_t> distance(1.0 / std::max(1.0, meanDistance));
+        std::bernoulli_distribution fill(clusterFill);
+
+        Cont result;
+        std::uint64_t position = 0u;
+        for (std::size_t c = 0; c < clusters; c++) {
+            position += 1u + distance(engine);
+            if (position + clusterSpan > LIMIT) {
+                break;
+            }
+            for (std::uint64_t i = 0; i < clusterSpan; i++) {
+                if (fill(engine)) {
+                    auto value = value_type(position + i);
+                    insert_back(result, {value, value_type(value + 1u)});
+                }
+            }
+            position += clusterSpan;
+        }
+        return result;
+    }
+
+    /*!
+     * Generates ranges with heavy-tailed run and gap lengths: most runs and gaps are short, some are very long
+     * @tparam Cont Output container type
+     * @param engine Random number engine
+     * @param ranges Amount of ranges to generate
+     * @param runExponent Zipf exponent of run lengths
+     * @param maxRun Longest possible run
+     * @param gapExponent Zipf exponent of gap lengths
+     * @param maxGap Longest possible gap
+     * @return Generated set
+     */
+    template<typename Cont, typename Engine>
+    Cont zipf_runs(Engine &engine, std::size_t ranges, double runExponent, std::uint64_t maxRun,
+                   double gapExponent, std::uint64_t maxGap) {
+        return runs<Cont>(engine, ranges, zipf_distribution<std::uint64_t>(maxRun, runExponent),
+                          zipf_distribution<std::uint64_t>(maxGap, gapExponent));
+    }
+
+    /*!
+     * Generates an adversarial pattern: singletons and two-value runs alternate with one-value gaps, so every
+     * range switches the encoding and no two ranges coalesce. Sets with different phases interleave without
+     * intersecting, which makes merges advance on every step.
+     * @tparam Cont Output container type
+     * @param ranges Amount of ranges to generate
+     * @param phase Offset of the first value
+     * @param stride Distance between beginnings of consecutive ranges, at least 3
+     * @return Generated set
+     */
+    template<typename Cont>
+    Cont alternating(std::size_t ranges, std::uint64_t phase = 0u, std::uint64_t stride = 3u) {
+        typedef range_value_t<Cont> value_type;
+        constexpr auto LIMIT = value_limit<value_type>();
+        assert(stride >= 3u);
+
+        Cont result;
+        for (std::size_t i = 0; i < ranges; i++) {
+            std::uint64_t begin = phase + i * stride;
+            std::uint64_t end = begin + 1u + (i % 2u);
+            if (end > LIMIT) {
+                break;
+            }
+            insert_back(result, {value_type(begin), value_type(end)});
+        }
+        return result;
+    }
+
+    /*!
+     * Generates a family of correlated sets. A base set of geometrically distributed runs is generated first,
+     * then every member keeps each base range with probability overlap and otherwise places an independent range
+     * into the gap that follows it. Two members thus share about overlap^2 of their ranges.
+     * @tparam Cont Output container type
+     * @param engine Random number engine
+     * @param members Amount of sets in the family
+     * @param ranges Amount of ranges in the base set
+     * @param meanRun Mean run length of the base set
+     * @param meanGap Mean gap length of the base set
+     * @param overlap Probability of a member to keep a base range, in [0, 1]
+     * @return Generated sets
+     */
+    template<typename Cont, typename Engine>
+    std::vector<Cont> correlated_family(Engine &engine, std::size_t members, std::size_t ranges, double meanRun,
+                                        double meanGap, double overlap) {
+        typedef range_value_t<Cont> value_type;
+
+        auto base = dense_runs<std::vector<std::pair<value_type, value_type>>>(engine, ranges, meanRun, meanGap);
+        std::bernoulli_distribution keep(overlap);
+
+        std::vector<Cont> result(members);
+        for (auto &member : result) {
+            for (std::size_t i = 0; i < base.size(); i++) {
+                if (keep(engine)) {
+                    insert_back(member, base[i]);
+                    continue;
+                }
+
+                // Independent range strictly inside the gap, so it never touches the neighbouring base ranges
+                std::uint64_t gapBegin = std::uint64_t(base[i].second) + 1u;
+                std::uint64_t gapEnd = i + 1 < base.size() ? std::uint64_t(base[i + 1].first) - 1u
+                                                           : gapBegin + std::uint64_t(meanGap);
+                gapEnd = std::min(gapEnd, value_limit<value_type>());
+                if (gapEnd <= gapBegin) {
+                    continue;
+                }
+                std::uniform_int_distribution<std::uint64_t> pos(gapBegin, gapEnd - 1u);
+                auto a = pos(engine);
+                auto b = pos(engine);
+                insert_back(member, {value_type(std::min(a, b)), value_type(std::max(a, b) + 1u)});
+            }
+        }
+        return result;
+    }
+
+}
+
+#endif // INTEGRALRANGE_RANGEGENERATORS_H
@@ -0,0 +1,58 @@
+// Copyright 2019 Dmitry Valter
+// Copyright 2019 Sviatoslav Dmitriev
+// Distributed under the Boost Software License, Version 1.0.
+// See accompanying file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt
+
+#ifndef INTEGRALRANGE_RANGEHOOKS_H
+#define INTEGRALRANGE_RANGEHOOKS_H
+
+/*
+ * Instrumentation hooks of the containers and merges. Tracing and recording pull in their headers only when they
+ * are compiled in, so a default build of the core headers does not depend on streams, threads or atomics.
+ */
+
+#include "RangeStats.h"
+
+#ifdef INTEGRALRANGE_TRACE
+#include "RangeTrace.h"
+#endif
+
+#ifdef INTEGRALRANGE_RECORD
+#include "RangeRecorder.h"
+#endif
+
+/*!
+ * Records a span covering the rest of the enclosing scope, with an optional named integer argument. Spans are
+ * compiled in only when INTEGRALRANGE_TRACE is defined and recorded only between start_tracing() and
+ * stop_tracing(), otherwise the macro expands to nothing.
+ */
+#ifdef INTEGRALRANGE_TRACE
+#define INTEGRALRANGE_TRACE_CONCAT_(a, b) a##b
+#define INTEGRALRANGE_TRACE_CONCAT(a, b) INTEGRALRANGE_TRACE_CONCAT_(a, b)
+#define INTEGRALRANGE_TRACE_SCOPE(...) \
+    ::ranges::TraceSpan INTEGRALRANGE_TRACE_CONCAT(integralRangeTraceSpan, __LINE__)(__VA_ARGS__)
+#else
+#define INTEGRALRANGE_TRACE_SCOPE(...) ((void) 0)
+#endif
+
+/*!
+ * Records a merge of the operands of the enclosing function or a lookup in a set, see Recorder. Calls are
+ * compiled in only when INTEGRALRANGE_RECORD is defined and recorded only between start_recording() and
+ * stop_recording(), otherwise the macros expand to nothing. A lookup also takes the RecordedVersion of the set,
+ * which the set renews with INTEGRALRANGE_RECORD_CHANGE on every change.
+ */
+#ifdef INTEGRALRANGE_RECORD
+#define INTEGRALRANGE_RECORD_CONCAT_(a, b) a##b
+#define INTEGRALRANGE_RECORD_CONCAT(a, b) INTEGRALRANGE_RECORD_CONCAT_(a, b)
+#define INTEGRALRANGE_RECORD_MERGE(operation, ranges) \
+    ::ranges::RecordedMerge INTEGRALRANGE_RECORD_CONCAT(integralRangeRecordedCall, __LINE__)(operation, ranges)
+#define INTEGRALRANGE_RECORD_LOOKUP(words, version, value) \
+    ::ranges::RecordedLookup INTEGRALRANGE_RECORD_CONCAT(integralRangeRecordedCall, __LINE__)(words, version, value)
+#define INTEGRALRANGE_RECORD_CHANGE(version) (version).renew()
+#else
+#define INTEGRALRANGE_RECORD_MERGE(operation, ranges) ((void) 0)
+#define INTEGRALRANGE_RECORD_LOOKUP(words, version, value) ((void) 0)
+#define INTEGRALRANGE_RECORD_CHANGE(version) ((void) 0)
+#endif
+
+#endif //INTEGRALRANGE_RANGEHOOKS_H
@@ -0,0 +1,667 @@
+// Copyright 2019 Dmitry Valter
+// Copyright 2019 Sviatoslav Dmitriev
+// Distributed under the Boost Software License, Version 1.0.
+// See accompanying file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt
+
+#ifndef INTEGRALRANGE_RANGEKERNELS_H
+#define INTEGRALRANGE_RANGEKERNELS_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+
+// Kernels are compiled for several instruction sets with target attributes where the compiler supports them
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+#define INTEGRALRANGE_X86_DISPATCH 1
+#define INTEGRALRANGE_TARGET(isa) __attribute__((target(isa)))
+#define INTEGRALRANGE_INLINE inline __attribute__((always_inline))
+#include <immintrin.h>
+#else
+#define INTEGRALRANGE_X86_DISPATCH 0
+#define INTEGRALRANGE_TARGET(isa)
+#define INTEGRALRANGE_INLINE inline
+#endif
+
+/**
+ * Kernels over encoded words and sorted values with run-time selection of the instruction set. Every kernel is
+ * written once as a loop the compiler can vectorize and compiled for every supported instruction set, except for the
+ * block decoder that is written with intrinsics. The best instruction set the CPU supports is bound on first use.
+ * The selection can be forced with the INTEGRALRANGE_ISA environment variable (baseline, sse4.2, avx2 or avx512)
+ * or with force_isa(), e.g. to test every path on one machine.
+ */
+namespace ranges::dispatch {
+
+    //! Instruction sets kernels are compiled for, in the order of preference
+    enum class Isa : std::uint8_t {
+        //! Flags the program is built with
+        baseline = 0,
+        //! SSE4.2 and POPCNT
+        sse42 = 1,
+        //! AVX2, BMI1 and BMI2
+        avx2 = 2,
+        //! AVX-512 F, BW and VL in addition to avx2
+        avx512 = 3,
+    };
+
+    //! Amount of instruction sets
+    constexpr std::size_t ISA_COUNT = 4u;
+
+    //! Returns the name of an instruction set as accepted by INTEGRALRANGE_ISA
+    inline const char *isa_name(Isa isa) {
+        switch (isa) {
+            case Isa::sse42:
+                return "sse4.2";
+            case Isa::avx2:
+                return "avx2";
+            case Isa::avx512:
+                return "avx512";
+            default:
+                return "baseline";
+        }
+    }
+
+    //! Returns the best instruction set supported by the CPU
+    inline Isa detect_isa() {
+        static const Isa detected = [] {
+#if INTEGRALRANGE_X86_DISPATCH
+            __builtin_cpu_init();
+            bool avx2 = __builtin_cpu_supports("avx2") && __builtin_cpu_supports("bmi") &&
+                        __builtin_cpu_supports("bmi2");
+            if (avx2 && __builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw") &&
+                __builtin_cpu_supports("avx512vl")) {
+                return Isa::avx512;
+            }
+            if (avx2) {
+                return Isa::avx2;
+            }
+            if (__builtin_cpu_supports("sse4.2") && __builtin_cpu_supports("popcnt")) {
+                return Isa::sse42;
+            }
+#endif
+            return Isa::baseline;
+        }();
+        return detected;
+    }
+
+    //! Storage of the bound instruction set, INTEGRALRANGE_ISA is applied on first use
+    inline std::atomic<Isa> &bound_isa() {
+        static std::atomic<Isa> isa([] {
+            Isa result = detect_isa();
+            if (const char *name = std::getenv("INTEGRALRANGE_ISA")) {
+                for (std::size_t i = 0; i < ISA_COUNT; i++) {
+                    if (std::strcmp(name, isa_name(Isa(i))) == 0 && Isa(i) < result) {
+                        result = Isa(i);
+                    }
+                }
+            }
+            return result;
+        }());
+        return isa;
+    }
+
+    //! Returns the instruction set kernels are bound to
+    inline Isa active_isa() {
+        return bound_isa().load(std::memory_order_relaxed);
+    }
+
+    /*!
+     * Binds kernels to another instruction set. Calls that are already running finish with the previous kernels.
+     * @param isa Instruction set to use
+     * @return False if the CPU does not support the instruction set, the binding is not changed then
+     */
+    inline bool force_isa(Isa isa) {
+        if (isa > detect_isa()) {
+            return false;
+        }
+        bound_isa().store(isa, std::memory_order_relaxed);
+        return true;
+    }
+
+    //! Mask bit of the encoded words, see IntegralRangeVector::mask
+    template<typename T>
+    constexpr T word_mask() {
+        return T(std::numeric_limits<T>::max() ^ (std::numeric_limits<T>::max() >> 1));
+    }
+
+    //! Counts set bits of a word, compiled to POPCNT where the instruction set has it
+    INTEGRALRANGE_INLINE unsigned bit_count(std::uint64_t word) {
+#if defined(__GNUC__) || defined(__clang__)
+        return unsigned(__builtin_popcountll(word));
+#else
+        word = word - ((word >> 1u) & 0x5555555555555555u);
+        word = (word & 0x3333333333333333u) + ((word >> 2u) & 0x3333333333333333u);
+        word = (word + (word >> 4u)) & 0x0f0f0f0f0f0f0f0fu;
+        return unsigned((word * 0x0101010101010101u) >> 56u);
+#endif
+    }
+
+    //! Returns the index of the lowest set bit of a non-zero word
+    INTEGRALRANGE_INLINE unsigned lowest_bit(std::uint64_t word) {
+#if defined(__GNUC__) || defined(__clang__)
+        return unsigned(__builtin_ctzll(word));
+#else
+        return bit_count((word & (0u - word)) - 1u);
+#endif
+    }
+
+    /*!
+     * Counts encoded words whose value is not greater than the given one. In a window of an ascending encoding
+     * that is the offset std::upper_bound() would return, but found without branches.
+     */
+    template<typename T>
+    INTEGRALRANGE_INLINE std::size_t count_not_greater_generic(const T *words, std::size_t size, T value) {
+        std::size_t result = 0u;
+        for (std::size_t i = 0; i < size; i++) {
+            result += T(words[i] & T(~word_mask<T>())) <= value;
+        }
+        return result;
+    }
+
+    //! Calculates the amount of values stored by an encoding range by range, the words have to begin a range
+    template<typename T>
+    INTEGRALRANGE_INLINE std::uint64_t range_length_sequential(const T *words, std::size_t size) {
+        std::uint64_t result = 0u;
+        for (std::size_t i = 0; i < size; i++) {
+            if (words[i] & word_mask<T>()) {
+                result += std::uint64_t(T(words[i + 1] & T(~word_mask<T>()))) -
+                          std::uint64_t(T(words[i] & T(~word_mask<T>())));
+                i++;
+            }
+            else {
+                result++;
+            }
+        }
+        return result;
+    }
+
+    /*!
+     * Calculates the amount of values stored by an encoding without branches. Masked words come in pairs, so a
+     * masked word ends a range when an odd amount of masked words precedes it. That parity is carried between
+     * blocks of 64 words and found inside a block with a prefix XOR of the mask bits, which leaves loops without
+     * dependencies between words. It only beats range_length_sequential() with 256-bit vectors and wider.
+     */
+    template<typename T>
+    INTEGRALRANGE_INLINE std::uint64_t range_length_generic(const T *words, std::size_t size) {
+        constexpr std::size_t BLOCK = 64u;
+        constexpr unsigned SHIFT = std::numeric_limits<T>::digits - 1u;
+        std::uint64_t result = 0u;
+        std::uint64_t parity = 0u;
+
+        std::size_t i = 0;
+        for (; i + BLOCK <= size; i += BLOCK) {
+            std::uint64_t flags = 0u;
+            for (std::size_t j = 0; j < BLOCK; j++) {
+                flags |= std::uint64_t(words[i + j] >> SHIFT) << j;
+            }
+            std::uint64_t preceding = flags << 1u;
+            for (unsigned step = 1u; step < BLOCK; step *= 2u) {
+                preceding ^= preceding << step;
+            }
+            std::uint64_t ends = preceding ^ (std::uint64_t(0u) - parity);
+            parity ^= std::uint64_t(__builtin_popcountll(flags) & 1);
+
+            // Beginnings are subtracted and endings added modulo 2^64, singletons count as one value
+            std::uint64_t sum = 0u;
+            for (std::size_t j = 0; j < BLOCK; j++) {
+                std::uint64_t value = std::uint64_t(words[i + j] & T(~word_mask<T>()));
+                std::uint64_t masked = (flags >> j) & 1u;
+                std::uint64_t end = (ends >> j) & 1u;
+                std::uint64_t sign = std::uint64_t(0u) - (masked & (end ^ 1u));
+                sum += masked ? (value ^ sign) - sign : 1u;
+            }
+            result += sum;
+        }
+        // The last block may end inside a range whose beginning is already subtracted
+        if (parity) {
+            result += std::uint64_t(T(words[i] & T(~word_mask<T>())));
+            i++;
+        }
+        return result + range_length_sequential(words + i, size - i);
+    }
+
+    /*!
+     * Finds the length of the run of consecutive values a sorted sequence starts with. Values of a run differ from
+     * their positions by a constant, so whole blocks are compared without branches before the mismatch is looked
+     * for value by value.
+     * @param values Ascending values, at least one
+     * @param size Amount of values
+     * @return Amount of values in the run
+     */
+    template<typename T>
+    INTEGRALRANGE_INLINE std::size_t run_length_generic(const T *values, std::size_t size) {
+        constexpr std::size_t BLOCK = 32u;
+        const T base = values[0];
+        std::size_t i = 1u;
+        for (; i + BLOCK <= size; i += BLOCK) {
+            unsigned mismatches = 0u;
+            for (std::size_t j = 0; j < BLOCK; j++) {
+                mismatches += values[i + j] != T(base + T(i + j));
+            }
+            if (mismatches) {
+                break;
+            }
+        }
+        while (i < size && values[i] == T(base + T(i))) {
+            i++;
+        }
+        return i;
+    }
+
+    //! Counts set bits of a bitmap
+    INTEGRALRANGE_INLINE std::uint64_t count_bits_generic(const std::uint64_t *words, std::size_t size) {
+        std::uint64_t result = 0u;
+        for (std::size_t i = 0; i < size; i++) {
+            result += bit_count(words[i]);
+        }
+        return result;
+    }
+
+    //! Writes a run of consecutive values starting from the given one
+    template<typename T>
+    INTEGRALRANGE_INLINE void fill_run_generic(T *out, T first, std::size_t count) {
+        for (std::size_t i = 0; i < count; i++) {
+            out[i] = T(first + T(i));
+        }
+    }
+
+    //! Amount of ranges and words decode_block_generic() and its vectorized versions have read from a block
+    struct DecodedBlock {
+        //! Amount of decoded ranges
+        std::size_t ranges;
+
+        //! Amount of consumed words, a range whose ending is past the block is left for the next call
+        std::size_t words;
+    };
+
+    /*!
+     * Decodes encoded words into separate arrays of range beginnings and endings, singletons become [v, v + 1)
+     * @param words Encoded words starting with a range
+     * @param size Amount of words
+     * @param begins Output of beginnings, room for size values
+     * @param ends Output of endings, room for size values
+     * @return Amount of decoded ranges and consumed words
+     */
+    template<typename T>
+    INTEGRALRANGE_INLINE DecodedBlock decode_block_generic(const T *words, std::size_t size, T *begins, T *ends) {
+        std::size_t count = 0u, i = 0u;
+        while (i < size) {
+            T word = words[i];
+            bool masked = word & word_mask<T>();
+            if (masked && i + 1u == size) {
+                break;
+            }
+            begins[count] = T(word & T(~word_mask<T>()));
+            ends[count] = masked ? T(words[i + 1u] & T(~word_mask<T>())) : T(word + 1u);
+            count++;
+            i += masked ? 2u : 1u;
+        }
+        return {count, i};
+    }
+
+    //! Marks masked words that begin a range in a block starting with a range: an even amount of masked words
+    //! precedes them, found with a prefix XOR of the mask bits
+    constexpr std::uint32_t range_begin_bits(std::uint32_t masked) {
+        std::uint32_t before = masked << 1u;
+        before ^= before << 1u;
+        before ^= before << 2u;
+        before ^= before << 4u;
+        before ^= before << 8u;
+        return masked & ~before;
+    }
+
+    /**
+     * Indices of the set bits of every 8-bit mask, padded with zeros. Vectorized decoders compact lanes of range
+     * beginnings with them, so every block is stored with a single shuffle whatever its mix of ranges.
+     */
+    struct CompactTable {
+        std::uint8_t indices[256][8];
+
+        constexpr CompactTable() : indices() {
+            for (unsigned bits = 0; bits < 256u; bits++) {
+                unsigned count = 0u;
+                for (unsigned lane = 0; lane < 8u; lane++) {
+                    if (bits & (1u << lane)) {
+                        indices[bits][count++] = std::uint8_t(lane);
+                    }
+                }
+            }
+        }
+    };
+
+    inline constexpr CompactTable COMPACT_TABLE{};
+
+#if INTEGRALRANGE_X86_DISPATCH
+#define INTEGRALRANGE_AVX2 "avx2,bmi,bmi2,popcnt"
+#define INTEGRALRANGE_AVX512 "avx512f,avx512bw,avx512vl,avx2,bmi,bmi2,popcnt,prefer-vector-width=512"
+
+    /*!
+     * Decodes blocks of 8 words of 32 bits, see decode_block_generic(). Mask bits are the sign bits of the lanes
+     * and are collected with movemask. Beginnings are compacted by a shuffle from COMPACT_TABLE, endings are the
+     * following words for ranges and incremented values for singletons, compacted by the same shuffle.
+     */
+    template<typename T>
+    INTEGRALRANGE_TARGET(INTEGRALRANGE_AVX2) DecodedBlock decode_block_avx2_32(const T *words, std::size_t size,
+                                                                               T *begins, T *ends) {
+        static_assert(sizeof(T) == 4u);
+        const __m256i value = _mm256_set1_epi32(0x7fffffff);
+        const __m256i one = _mm256_set1_epi32(1);
+        const __m256i following = _mm256_setr_epi32(1, 2, 3, 4, 5, 6, 7, 7);
+
+        std::size_t count = 0u, i = 0u;
+        while (i + 8u <= size) {
+            __m256i block = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(words + i));
+            auto masked = std::uint32_t(_mm256_movemask_ps(_mm256_castsi256_ps(block)));
+            std::uint32_t starts = (~masked & 0xffu) | range_begin_bits(masked);
+            std::size_t consumed = 8u;
+            // A range beginning in the last lane ends in the next block
+            if (bit_count(masked) & 1u) {
+                starts &= 0x7fu;
+                consumed = 7u;
+            }
+
+            __m256i values = _mm256_and_si256(block, value);
+            __m256i endings = _mm256_blendv_epi8(_mm256_add_epi32(values, one),
+                                                 _mm256_permutevar8x32_epi32(values, following),
+                                                 _mm256_srai_epi32(block, 31));
+            __m256i shuffle = _mm256_cvtepu8_epi32(
+                    _mm_loadl_epi64(reinterpret_cast<const __m128i *>(COMPACT_TABLE.indices[starts])));
+            _mm256_storeu_si256(reinterpret_cast<__m256i *>(begins + count),
+                                _mm256_permutevar8x32_epi32(values, shuffle));
+            _mm256_storeu_si256(reinterpret_cast<__m256i *>(ends + count),
+                                _mm256_permutevar8x32_epi32(endings, shuffle));
+            count += bit_count(starts);
+            i += consumed;
+        }
+        DecodedBlock tail = decode_block_generic(words + i, size - i, begins + count, ends + count);
+        return {count + tail.ranges, i + tail.words};
+    }
+
+    //! Decodes blocks of 4 words of 64 bits, see decode_block_avx2_32(), lanes are shuffled as pairs of halves
+    template<typename T>
+    INTEGRALRANGE_TARGET(INTEGRALRANGE_AVX2) DecodedBlock decode_block_avx2_64(const T *words, std::size_t size,
+                                                                               T *begins, T *ends) {
+        static_assert(sizeof(T) == 8u);
+        const __m256i value = _mm256_set1_epi64x(0x7fffffffffffffffll);
+        const __m256i one = _mm256_set1_epi64x(1);
+        const __m256i following = _mm256_setr_epi32(2, 3, 4, 5, 6, 7, 6, 7);
+
+        std::size_t count = 0u, i = 0u;
+        while (i + 4u <= size) {
+            __m256i block = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(words + i));
+            auto masked = std::uint32_t(_mm256_movemask_pd(_mm256_castsi256_pd(block)));
+            std::uint32_t starts = (~masked & 0xfu) | range_begin_bits(masked);
+            std::size_t consumed = 4u;
+            if (bit_count(masked) & 1u) {
+                starts &= 0x7u;
+                consumed = 3u;
+            }
+
+            // Lane l of 64 bits is the pair of 32-bit lanes 2l and 2l + 1, the table is indexed by spread bits
+            std::uint32_t spread = _pdep_u32(starts, 0x55u) * 3u;
+            __m256i values = _mm256_and_si256(block, value);
+            __m256i endings = _mm256_blendv_epi8(_mm256_add_epi64(values, one),
+                                                 _mm256_permutevar8x32_epi32(values, following),
+                                                 _mm256_srai_epi32(_mm256_shuffle_epi32(block, 0xf5), 31));
+            __m256i shuffle = _mm256_cvtepu8_epi32(
+                    _mm_loadl_epi64(reinterpret_cast<const __m128i *>(COMPACT_TABLE.indices[spread])));
+            _mm256_storeu_si256(reinterpret_cast<__m256i *>(begins + count),
+                                _mm256_permutevar8x32_epi32(values, shuffle));
+            _mm256_storeu_si256(reinterpret_cast<__m256i *>(ends + count),
+                                _mm256_permutevar8x32_epi32(endings, shuffle));
+            count += bit_count(starts);
+            i += consumed;
+        }
+        DecodedBlock tail = decode_block_generic(words + i, size - i, begins + count, ends + count);
+        return {count + tail.ranges, i + tail.words};
+    }
+
+    //! Decodes blocks of 16 words of 32 bits with mask registers and compress instead of shuffle tables
+    template<typename T>
+    INTEGRALRANGE_TARGET(INTEGRALRANGE_AVX512) DecodedBlock decode_block_avx512_32(const T *words, std::size_t size,
+                                                                                   T *begins, T *ends) {
+        static_assert(sizeof(T) == 4u);
+        const __m512i value = _mm512_set1_epi32(0x7fffffff);
+        const __m512i one = _mm512_set1_epi32(1);
+        const __m512i following = _mm512_setr_epi32(1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 15);
+
+        std::size_t count = 0u, i = 0u;
+        while (i + 16u <= size) {
+            __m512i block = _mm512_loadu_si512(words + i);
+            std::uint32_t masked = _mm512_test_epi32_mask(block, _mm512_set1_epi32(int(0x80000000u)));
+            std::uint32_t starts = (~masked & 0xffffu) | range_begin_bits(masked);
+            std::size_t consumed = 16u;
+            if (bit_count(masked) & 1u) {
+                starts &= 0x7fffu;
+                consumed = 15u;
+            }
+
+            __m512i values = _mm512_and_si512(block, value);
+            __m512i endings = _mm512_mask_blend_epi32(__mmask16(masked), _mm512_add_epi32(values, one),
+                                                      _mm512_maskz_permutexvar_epi32(0xffff, following, values));
+            _mm512_storeu_si512(begins + count, _mm512_maskz_compress_epi32(__mmask16(starts), values));
+            _mm512_storeu_si512(ends + count, _mm512_maskz_compress_epi32(__mmask16(starts), endings));
+            count += bit_count(starts);
+            i += consumed;
+        }
+        DecodedBlock tail = decode_block_generic(words + i, size - i, begins + count, ends + count);
+        return {count + tail.ranges, i + tail.words};
+    }
+
+    //! Decodes blocks of 8 words of 64 bits, see decode_block_avx512_32()
+    template<typename T>
+    INTEGRALRANGE_TARGET(INTEGRALRANGE_AVX512) DecodedBlock decode_block_avx512_64(const T *words, std::size_t size,
+                                                                                   T *begins, T *ends) {
+        static_assert(sizeof(T) == 8u);
+        const __m512i value = _mm512_set1_epi64(0x7fffffffffffffffll);
+        const __m512i one = _mm512_set1_epi64(1);
+        const __m512i following = _mm512_setr_epi64(1, 2, 3, 4, 5, 6, 7, 7);
+
+        std::size_t count = 0u, i = 0u;
+        while (i + 8u <= size) {
+            __m512i block = _mm512_loadu_si512(words + i);
+            std::uint32_t masked = _mm512_test_epi64_mask(block, _mm512_set1_epi64(std::int64_t(1) << 63));
+            std::uint32_t starts = (~masked & 0xffu) | range_begin_bits(masked);
+            std::size_t consumed = 8u;
+            if (bit_count(masked) & 1u) {
+                starts &= 0x7fu;
+                consumed = 7u;
+            }
+
+            __m512i values = _mm512_and_si512(block, value);
+            __m512i endings = _mm512_mask_blend_epi64(__mmask8(masked), _mm512_add_epi64(values, one),
+                                                      _mm512_maskz_permutexvar_epi64(0xff, following, values));
+            _mm512_storeu_si512(begins + count, _mm512_maskz_compress_epi64(__mmask8(starts), values));
+            _mm512_storeu_si512(ends + count, _mm512_maskz_compress_epi64(__mmask8(starts), endings));
+            count += bit_count(starts);
+            i += consumed;
+        }
+        DecodedBlock tail = decode_block_generic(words + i, size - i, begins + count, ends + count);
+        return {count + tail.ranges, i + tail.words};
+    }
+
+    //! Selects the AVX2 decoder of the word size, narrow words are decoded by decode_block_generic()
+    template<typename T>
+    INTEGRALRANGE_TARGET(INTEGRALRANGE_AVX2) DecodedBlock decode_block_simd_avx2(const T *words,
+                                                                                 std::size_t size, T *begins,
+                                                                                 T *ends) {
+        if constexpr (sizeof(T) == 4u) {
+            return decode_block_avx2_32(words, size, begins, ends);
+        }
+        else if constexpr (sizeof(T) == 8u) {
+            return decode_block_avx2_64(words, size, begins, ends);
+        }
+        else {
+            return decode_block_generic(words, size, begins, ends);
+        }
+    }
+
+    //! Selects the AVX-512 decoder of the word size, narrow words are decoded by decode_block_generic()
+    template<typename T>
+    INTEGRALRANGE_TARGET(INTEGRALRANGE_AVX512) DecodedBlock decode_block_simd_avx512(const T *words,
+                                                                                     std::size_t size, T *begins,
+                                                                                     T *ends) {
+        if constexpr (sizeof(T) == 4u) {
+            return decode_block_avx512_32(words, size, begins, ends);
+        }
+        else if constexpr (sizeof(T) == 8u) {
+            return decode_block_avx512_64(words, size, begins, ends);
+        }
+        else {
+            return decode_block_generic(words, size, begins, ends);
+        }
+    }
+#endif
+
+    //! Kernels bound to an instruction set
+    template<typename T>
+    struct Kernels {
+        //! See count_not_greater_generic()
+        std::size_t (*countNotGreater)(const T *words, std::size_t size, T value);
+
+        //! See range_length_generic() and range_length_sequential()
+        std::uint64_t (*rangeLength)(const T *words, std::size_t size);
+
+        //! See run_length_generic()
+        std::size_t (*runLength)(const T *values, std::size_t size);
+
+        //! See fill_run_generic()
+        void (*fillRun)(T *out, T first, std::size_t count);
+
+        //! See count_bits_generic()
+        std::uint64_t (*countBits)(const std::uint64_t *words, std::size_t size);
+
+        //! See decode_block_generic()
+        DecodedBlock (*decodeBlock)(const T *words, std::size_t size, T *begins, T *ends);
+    };
+
+// Defines a set of kernels compiled for an instruction set and a function returning them
+#define INTEGRALRANGE_KERNELS(suffix, isa, range_length, decode_block) \
+    template<typename T> \
+    INTEGRALRANGE_TARGET(isa) std::size_t count_not_greater_##suffix(const T *words, std::size_t size, T value) { \
+        return count_not_greater_generic(words, size, value); \
+    } \
+    template<typename T> \
+    INTEGRALRANGE_TARGET(isa) std::uint64_t range_length_##suffix(const T *words, std::size_t size) { \
+        return range_length(words, size); \
+    } \
+    template<typename T> \
+    INTEGRALRANGE_TARGET(isa) std::size_t run_length_##suffix(const T *values, std::size_t size) { \
+        return run_length_generic(values, size); \
+    } \
+    template<typename T> \
+    INTEGRALRANGE_TARGET(isa) void fill_run_##suffix(T *out, T first, std::size_t count) { \
+        fill_run_generic(out, first, count); \
+    } \
+    INTEGRALRANGE_TARGET(isa) inline std::uint64_t count_bits_##suffix(const std::uint64_t *words, std::size_t size) { \
+        return count_bits_generic(words, size); \
+    } \
+    template<typename T> \
+    INTEGRALRANGE_TARGET(isa) DecodedBlock decode_block_##suffix(const T *words, std::size_t size, T *begins, \
+                                                                 T *ends) { \
+        return decode_block(words, size, begins, ends); \
+    } \
+    template<typename T> \
+    constexpr Kernels<T> kernels_##suffix() { \
+        return {&count_not_greater_##suffix<T>, &range_length_##suffix<T>, &run_length_##suffix<T>, \
+                &fill_run_##suffix<T>, &count_bits_##suffix, &decode_block_##suffix<T>}; \
+    }
+
+    template<typename T>
+    std::size_t count_not_greater_baseline(const T *words, std::size_t size, T value) {
+        return count_not_greater_generic(words, size, value);
+    }
+
+    template<typename T>
+    std::uint64_t range_length_baseline(const T *words, std::size_t size) {
+        return range_length_sequential(words, size);
+    }
+
+    template<typename T>
+    std::size_t run_length_baseline(const T *values, std::size_t size) {
+        return run_length_generic(values, size);
+    }
+
+    template<typename T>
+    void fill_run_baseline(T *out, T first, std::size_t count) {
+        fill_run_generic(out, first, count);
+    }
+
+    inline std::uint64_t count_bits_baseline(const std::uint64_t *words, std::size_t size) {
+        return count_bits_generic(words, size);
+    }
+
+    template<typename T>
+    DecodedBlock decode_block_baseline(const T *words, std::size_t size, T *begins, T *ends) {
+        return decode_block_generic(words, size, begins, ends);
+    }
+
+    template<typename T>
+    constexpr Kernels<T> kernels_baseline() {
+        return {&count_not_greater_baseline<T>, &range_length_baseline<T>, &run_length_baseline<T>,
+                &fill_run_baseline<T>, &count_bits_baseline, &decode_block_baseline<T>};
+    }
+
+#if INTEGRALRANGE_X86_DISPATCH
+    INTEGRALRANGE_KERNELS(sse42, "sse4.2,popcnt", range_length_sequential, decode_block_generic)
+    INTEGRALRANGE_KERNELS(avx2, INTEGRALRANGE_AVX2, range_length_generic, decode_block_simd_avx2)
+    INTEGRALRANGE_KERNELS(avx512, INTEGRALRANGE_AVX512, range_length_generic, decode_block_simd_avx512)
+#endif
+
+    /*!
+     * Returns kernels compiled for an instruction set
+     * @param isa Instruction set, kernels of the baseline are returned on other architectures
+     */
+    template<typename T>
+    const Kernels<T> &kernels_for(Isa isa) {
+#if INTEGRALRANGE_X86_DISPATCH
+        static constexpr Kernels<T> table[ISA_COUNT] = {
+                kernels_baseline<T>(), kernels_sse42<T>(), kernels_avx2<T>(), kernels_avx512<T>(),
+        };
+#else
+        static constexpr Kernels<T> table[ISA_COUNT] = {
+                kernels_baseline<T>(), kernels_baseline<T>(), kernels_baseline<T>(), kernels_baseline<T>(),
+        };
+#endif
+        return table[std::size_t(isa)];
+    }
+
+    //! Returns kernels bound to the active instruction set
+    template<typename T>
+    const Kernels<T> &kernels() {
+        return kernels_for<T>(active_isa());
+    }
+
+}
+
+namespace ranges {
+
+    /*!
+     * Decodes encoded words of IntegralRangeVector into arrays of range beginnings and endings with the kernel of
+     * the active instruction set, singletons become [v, v + 1). A range whose ending is past the words is left
+     * undecoded, so long sequences are decoded block by block:
+     *
+     *     std::array<std::uint32_t, 64> begins, ends;
+     *     for (std::size_t i = 0; i < words.size();) {
+     *         auto block = decode_block(words.data() + i, std::min(words.size() - i, begins.size()),
+     *                                   begins.data(), ends.data());
+     *         ...
+     *         i += block.words;
+     *     }
+     *
+     * @param words Encoded words starting with a range
+     * @param size Amount of words
+     * @param begins Output of beginnings, room for size values
+     * @param ends Output of endings, room for size values
+     * @return Amount of decoded ranges and consumed words
+     */
+    template<typename T>
+    dispatch::DecodedBlock decode_block(const T *words, std::size_t size, T *begins, T *ends) {
+        return dispatch::kernels<T>().decodeBlock(words, size, begins, ends);
+    }
+
+}
+
+#endif // INTEGRALRANGE_RANGEKERNELS_H
@@ -0,0 +1,161 @@
+// Copyright 2019 Dmitry Valter
+// Copyright 2019 Sviatoslav Dmitriev
+// Distributed under the Boost Software License, Version 1.0.
+// See accompanying file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt
+
+#ifndef INTEGRALRANGE_RANGEKEYS_H
+#define INTEGRALRANGE_RANGEKEYS_H
+
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <type_traits>
+#include <utility>
+
+#include "RangeMerger.h"
+
+namespace ranges {
+
+    /**
+     * Customization point that maps values of another type to unsigned keys in the same order, so that they can be
+     * stored and merged by the containers of this library. A specialization defines the unsigned key_type, static
+     * functions to_key() and from_key() that convert values both ways and in_domain() that checks if a value has a
+     * key. Keys must stay below the mask bit of IntegralRangeVector<key_type>, and a key one above the key of every
+     * stored value must exist as the ending of its range. to_key() only asserts that its argument is in the
+     * domain, values that may be outside of it have to be checked with in_domain() first.
+     *
+     * Mappings of the standard types:
+     *  - unsigned integers are their own keys and need the highest bit clear;
+     *  - signed integers are biased into an unsigned type twice as wide, 64-bit ones keep 63 bits of that width
+     *    and need values in [-2^62, 2^62);
+     *  - enumerations use the mapping of their underlying type;
+     *  - float flips all bits of negative values and the sign bit of others, so that the bit patterns sort like
+     *    the values, and widens them to 64 bits. -0.0 sorts before 0.0, NaNs sort outside of infinities;
+     *  - double and long double are rejected at compile time, their keys would not fit below the mask bit.
+     */
+    template<typename K, typename = void>
+    struct key_traits {};
+
+    template<typename K>
+    struct key_traits<K, std::enable_if_t<std::is_unsigned_v<K>>> {
+        typedef K key_type;
+
+        static constexpr bool in_domain(K value) { return (value >> (std::numeric_limits<K>::digits - 1)) == 0u; }
+
+        static constexpr key_type to_key(K value) { return value; }
+
+        static constexpr K from_key(key_type key) { return key; }
+    };
+
+    template<typename K>
+    struct key_traits<K, std::enable_if_t<std::is_integral_v<K> && std::is_signed_v<K>>> {
+        typedef std::conditional_t<sizeof(K) == 1u, std::uint16_t,
+                std::conditional_t<sizeof(K) == 2u, std::uint32_t, std::uint64_t>> key_type;
+
+        //! Key of zero, the lowest value of K is mapped to zero unless K is 64 bits wide
+        static constexpr key_type BIAS = key_type(1u) << std::min(std::numeric_limits<K>::digits,
+                                                                  std::numeric_limits<key_type>::digits - 2);
+
+        static constexpr bool in_domain(K value) {
+            return value < 0 ? value >= -K(BIAS - 1u) - 1 : std::make_unsigned_t<K>(value) < BIAS;
+        }
+
+        static constexpr key_type to_key(K value) {
+            assert(in_domain(value));
+            return key_type(key_type(value) + BIAS);
+        }
+
+        static constexpr K from_key(key_type key) {
+            return K(std::make_signed_t<key_type>(key_type(key - BIAS)));
+        }
+    };
+
+    template<typename K>
+    struct key_traits<K, std::enable_if_t<std::is_enum_v<K>>> {
+        typedef std::underlying_type_t<K> underlying_type;
+
+        typedef typename key_traits<underlying_type>::key_type key_type;
+
+        static constexpr bool in_domain(K value) {
+            return key_traits<underlying_type>::in_domain(underlying_type(value));
+        }
+
+        static constexpr key_type to_key(K value) {
+            return key_traits<underlying_type>::to_key(underlying_type(value));
+        }
+
+        static constexpr K from_key(key_type key) { return K(key_traits<underlying_type>::from_key(key)); }
+    };
+
+    template<>
+    struct key_traits<float> {
+        static_assert(std::numeric_limits<float>::is_iec559 && sizeof(float) == sizeof(std::uint32_t));
+
+        typedef std::uint64_t key_type;
+
+        static constexpr bool in_domain(float) { return true; }
+
+        static key_type to_key(float value) {
+            std::uint32_t bits;
+            std::memcpy(&bits, &value, sizeof(bits));
+            return key_type(bits & SIGN ? ~bits : bits | SIGN);
+        }
+
+        static float from_key(key_type key) {
+            auto bits = std::uint32_t(key & SIGN ? key ^ SIGN : ~key);
+            float value;
+            std::memcpy(&value, &bits, sizeof(value));
+            return value;
+        }
+
+    private:
+        static constexpr std::uint32_t SIGN = std::uint32_t(1u) << 31u;
+    };
+
+    /**
+     * Wider floating-point types have no keys: the transform of float needs every bit of a 64-bit key, and dropping
+     * any of them would give different values the same key
+     */
+    template<typename K>
+    struct key_traits<K, std::enable_if_t<std::is_floating_point_v<K> && (sizeof(K) > sizeof(std::uint32_t))>> {
+        static_assert(!std::is_floating_point_v<K>,
+                      "Values of double and long double do not fit into the keys of range containers, store them "
+                      "as float or as integers in fixed units");
+    };
+
+    //! Checks if key_traits describe a type
+    template<typename K, typename = void>
+    struct is_key : std::false_type {};
+
+    template<typename K>
+    struct is_key<K, std::void_t<typename key_traits<K>::key_type>> : std::true_type {};
+
+    template<typename K>
+    constexpr bool is_key_v = is_key<K>::value;
+
+    //! Unsigned key of a type
+    template<typename K>
+    using key_type_t = typename key_traits<K>::key_type;
+
+    /**
+     * Pairs of values that have keys are ranges of their keys, so containers of such pairs are merged in the key
+     * domain and only the bounds of emitted ranges are converted back
+     */
+    template<typename K>
+    struct range_traits<std::pair<K, K>, std::enable_if_t<is_key_v<K> && !std::is_unsigned_v<K>>> {
+        typedef key_type_t<K> value_type;
+
+        static value_type begin(const std::pair<K, K> &range) { return key_traits<K>::to_key(range.first); }
+
+        static value_type end(const std::pair<K, K> &range) { return key_traits<K>::to_key(range.second); }
+
+        static std::pair<K, K> make(value_type begin, value_type end) {
+            return {key_traits<K>::from_key(begin), key_traits<K>::from_key(end)};
+        }
+    };
+
+}
+
+#endif // INTEGRALRANGE_RANGEKEYS_H
@@ -6,7 +6,16 @@
 #ifndef INTEGRALRANGE_MERGERANGER_H
 #define INTEGRALRANGE_MERGERANGER_H
 
+#include <algorithm>
+#include <array>
+#include <tuple>
+#include <type_traits>
+#if defined(__cpp_concepts) && __cpp_concepts >= 201907L
+#include <concepts>
+#endif
+
 #include "IntegralRangeVector.h"
+#include "RangeHooks.h"
 
 namespace ranges {
 
@@ -19,6 +28,79 @@ namespace ranges {
     template <class Test>
     constexpr bool is_pair_v = is_pair<Test>::value;
 
+    /**
+     * Customization point that describes a type of value ranges, so that containers of them can be merged without
+     * converting them to pairs first. A specialization defines the unsigned value_type of the bounds and static
+     * functions begin() and end() returning the bounds of a range, the ending is exclusive. Merges that produce a
+     * container of ranges also need make(), which builds a range from its bounds:
+     *
+     *     struct Interval { std::uint32_t start, length; };
+     *
+     *     template<>
+     *     struct ranges::range_traits<Interval> {
+     *         typedef std::uint32_t value_type;
+     *         static value_type begin(const Interval &r) { return r.start; }
+     *         static value_type end(const Interval &r) { return r.start + r.length; }
+     *         static Interval make(value_type begin, value_type end) { return {begin, end - begin}; }
+     *     };
+     *
+     * Pairs of unsigned values are described out of the box.
+     */
+    template<typename Range, typename = void>
+    struct range_traits {};
+
+    template<typename T>
+    struct range_traits<std::pair<T, T>, std::enable_if_t<std::is_unsigned_v<T>>> {
+        typedef T value_type;
+
+        static constexpr T begin(const std::pair<T, T> &range) { return range.first; }
+
+        static constexpr T end(const std::pair<T, T> &range) { return range.second; }
+
+        static constexpr std::pair<T, T> make(T begin, T end) { return {begin, end}; }
+    };
+
+    //! Checks if range_traits describe a type
+    template<typename Range, typename = void>
+    struct is_range : std::false_type {};
+
+    template<typename Range>
+    struct is_range<Range, std::void_t<typename range_traits<Range>::value_type>> : std::true_type {};
+
+    template<typename Range>
+    constexpr bool is_range_v = is_range<Range>::value;
+
+#if defined(__cpp_concepts) && __cpp_concepts >= 201907L
+    //! Type of value ranges described by range_traits
+    template<typename Range>
+    concept range_type = std::is_unsigned_v<typename range_traits<Range>::value_type> &&
+            requires(const Range &range) {
+                { range_traits<Range>::begin(range) } -> std::convertible_to<typename range_traits<Range>::value_type>;
+                { range_traits<Range>::end(range) } -> std::convertible_to<typename range_traits<Range>::value_type>;
+            };
+
+    //! Container of ascending value ranges or unsigned values that can be merged
+    template<typename Cont>
+    concept range_container = (range_type<typename Cont::value_type> ||
+                               std::is_unsigned_v<typename Cont::value_type>) &&
+            std::default_initializable<Cont> && std::copy_constructible<Cont> &&
+            requires(const Cont &cont) {
+                { cont.begin() != cont.end() } -> std::convertible_to<bool>;
+            };
+
+    //! Checks if a type is a range type, the accessors below are constrained with it
+    template<typename Range>
+    constexpr bool is_range_type_v = range_type<Range>;
+
+// Merges are constrained with concepts when they are available and take any type otherwise, undefined at the end
+#define INTEGRALRANGE_CONTAINER range_container
+#else
+    template<typename Range>
+    constexpr bool is_range_type_v = is_range_v<Range>;
+
+#define INTEGRALRANGE_CONTAINER typename
+#endif
+
     /*!
      * Get the beginning of the range on a current iterator position (overload for unsigned value iterators)
      * @tparam It Iterator type
@@ -49,10 +131,10 @@ namespace ranges {
      * @param it iterator
      * @return Beginning of the range on a current iterator position
      */
-    template<typename It, std::enable_if_t<is_pair_v<typename It::value_type> &&
-                                           std::is_unsigned_v<typename It::value_type::first_type>, bool> = true>
-    auto get_first(const It &it) -> typename std::iterator_traits<It>::value_type::first_type {
-        return it->first;
+    template<typename It, typename Range = typename std::iterator_traits<It>::value_type,
+            std::enable_if_t<is_range_type_v<Range>, bool> = true>
+    auto get_first(const It &it) -> typename range_traits<Range>::value_type {
+        return range_traits<Range>::begin(*it);
     }
 
     /*!
@@ -61,46 +143,136 @@ namespace ranges {
      * @param it iterator
      * @return Ending of the range on a current iterator position
      */
-    template<typename It, std::enable_if_t<is_pair_v<typename It::value_type> &&
-                                           std::is_unsigned_v<typename It::value_type::first_type>, bool> = true>
-    auto get_last(const It &it) -> typename std::iterator_traits<It>::value_type::second_type {
-        return it->second;
+    template<typename It, typename Range = typename std::iterator_traits<It>::value_type,
+            std::enable_if_t<is_range_type_v<Range>, bool> = true>
+    auto get_last(const It &it) -> typename range_traits<Range>::value_type {
+        return range_traits<Range>::end(*it);
     }
 
     /*!
-     * Inserts a range to the end of the container (overload for range iterators)
+     * Inserts a range to the end of the container (overload for unsigned value iterators)
      * @tparam Cont Container type
      * @param output Container to insert value to
      * @param range Range of values to insert
      */
     template<typename Cont, std::enable_if_t<std::is_arithmetic_v<typename Cont::value_type>, bool> = true>
     void insert_back(Cont &output, std::pair<typename Cont::value_type, typename Cont::value_type> range) {
+        GrowthCounter<Cont> growth(output);
         for (typename Cont::value_type i = range.first; i < range.second; i++) {
             output.push_back(i);
         }
     }
 
     /*!
-     * Inserts a range to the end of the container (overload for unsigned value iterators)
+     * Inserts a range to the end of the container (overload for range iterators)
      * @tparam Cont Container type
      * @param output Container to insert value to
      * @param range Range of values to insert
      */
-    template<typename Cont, std::enable_if_t<is_pair_v<typename Cont::value_type>, bool> = true>
+    template<typename Cont, typename Range = typename Cont::value_type,
+            std::enable_if_t<is_range_type_v<Range>, bool> = true>
     void insert_back(
             Cont &output,
-            std::pair<typename Cont::value_type::first_type, typename Cont::value_type::second_type> range) {
-        output.push_back(range);
+            std::pair<typename range_traits<Range>::value_type, typename range_traits<Range>::value_type> range) {
+        output.push_back(range_traits<Range>::make(range.first, range.second));
     }
 
+    /**
+     * Cursor over the ranges of an ascending sequence: a range container, a view such as a set expression or a
+     * sorted container of values
+     * @tparam Seq Type of the sequence
+     */
+    template<typename Seq>
+    class SequenceCursor {
+        typedef decltype(std::declval<const Seq &>().begin()) iterator;
+
+        iterator _iter;
+        iterator _end;
+
+    public:
+        //! Integral type of the values
+        typedef decltype(get_first(std::declval<const iterator &>())) value_type;
+
+        explicit SequenceCursor(const Seq &seq) : _iter(seq.begin()), _end(seq.end()) {}
+
+        bool valid() const { return _iter != _end; }
+
+        value_type first() const { return get_first(_iter); }
+
+        value_type second() const { return get_last(_iter); }
+
+        void advance() {
+            ++_iter;
+            INTEGRALRANGE_STAT(cursorAdvances, 1u);
+        }
+    };
+
+    /**
+     * Cursor over the ranges of a range vector that decodes its words block by block with decode_block(), so merges
+     * compare plain arrays of beginnings and endings instead of classifying every word
+     */
+    template<typename T, typename Allocator>
+    class SequenceCursor<IntegralRangeVector<T, Allocator>> {
+        static constexpr std::size_t BLOCK = IntegralRangeVector<T, Allocator>::DECODE_BLOCK;
+
+        const T *_words;
+        const T *_wordsEnd;
+        std::size_t _position = 0u;
+        std::size_t _count = 0u;
+        std::array<T, BLOCK> _begins;
+        std::array<T, BLOCK> _ends;
+
+        void decode() {
+            std::size_t size = std::min(std::size_t(_wordsEnd - _words), BLOCK);
+            dispatch::DecodedBlock block = decode_block(_words, size, _begins.data(), _ends.data());
+            _position = 0u;
+            _count = block.ranges;
+            _words += block.words;
+            // A masked last word is read as a singleton, like analyze() does
+            if (block.words == 0u && size != 0u) {
+                _begins[0] = T(*_words & ~IntegralRangeVector<T, Allocator>::mask);
+                _ends[0] = T(_begins[0] + 1u);
+                _count = 1u;
+                _words++;
+            }
+        }
+
+    public:
+        //! Integral type of the values
+        typedef T value_type;
+
+        explicit SequenceCursor(const IntegralRangeVector<T, Allocator> &seq)
+                : _words(seq.getBase().data()), _wordsEnd(seq.getBase().data() + seq.getBase().size()) {
+            decode();
+        }
+
+        bool valid() const { return _position < _count; }
+
+        value_type first() const { return _begins[_position]; }
+
+        value_type second() const { return _ends[_position]; }
+
+        void advance() {
+            if (++_position == _count) {
+                decode();
+            }
+            INTEGRALRANGE_STAT(cursorAdvances, 1u);
+        }
+    };
+
     /*!
      * Calculates an intersection of multiple ranges
      * @tparam Cont Ranges container type
      * @param ranges Ranges to calculate intersection of
+     * @param stats Optional output of operation counters collected during the call
      * @return Intersection of multiple ranges
      */
-    template<typename Cont>
-    auto intersect_ranges(const std::vector<Cont> &ranges) -> Cont {
+    template<INTEGRALRANGE_CONTAINER Cont>
+    auto intersect_ranges(const std::vector<Cont> &ranges, OperationStats *stats = nullptr) -> Cont {
+        INTEGRALRANGE_TRACE_SCOPE("intersect_ranges", "inputs", ranges.size());
+        INTEGRALRANGE_RECORD_MERGE(RecordedOperation::intersect, ranges);
+        StatsScope statsScope(stats);
+
         if (ranges.empty()) {
             return Cont{};
         }
@@ -109,7 +281,7 @@ namespace ranges {
             return ranges[0];
         }
 
-        typedef decltype(get_first(ranges[0].begin())) value_type;
+        typedef typename SequenceCursor<Cont>::value_type value_type;
         Cont result;
 
         value_type curRangeBegin = 0;
@@ -117,25 +289,27 @@ namespace ranges {
 
         std::optional<std::pair<value_type, value_type>> pendingRange;
         size_t containerToForward = 0;
-        std::vector<decltype(ranges[0].begin())> iters;
-        iters.reserve(ranges.size());
+        std::vector<SequenceCursor<Cont>> cursors;
+        cursors.reserve(ranges.size());
+        INTEGRALRANGE_STAT(allocations, 1u);
 
         for (auto &range : ranges) {
-            if (range.begin() == range.end()) {
+            cursors.emplace_back(range);
+            if (!cursors.back().valid()) {
                 return Cont{};
             }
-            iters.push_back(range.begin());
         }
 
         int iter = 0;
 
         for (;;) {
+            INTEGRALRANGE_STAT(headComparisons, ranges.size());
 
             for (size_t i = 0; i < ranges.size(); i++) {
-                assert(iters[i] != ranges[i].end());
+                assert(cursors[i].valid());
 
-                auto begin = get_first(iters[i]);
-                auto end = get_last(iters[i]);
+                auto begin = cursors[i].first();
+                auto end = cursors[i].second();
 
                 if (begin > curRangeBegin) {
                     curRangeBegin = begin;
@@ -151,9 +325,11 @@ namespace ranges {
                 if (pendingRange) {
                     if (pendingRange->second == curRangeBegin) {
                         pendingRange->second = curRangeEnd;
+                        INTEGRALRANGE_STAT(coalescedMerges, 1u);
                     }
                     else {
                         insert_back(result, pendingRange.value());
+                        INTEGRALRANGE_STAT(emittedRanges, 1u);
                         pendingRange = {curRangeBegin, curRangeEnd};
                     }
                 }
@@ -164,9 +340,11 @@ namespace ranges {
 
             curRangeEnd = std::numeric_limits<value_type>::max();
 
-            if (++iters[containerToForward] == ranges[containerToForward].end()) {
+            cursors[containerToForward].advance();
+            if (!cursors[containerToForward].valid()) {
                 if (pendingRange) {
                     insert_back(result, pendingRange.value());
+                    INTEGRALRANGE_STAT(emittedRanges, 1u);
                 }
                 break;
             }
@@ -180,10 +358,15 @@ namespace ranges {
      * Calculates a union of multiple ranges
      * @tparam Cont Ranges container type
      * @param ranges Ranges to calculate union of
+     * @param stats Optional output of operation counters collected during the call
      * @return Union of multiple ranges
      */
-    template<typename Cont>
-    auto unite_ranges(std::vector<Cont> ranges) -> Cont {
+    template<INTEGRALRANGE_CONTAINER Cont>
+    auto unite_ranges(std::vector<Cont> ranges, OperationStats *stats = nullptr) -> Cont {
+        INTEGRALRANGE_TRACE_SCOPE("unite_ranges", "inputs", ranges.size());
+        INTEGRALRANGE_RECORD_MERGE(RecordedOperation::unite, ranges);
+        StatsScope statsScope(stats);
+
         if (ranges.empty()) {
             return Cont{};
         }
@@ -192,7 +375,7 @@ namespace ranges {
             return ranges[0];
         }
 
-        typedef decltype(get_first(ranges[0].begin())) value_type;
+        typedef typename SequenceCursor<Cont>::value_type value_type;
         Cont result;
 
         constexpr value_type LAST = std::numeric_limits<value_type>::max();
@@ -202,11 +385,13 @@ namespace ranges {
 
         std::optional<std::pair<value_type, value_type>> pendingRange;
         size_t containerToForward = 0;
-        std::vector<decltype(ranges[0].begin())> iters;
-        iters.reserve(ranges.size());
+        std::vector<SequenceCursor<Cont>> cursors;
+        cursors.reserve(ranges.size());
+
+        INTEGRALRANGE_STAT(allocations, 1u);
 
         for (auto &range : ranges) {
-            iters.push_back(range.begin());
+            cursors.emplace_back(range);
         }
 
         int iter = 0;
@@ -215,13 +400,14 @@ namespace ranges {
             containerToForward = 0;
             curRangeBegin = LAST;
             curRangeEnd = LAST;
+            INTEGRALRANGE_STAT(headComparisons, ranges.size());
 
             for (size_t i = 0; i < ranges.size(); i++) {
-                if (iters[i] >= ranges[i].end()) {
+                if (!cursors[i].valid()) {
                     continue;
                 }
-                auto begin = get_first(iters[i]);
-                auto end = get_last(iters[i]);
+                auto begin = cursors[i].first();
+                auto end = cursors[i].second();
                 if (begin < curRangeBegin) {
                     curRangeBegin = begin;
                     curRangeEnd = end;
@@ -232,6 +418,7 @@ namespace ranges {
             if (curRangeEnd == LAST) {
                 if (pendingRange) {
                     insert_back(result, pendingRange.value());
+                    INTEGRALRANGE_STAT(emittedRanges, 1u);
                 }
                 break;
             }
@@ -242,9 +429,11 @@ namespace ranges {
                         if (pendingRange->second < curRangeEnd) {
                             pendingRange->second = curRangeEnd;
                         }
+                        INTEGRALRANGE_STAT(coalescedMerges, 1u);
                     }
                     else {
                         insert_back(result, pendingRange.value());
+                        INTEGRALRANGE_STAT(emittedRanges, 1u);
                         pendingRange = {curRangeBegin, curRangeEnd};
                     }
                 }
@@ -255,13 +444,212 @@ namespace ranges {
 
             curRangeEnd = std::numeric_limits<value_type>::max();
 
-            ++iters[containerToForward];
+            cursors[containerToForward].advance();
             iter++;
         }
 
         return result;
     }
 
+
+    /*!
+     * Calculates values of a range container that are not in another one, see subtract_ranges()
+     * @tparam Cont Ranges container type
+     * @param from Ranges to subtract from
+     * @param subtracted Ranges to subtract
+     * @return Difference of ranges
+     */
+    template<INTEGRALRANGE_CONTAINER Cont>
+    auto subtract_from(const Cont &from, const Cont &subtracted) -> Cont {
+        typedef decltype(get_first(from.begin())) value_type;
+        Cont result;
+        std::optional<std::pair<value_type, value_type>> pendingRange;
+
+        auto emit = [&](value_type begin, value_type end) {
+            if (pendingRange && pendingRange->second == begin) {
+                pendingRange->second = end;
+                INTEGRALRANGE_STAT(coalescedMerges, 1u);
+                return;
+            }
+            if (pendingRange) {
+                insert_back(result, pendingRange.value());
+                INTEGRALRANGE_STAT(emittedRanges, 1u);
+            }
+            pendingRange = {begin, end};
+        };
+
+        auto iter = subtracted.begin();
+        for (auto range = from.begin(); range != from.end(); ++range) {
+            value_type begin = get_first(range);
+            value_type end = get_last(range);
+            INTEGRALRANGE_STAT(cursorAdvances, 1u);
+
+            // Both containers ascend, so subtracted ranges ending before the current range are never needed again
+            while (iter != subtracted.end() && get_last(iter) <= begin) {
+                ++iter;
+                INTEGRALRANGE_STAT(cursorAdvances, 1u);
+            }
+
+            for (auto cut = iter; begin < end && cut != subtracted.end() && get_first(cut) < end; ++cut) {
+                INTEGRALRANGE_STAT(headComparisons, 1u);
+                if (get_first(cut) > begin) {
+                    emit(begin, get_first(cut));
+                }
+                begin = std::max(begin, get_last(cut));
+            }
+
+            if (begin < end) {
+                emit(begin, end);
+            }
+        }
+
+        if (pendingRange) {
+            insert_back(result, pendingRange.value());
+            INTEGRALRANGE_STAT(emittedRanges, 1u);
+        }
+        return result;
+    }
+
+    /*!
+     * Calculates a difference of ranges: values of the first ranges that are not in any of the other ranges
+     * @tparam Cont Ranges container type
+     * @param ranges Ranges to subtract from followed by ranges to subtract
+     * @param stats Optional output of operation counters collected during the call
+     * @return Difference of ranges
+     */
+    template<INTEGRALRANGE_CONTAINER Cont>
+    auto subtract_ranges(const std::vector<Cont> &ranges, OperationStats *stats = nullptr) -> Cont {
+        INTEGRALRANGE_TRACE_SCOPE("subtract_ranges", "inputs", ranges.size());
+        INTEGRALRANGE_RECORD_MERGE(RecordedOperation::subtract, ranges);
+        StatsScope statsScope(stats);
+
+        if (ranges.empty()) {
+            return Cont{};
+        }
+
+        if (ranges.size() == 1) {
+            return ranges[0];
+        }
+
+        if (ranges.size() == 2) {
+            return subtract_from(ranges[0], ranges[1]);
+        }
+
+        std::vector<Cont> subtracted(ranges.begin() + 1, ranges.end());
+        INTEGRALRANGE_STAT(allocations, 1u);
+        return subtract_from(ranges[0], unite_ranges(std::move(subtracted)));
+    }
+
+    //! Checks if a type is an ascending sequence of ranges or values that SequenceCursor can read
+    template<typename Seq, typename = void>
+    struct is_range_sequence : std::false_type {};
+
+    template<typename Seq>
+    struct is_range_sequence<Seq, std::void_t<typename SequenceCursor<Seq>::value_type>> : std::true_type {};
+
+    //! Integral type of values common to several sequences
+    template<typename... Seqs>
+    using sequence_value_t = std::common_type_t<typename SequenceCursor<Seqs>::value_type...>;
+
+    /*!
+     * Calculates an intersection of sequences of different types, e.g. of a range vector, a sorted vector of values
+     * and a set expression. Unlike intersect_ranges() the amount of inputs is known at compile time, so the
+     * comparisons of their heads are unrolled over a tuple of cursors.
+     * @return Intersection of the sequences, stored in a range vector of the common value type
+     */
+    template<typename First, typename Second, typename... Rest,
+            std::enable_if_t<std::conjunction_v<is_range_sequence<First>, is_range_sequence<Second>,
+                                                is_range_sequence<Rest>...>, bool> = true>
+    auto intersect(const First &first, const Second &second, const Rest &... rest) {
+        typedef sequence_value_t<First, Second, Rest...> value_type;
+        INTEGRALRANGE_TRACE_SCOPE("intersect", "inputs", 2u + sizeof...(Rest));
+
+        IntegralRangeVector<value_type> result;
+        std::tuple<SequenceCursor<First>, SequenceCursor<Second>, SequenceCursor<Rest>...> cursors(first, second,
+                                                                                                   rest...);
+        std::apply([&](auto &... cursor) {
+            while ((cursor.valid() && ...)) {
+                INTEGRALRANGE_STAT(headComparisons, sizeof...(cursor));
+                value_type begin = 0u;
+                value_type end = std::numeric_limits<value_type>::max();
+                ((begin = std::max(begin, value_type(cursor.first()))), ...);
+                ((end = std::min(end, value_type(cursor.second()))), ...);
+
+                if (begin < end) {
+                    result.push_back({begin, end});
+                    INTEGRALRANGE_STAT(emittedRanges, 1u);
+                }
+
+                // Ranges ending first cannot overlap later ranges of the other sequences
+                ((value_type(cursor.second()) == end ? cursor.advance() : void()), ...);
+            }
+        }, cursors);
+        return result;
+    }
+
+    /*!
+     * Calculates a union of sequences of different types, see intersect()
+     * @return Union of the sequences, stored in a range vector of the common value type
+     */
+    template<typename First, typename Second, typename... Rest,
+            std::enable_if_t<std::conjunction_v<is_range_sequence<First>, is_range_sequence<Second>,
+                                                is_range_sequence<Rest>...>, bool> = true>
+    auto unite(const First &first, const Second &second, const Rest &... rest) {
+        typedef sequence_value_t<First, Second, Rest...> value_type;
+        INTEGRALRANGE_TRACE_SCOPE("unite", "inputs", 2u + sizeof...(Rest));
+
+        IntegralRangeVector<value_type> result;
+        std::tuple<SequenceCursor<First>, SequenceCursor<Second>, SequenceCursor<Rest>...> cursors(first, second,
+                                                                                                   rest...);
+        std::apply([&](auto &... cursor) {
+            while ((cursor.valid() || ...)) {
+                INTEGRALRANGE_STAT(headComparisons, sizeof...(cursor));
+                value_type begin = std::numeric_limits<value_type>::max();
+                ((begin = cursor.valid() ? std::min(begin, value_type(cursor.first())) : begin), ...);
+
+                // Ranges starting inside the current one extend it until none of the heads does
+                value_type end = begin;
+                auto extend = [&end](auto &c) {
+                    if (!c.valid() || value_type(c.first()) > end) {
+                        return false;
+                    }
+                    end = std::max(end, value_type(c.second()));
+                    c.advance();
+                    return true;
+                };
+                while ((extend(cursor) | ...)) {
+                    INTEGRALRANGE_STAT(coalescedMerges, 1u);
+                }
+
+                result.push_back({begin, end});
+                INTEGRALRANGE_STAT(emittedRanges, 1u);
+            }
+        }, cursors);
+        return result;
+    }
+
+// Merges of IntegralRangeVector instances, see INTEGRALRANGE_VECTOR_INSTANCES
+#define INTEGRALRANGE_MERGE_INSTANCE(prefix, T) \
+    prefix template auto intersect_ranges(const std::vector<IntegralRangeVector<T>> &, OperationStats *) \
+            -> IntegralRangeVector<T>; \
+    prefix template auto unite_ranges(std::vector<IntegralRangeVector<T>>, OperationStats *) \
+            -> IntegralRangeVector<T>; \
+    prefix template auto subtract_from(const IntegralRangeVector<T> &, const IntegralRangeVector<T> &) \
+            -> IntegralRangeVector<T>; \
+    prefix template auto subtract_ranges(const std::vector<IntegralRangeVector<T>> &, OperationStats *) \
+            -> IntegralRangeVector<T>;
+
+#define INTEGRALRANGE_MERGE_INSTANCES(prefix) \
+    INTEGRALRANGE_MERGE_INSTANCE(prefix, std::uint8_t) \
+    INTEGRALRANGE_MERGE_INSTANCE(prefix, std::uint16_t) \
+    INTEGRALRANGE_MERGE_INSTANCE(prefix, std::uint32_t) \
+    INTEGRALRANGE_MERGE_INSTANCE(prefix, std::uint64_t)
+
+#ifdef INTEGRALRANGE_EXTERN_TEMPLATES
+    INTEGRALRANGE_MERGE_INSTANCES(extern)
+#endif
 }
 
+#undef INTEGRALRANGE_CONTAINER
+
 #endif // INTEGRALRANGE_MERGERANGER_H
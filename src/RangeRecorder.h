@@ -0,0 +1,550 @@
+// Copyright 2019 Dmitry Valter
+// Copyright 2019 Sviatoslav Dmitriev
+// Distributed under the Boost Software License, Version 1.0.
+// See accompanying file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt
+
+#ifndef INTEGRALRANGE_RANGERECORDER_H
+#define INTEGRALRANGE_RANGERECORDER_H
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <istream>
+#include <map>
+#include <mutex>
+#include <ostream>
+#include <stdexcept>
+#include <type_traits>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+namespace ranges {
+
+    /*
+     * Recording format, all integers are little endian:
+     *   header   - the 8 bytes "IRREC\0\0\1"
+     *   snapshot - tag 'S', fingerprint (8 bytes), word width in bytes (1 byte), varint amount of words, varint
+     *              zigzag deltas between unmasked word values, bitmap of mask bits with the lowest bit first
+     *   call     - tag 'C', operation (1 byte), word width in bytes (1 byte), varint thread, varint duration in
+     *              nanoseconds, varint looked up value, varint amount of operands, operand fingerprints (8 bytes
+     *              each), lookups have exactly one operand and merges of no sets have none
+     * A snapshot is written once per distinct set, before the first call that uses it.
+     */
+
+    //! Recorded operation
+    enum class RecordedOperation : std::uint8_t {
+        intersect = 1u,
+        unite = 2u,
+        contains = 3u,
+        subtract = 4u,
+    };
+
+    //! Returns the name of a recorded operation
+    inline const char *operation_name(RecordedOperation operation) {
+        switch (operation) {
+            case RecordedOperation::intersect:
+                return "intersect_ranges";
+            case RecordedOperation::unite:
+                return "unite_ranges";
+            case RecordedOperation::contains:
+                return "contains";
+            case RecordedOperation::subtract:
+                return "subtract_ranges";
+        }
+        return "unknown";
+    }
+
+    //! Encoded words of a recorded set, widened to 64 bits with the mask kept in the top bit of the original width
+    struct RecordedSnapshot {
+        std::uint8_t width = 0u;
+        std::vector<std::uint64_t> words;
+    };
+
+    //! Recorded call
+    struct RecordedCall {
+        RecordedOperation operation = RecordedOperation::contains;
+
+        //! Word width of the operands in bytes
+        std::uint8_t width = 0u;
+
+        //! Sequential number of the recording thread
+        std::uint32_t thread = 0u;
+
+        //! Duration of the call in nanoseconds
+        std::uint64_t duration = 0u;
+
+        //! Looked up value of contains()
+        std::uint64_t value = 0u;
+
+        //! Fingerprints of the operand snapshots
+        std::vector<std::uint64_t> operands;
+    };
+
+    //! Contents of a recording
+    struct Recording {
+        std::map<std::uint64_t, RecordedSnapshot> snapshots;
+        std::vector<RecordedCall> calls;
+    };
+
+    namespace record {
+
+        constexpr char MAGIC[8] = {'I', 'R', 'R', 'E', 'C', '\0', '\0', '\1'};
+
+        inline void write_varint(std::ostream &out, std::uint64_t value) {
+            while (value >= 0x80u) {
+                out.put(char(std::uint8_t(value) | 0x80u));
+                value >>= 7u;
+            }
+            out.put(char(value));
+        }
+
+        inline void write_fixed(std::ostream &out, std::uint64_t value) {
+            for (unsigned i = 0; i < 8u; i++) {
+                out.put(char(std::uint8_t(value >> (8u * i))));
+            }
+        }
+
+        inline std::uint8_t read_byte(std::istream &in) {
+            int value = in.get();
+            if (value == std::char_traits<char>::eof()) {
+                throw std::runtime_error("truncated recording");
+            }
+            return std::uint8_t(value);
+        }
+
+        inline std::uint64_t read_varint(std::istream &in) {
+            std::uint64_t value = 0u;
+            for (unsigned shift = 0; shift < 64u; shift += 7u) {
+                std::uint8_t byte = read_byte(in);
+                value |= std::uint64_t(byte & 0x7Fu) << shift;
+                if ((byte & 0x80u) == 0u) {
+                    return value;
+                }
+            }
+            throw std::runtime_error("malformed varint in recording");
+        }
+
+        inline std::uint64_t read_fixed(std::istream &in) {
+            std::uint64_t value = 0u;
+            for (unsigned i = 0; i < 8u; i++) {
+                value |= std::uint64_t(read_byte(in)) << (8u * i);
+            }
+            return value;
+        }
+
+        //! Hashes encoded words, the width is included so that equal values of different types do not collide
+        template<typename T, typename Allocator>
+        std::uint64_t fingerprint(const std::vector<T, Allocator> &words) {
+            auto mix = [](std::uint64_t x) {
+                x ^= x >> 30u;
+                x *= 0xBF58476D1CE4E5B9ull;
+                x ^= x >> 27u;
+                x *= 0x94D049BB133111EBull;
+                return x ^ (x >> 31u);
+            };
+            std::uint64_t hash = mix(sizeof(T) ^ (std::uint64_t(words.size()) << 8u));
+            for (T word : words) {
+                hash = mix(hash ^ std::uint64_t(word));
+            }
+            return hash;
+        }
+
+        //! Checks if a container base is encoded words
+        template<typename Base>
+        struct is_words : std::false_type {};
+
+        template<typename T, typename Allocator>
+        struct is_words<std::vector<T, Allocator>> : std::is_unsigned<T> {};
+
+        /**
+         * Checks if a container exposes encoded words through getBase(), directly or through the getBase() of a
+         * wrapped container
+         */
+        template<typename Cont, typename = void>
+        struct has_encoding : std::false_type {};
+
+        template<typename Cont>
+        struct has_encoding<Cont, std::void_t<decltype(std::declval<const Cont &>().getBase())>>
+                : std::disjunction<is_words<std::decay_t<decltype(std::declval<const Cont &>().getBase())>>,
+                                   has_encoding<std::decay_t<decltype(std::declval<const Cont &>().getBase())>>> {};
+
+        //! Returns the encoded words of a container, unwrapping containers whose base is another container
+        template<typename Cont>
+        const auto &encoding(const Cont &cont) {
+            if constexpr (is_words<std::decay_t<decltype(cont.getBase())>>::value) {
+                return cont.getBase();
+            }
+            else {
+                return encoding(cont.getBase());
+            }
+        }
+
+        inline std::uint64_t now() {
+            return std::uint64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                    std::chrono::steady_clock::now().time_since_epoch()).count());
+        }
+    }
+
+    /**
+     * Version of the contents of a recorded set. Every construction, assignment and change draws a new version from
+     * a process-wide counter, so a version is never shared by two contents, even of sets reusing the same storage.
+     * A moved-from set gets a new version too.
+     */
+    class RecordedVersion {
+        std::uint64_t _value = next();
+
+        static std::uint64_t next() {
+            static std::atomic<std::uint64_t> counter{0u};
+            return counter.fetch_add(1u, std::memory_order_relaxed) + 1u;
+        }
+
+    public:
+        RecordedVersion() = default;
+
+        RecordedVersion(const RecordedVersion &) {}
+
+        RecordedVersion(RecordedVersion &&other) noexcept { other.renew(); }
+
+        RecordedVersion &operator=(const RecordedVersion &) {
+            renew();
+            return *this;
+        }
+
+        RecordedVersion &operator=(RecordedVersion &&other) noexcept {
+            renew();
+            other.renew();
+            return *this;
+        }
+
+        //! Draws a new version after a change of the contents
+        void renew() { _value = next(); }
+
+        //! Returns the version
+        std::uint64_t value() const { return _value; }
+    };
+
+    /**
+     * Process-wide recorder of merges and lookups. Operands are identified by a fingerprint of their encoding and
+     * every distinct operand is written once as a snapshot, so a replay can rebuild identical sets.
+     *
+     * A merge hashes its operands, which is linear like the merge itself. Hashing a set on every lookup would
+     * dominate the recording, so lookups reuse the fingerprint of the same RecordedVersion of a set. At most
+     * VERSIONS fingerprints are kept, older ones are dropped all at once and hashed again on the next lookup.
+     */
+    class Recorder {
+        //! Amount of versions whose fingerprints are kept for lookups
+        static constexpr std::size_t VERSIONS = 4096u;
+
+        std::atomic<bool> _enabled{false};
+        std::mutex _mutex;
+        std::ostream *_out = nullptr;
+        std::unordered_set<std::uint64_t> _written;
+        std::unordered_map<std::uint64_t, std::uint64_t> _versions;
+        std::atomic<std::uint32_t> _threads{0u};
+
+        template<typename T, typename Allocator>
+        void write_snapshot(std::uint64_t fingerprint, const std::vector<T, Allocator> &words) {
+            if (!_written.insert(fingerprint).second) {
+                return;
+            }
+            constexpr T mask = T(~T(0u) ^ (T(~T(0u)) >> 1u));
+            _out->put('S');
+            record::write_fixed(*_out, fingerprint);
+            _out->put(char(sizeof(T)));
+            record::write_varint(*_out, words.size());
+
+            std::int64_t previous = 0;
+            for (T word : words) {
+                auto value = std::int64_t(word & T(~mask));
+                auto delta = std::uint64_t(value - previous);
+                record::write_varint(*_out, (delta << 1u) ^ std::uint64_t(std::int64_t(delta) >> 63u));
+                previous = value;
+            }
+            for (std::size_t i = 0; i < words.size(); i += 8u) {
+                std::uint8_t bits = 0u;
+                for (std::size_t j = i; j < words.size() && j < i + 8u; j++) {
+                    bits = std::uint8_t(bits | ((words[j] & mask) ? 1u << (j - i) : 0u));
+                }
+                _out->put(char(bits));
+            }
+        }
+
+    public:
+        //! Returns the recorder of the process
+        static Recorder &instance() {
+            static Recorder recorder;
+            return recorder;
+        }
+
+        //! Checks if calls are being recorded
+        bool enabled() const { return _enabled.load(std::memory_order_relaxed); }
+
+        /*!
+         * Starts a recording, writing the header
+         * @param out Stream to write to, has to outlive the recording
+         */
+        void start(std::ostream &out) {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _out = &out;
+            _written.clear();
+            _versions.clear();
+            _out->write(record::MAGIC, sizeof(record::MAGIC));
+            _enabled.store(true, std::memory_order_relaxed);
+        }
+
+        //! Stops the recording and flushes the stream
+        void stop() {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _enabled.store(false, std::memory_order_relaxed);
+            if (_out != nullptr) {
+                _out->flush();
+                _out = nullptr;
+            }
+        }
+
+        //! Returns the sequential number of the calling thread
+        std::uint32_t thread() {
+            static thread_local std::uint32_t number = 0u;
+            if (number == 0u) {
+                number = ++_threads;
+            }
+            return number;
+        }
+
+        //! Returns the fingerprint of encoded words, hashing them on every call
+        template<typename T, typename Allocator>
+        std::uint64_t operand(const std::vector<T, Allocator> &words) {
+            std::uint64_t fingerprint = record::fingerprint(words);
+            std::lock_guard<std::mutex> lock(_mutex);
+            if (_out != nullptr) {
+                write_snapshot(fingerprint, words);
+            }
+            return fingerprint;
+        }
+
+        //! Returns the fingerprint of encoded words, reusing the fingerprint of a version seen before
+        template<typename T, typename Allocator>
+        std::uint64_t cached_operand(const std::vector<T, Allocator> &words, const RecordedVersion &version) {
+            {
+                std::lock_guard<std::mutex> lock(_mutex);
+                auto found = _versions.find(version.value());
+                if (found != _versions.end()) {
+                    return found->second;
+                }
+            }
+            std::uint64_t fingerprint = operand(words);
+            std::lock_guard<std::mutex> lock(_mutex);
+            if (_versions.size() >= VERSIONS) {
+                _versions.clear();
+            }
+            _versions[version.value()] = fingerprint;
+            return fingerprint;
+        }
+
+        //! Writes a call record
+        void call(const RecordedCall &call) {
+            std::lock_guard<std::mutex> lock(_mutex);
+            if (_out == nullptr) {
+                return;
+            }
+            _out->put('C');
+            _out->put(char(call.operation));
+            _out->put(char(call.width));
+            record::write_varint(*_out, call.thread);
+            record::write_varint(*_out, call.duration);
+            record::write_varint(*_out, call.value);
+            record::write_varint(*_out, call.operands.size());
+            for (std::uint64_t operand : call.operands) {
+                record::write_fixed(*_out, operand);
+            }
+        }
+    };
+
+    //! Starts recording calls into a stream, see Recorder::start()
+    inline void start_recording(std::ostream &out) {
+        Recorder::instance().start(out);
+    }
+
+    //! Stops recording calls
+    inline void stop_recording() {
+        Recorder::instance().stop();
+    }
+
+    //! Checks if call recording is compiled in
+    constexpr bool record_enabled() {
+#ifdef INTEGRALRANGE_RECORD
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    /**
+     * Records a merge from its construction to its destruction. Only merges of containers exposing their encoding
+     * through getBase(), directly or through a wrapped container, are recorded, since others cannot be rebuilt by a
+     * replay. Merges made by another merge, like the union of subtract_ranges(), are part of the outer call and are
+     * not recorded.
+     */
+    class RecordedMerge {
+        RecordedCall _call;
+        std::uint64_t _start = 0u;
+        bool _active = false;
+
+        static unsigned &depth() {
+            static thread_local unsigned value = 0u;
+            return value;
+        }
+
+    public:
+        /*!
+         * @param operation Merge operation
+         * @param ranges Operands of the merge
+         */
+        template<typename Cont>
+        RecordedMerge(RecordedOperation operation, const std::vector<Cont> &ranges) {
+            if constexpr (record::has_encoding<Cont>::value) {
+                auto &recorder = Recorder::instance();
+                if (!recorder.enabled() || depth() != 0u) {
+                    return;
+                }
+                _call.operation = operation;
+                typedef std::decay_t<decltype(record::encoding(ranges.front()))> Words;
+                _call.width = std::uint8_t(sizeof(typename Words::value_type));
+                _call.thread = recorder.thread();
+                _call.operands.reserve(ranges.size());
+                for (const auto &range : ranges) {
+                    _call.operands.push_back(recorder.operand(record::encoding(range)));
+                }
+                _active = true;
+                depth()++;
+                _start = record::now();
+            }
+        }
+
+        RecordedMerge(const RecordedMerge &) = delete;
+
+        RecordedMerge &operator=(const RecordedMerge &) = delete;
+
+        ~RecordedMerge() {
+            if (_active) {
+                _call.duration = record::now() - _start;
+                depth()--;
+                Recorder::instance().call(_call);
+            }
+        }
+    };
+
+    //! Records a lookup from its construction to its destruction
+    class RecordedLookup {
+        RecordedCall _call;
+        std::uint64_t _start = 0u;
+        bool _active = false;
+
+    public:
+        /*!
+         * @param words Encoded words of the searched set
+         * @param version Version of the words
+         * @param value Looked up value
+         */
+        template<typename T, typename Allocator>
+        RecordedLookup(const std::vector<T, Allocator> &words, const RecordedVersion &version, T value) {
+            auto &recorder = Recorder::instance();
+            if (!recorder.enabled()) {
+                return;
+            }
+            _call.width = std::uint8_t(sizeof(T));
+            _call.thread = recorder.thread();
+            _call.value = value;
+            _call.operands.push_back(recorder.cached_operand(words, version));
+            _active = true;
+            _start = record::now();
+        }
+
+        RecordedLookup(const RecordedLookup &) = delete;
+
+        RecordedLookup &operator=(const RecordedLookup &) = delete;
+
+        ~RecordedLookup() {
+            if (_active) {
+                _call.duration = record::now() - _start;
+                Recorder::instance().call(_call);
+            }
+        }
+    };
+
+    /*!
+     * Reads a recording
+     * @param in Stream to read from, opened in binary mode
+     * @return Snapshots and calls of the recording
+     * @throws std::runtime_error if the recording is malformed or truncated
+     */
+    inline Recording read_recording(std::istream &in) {
+        char magic[sizeof(record::MAGIC)];
+        if (!in.read(magic, sizeof(magic)) || !std::equal(magic, magic + sizeof(magic), record::MAGIC)) {
+            throw std::runtime_error("not a recording");
+        }
+
+        Recording result;
+        for (int tag = in.get(); tag != std::char_traits<char>::eof(); tag = in.get()) {
+            if (tag == 'S') {
+                std::uint64_t fingerprint = record::read_fixed(in);
+                RecordedSnapshot snapshot;
+                snapshot.width = record::read_byte(in);
+                if (snapshot.width != 1u && snapshot.width != 2u && snapshot.width != 4u && snapshot.width != 8u) {
+                    throw std::runtime_error("unsupported word width in recording");
+                }
+                std::uint64_t size = record::read_varint(in);
+                std::uint64_t value = 0u;
+                for (std::uint64_t i = 0; i < size; i++) {
+                    std::uint64_t zigzag = record::read_varint(in);
+                    value += (zigzag >> 1u) ^ (~(zigzag & 1u) + 1u);
+                    snapshot.words.push_back(value);
+                }
+                std::uint64_t mask = std::uint64_t(1u) << (8u * snapshot.width - 1u);
+                for (std::uint64_t i = 0; i < size; i += 8u) {
+                    std::uint8_t bits = record::read_byte(in);
+                    for (std::uint64_t j = i; j < size && j < i + 8u; j++) {
+                        snapshot.words[j] |= (bits >> (j - i)) & 1u ? mask : 0u;
+                    }
+                }
+                result.snapshots[fingerprint] = std::move(snapshot);
+            }
+            else if (tag == 'C') {
+                RecordedCall call;
+                std::uint8_t operation = record::read_byte(in);
+                if (operation < std::uint8_t(RecordedOperation::intersect) ||
+                    operation > std::uint8_t(RecordedOperation::subtract)) {
+                    throw std::runtime_error("unknown operation in recording");
+                }
+                call.operation = RecordedOperation(operation);
+                call.width = record::read_byte(in);
+                call.thread = std::uint32_t(record::read_varint(in));
+                call.duration = record::read_varint(in);
+                call.value = record::read_varint(in);
+                std::uint64_t operands = record::read_varint(in);
+                if (call.operation == RecordedOperation::contains && operands != 1u) {
+                    throw std::runtime_error("wrong amount of operands in recording");
+                }
+                for (std::uint64_t i = 0; i < operands; i++) {
+                    std::uint64_t fingerprint = record::read_fixed(in);
+                    auto snapshot = result.snapshots.find(fingerprint);
+                    if (snapshot == result.snapshots.end() || snapshot->second.width != call.width) {
+                        throw std::runtime_error("call refers to an unknown snapshot");
+                    }
+                    call.operands.push_back(fingerprint);
+                }
+                result.calls.push_back(std::move(call));
+            }
+            else {
+                throw std::runtime_error("unknown record in recording");
+            }
+        }
+        return result;
+    }
+
+}
+
+#endif // INTEGRALRANGE_RANGERECORDER_H
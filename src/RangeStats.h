@@ -0,0 +1,173 @@
+// Copyright 2019 Dmitry Valter
+// Copyright 2019 Sviatoslav Dmitriev
+// Distributed under the Boost Software License, Version 1.0.
+// See accompanying file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt
+
+#ifndef INTEGRALRANGE_RANGESTATS_H
+#define INTEGRALRANGE_RANGESTATS_H
+
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+#include <utility>
+
+/*!
+ * Adds a value to a counter of the calling thread. Counting is compiled in only when INTEGRALRANGE_STATS is
+ * defined, otherwise the macro expands to nothing.
+ */
+#ifdef INTEGRALRANGE_STATS
+#define INTEGRALRANGE_STAT(counter, value) (::ranges::thread_stats().counter += (value))
+#else
+#define INTEGRALRANGE_STAT(counter, value) ((void) 0)
+#endif
+
+namespace ranges {
+
+    //! Counters of hot-path operations
+    struct OperationStats {
+        //! Amount of times an input iterator was advanced by a merge
+        std::uint64_t cursorAdvances = 0u;
+
+        //! Amount of input heads inspected by merges
+        std::uint64_t headComparisons = 0u;
+
+        //! Amount of ranges written to merge results
+        std::uint64_t emittedRanges = 0u;
+
+        //! Amount of ranges coalesced with the preceding one instead of being emitted separately
+        std::uint64_t coalescedMerges = 0u;
+
+        //! Amount of allocations of storage that was empty before
+        std::uint64_t allocations = 0u;
+
+        //! Amount of storage reallocations caused by growth
+        std::uint64_t reallocations = 0u;
+
+        //! Accumulates another set of counters
+        OperationStats &operator+=(const OperationStats &other) {
+            cursorAdvances += other.cursorAdvances;
+            headComparisons += other.headComparisons;
+            emittedRanges += other.emittedRanges;
+            coalescedMerges += other.coalescedMerges;
+            allocations += other.allocations;
+            reallocations += other.reallocations;
+            return *this;
+        }
+
+        //! Difference between two snapshots of counters
+        OperationStats operator-(const OperationStats &other) const {
+            OperationStats result;
+            result.cursorAdvances = cursorAdvances - other.cursorAdvances;
+            result.headComparisons = headComparisons - other.headComparisons;
+            result.emittedRanges = emittedRanges - other.emittedRanges;
+            result.coalescedMerges = coalescedMerges - other.coalescedMerges;
+            result.allocations = allocations - other.allocations;
+            result.reallocations = reallocations - other.reallocations;
+            return result;
+        }
+    };
+
+    //! Returns counters accumulated by the calling thread since its start or the last reset
+    inline OperationStats &thread_stats() {
+        static thread_local OperationStats stats;
+        return stats;
+    }
+
+    //! Resets counters of the calling thread
+    inline void reset_thread_stats() {
+        thread_stats() = OperationStats{};
+    }
+
+    //! Checks if counters are compiled in
+    constexpr bool stats_enabled() {
+#ifdef INTEGRALRANGE_STATS
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    /**
+     * Writes counters collected during its lifetime into an optional out-parameter. Counters stay zero when
+     * INTEGRALRANGE_STATS is not defined.
+     */
+    class StatsScope {
+        OperationStats *_output;
+        OperationStats _start;
+
+    public:
+        //! Starts collection, nullptr disables it
+        explicit StatsScope(OperationStats *output) : _output(output) {
+            if (stats_enabled() && _output != nullptr) {
+                _start = thread_stats();
+            }
+        }
+
+        StatsScope(const StatsScope &) = delete;
+
+        StatsScope &operator=(const StatsScope &) = delete;
+
+        //! Writes collected counters to the out-parameter
+        ~StatsScope() {
+            if (_output != nullptr) {
+                *_output = stats_enabled() ? thread_stats() - _start : OperationStats{};
+            }
+        }
+    };
+
+    //! Checks if a container exposes its capacity
+    template<typename Cont, typename = void>
+    struct has_capacity : std::false_type {};
+
+    template<typename Cont>
+    struct has_capacity<Cont, std::void_t<decltype(std::declval<const Cont &>().capacity())>> : std::true_type {};
+
+    /**
+     * Counts allocations and reallocations of a container's storage that happen during its lifetime. The class is
+     * empty when INTEGRALRANGE_STATS is not defined or the container does not expose its capacity.
+     * @tparam Cont Container type
+     */
+    template<typename Cont, bool = has_capacity<Cont>::value>
+    class GrowthCounter {
+    public:
+        explicit GrowthCounter(const Cont &) {}
+
+        GrowthCounter(const GrowthCounter &) = delete;
+
+        GrowthCounter &operator=(const GrowthCounter &) = delete;
+    };
+
+    template<typename Cont>
+    class GrowthCounter<Cont, true> {
+#ifdef INTEGRALRANGE_STATS
+        const Cont &_container;
+        std::size_t _capacity;
+
+    public:
+        //! Remembers the capacity of a container
+        explicit GrowthCounter(const Cont &container) : _container(container), _capacity(container.capacity()) {}
+
+        //! Counts a change of the capacity
+        ~GrowthCounter() {
+            if (_container.capacity() != _capacity) {
+                if (_capacity == 0u) {
+                    INTEGRALRANGE_STAT(allocations, 1u);
+                }
+                else {
+                    INTEGRALRANGE_STAT(reallocations, 1u);
+                }
+            }
+        }
+#else
+    public:
+        explicit GrowthCounter(const Cont &) {}
+#endif
+
+        GrowthCounter(const GrowthCounter &) = delete;
+
+        GrowthCounter &operator=(const GrowthCounter &) = delete;
+    };
+
+}
+
+#endif // INTEGRALRANGE_RANGESTATS_H
@@ -0,0 +1,251 @@
+// Copyright 2019 Dmitry Valter
+// Copyright 2019 Sviatoslav Dmitriev
+// Distributed under the Boost Software License, Version 1.0.
+// See accompanying file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt
+
+#ifndef INTEGRALRANGE_RANGETRACE_H
+#define INTEGRALRANGE_RANGETRACE_H
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+namespace ranges {
+
+    //! Completed span
+    struct TraceEvent {
+        //! Name of the span, has to outlive the trace, see trace_intern()
+        const char *name = nullptr;
+
+        //! Name of the argument or nullptr if the span has none
+        const char *argName = nullptr;
+
+        //! Value of the argument
+        std::uint64_t arg = 0u;
+
+        //! Start of the span in nanoseconds since the trace clock epoch
+        std::uint64_t start = 0u;
+
+        //! Duration of the span in nanoseconds
+        std::uint64_t duration = 0u;
+    };
+
+    /**
+     * Ring buffer of events recorded by a single thread. Once the buffer is full the oldest events are
+     * overwritten, so a trace always holds the latest events of every thread.
+     */
+    class TraceBuffer {
+        std::vector<TraceEvent> _events;
+        std::size_t _next = 0u;
+        std::uint64_t _recorded = 0u;
+        std::uint32_t _thread;
+
+    public:
+        //! Default amount of events kept per thread
+        static constexpr std::size_t DEFAULT_CAPACITY = 1u << 16u;
+
+        TraceBuffer(std::uint32_t thread, std::size_t capacity) : _events(capacity), _thread(thread) {}
+
+        //! Appends an event, overwriting the oldest one if the buffer is full
+        void push(const TraceEvent &event) {
+            _events[_next] = event;
+            _next = _next + 1u == _events.size() ? 0u : _next + 1u;
+            _recorded++;
+        }
+
+        //! Sequential number of the thread that owns the buffer
+        std::uint32_t thread() const { return _thread; }
+
+        //! Amount of events recorded since the last reset, including overwritten ones
+        std::uint64_t recorded() const { return _recorded; }
+
+        //! Amount of events that were overwritten
+        std::uint64_t dropped() const {
+            return _recorded > _events.size() ? _recorded - _events.size() : 0u;
+        }
+
+        //! Calls a function for every kept event, oldest first
+        template<typename Func>
+        void visit(Func &&func) const {
+            std::size_t kept = std::size_t(std::min<std::uint64_t>(_recorded, _events.size()));
+            std::size_t first = kept < _events.size() ? 0u : _next;
+            for (std::size_t i = 0; i < kept; i++) {
+                func(_events[(first + i) % _events.size()]);
+            }
+        }
+
+        //! Removes all events and changes the capacity
+        void reset(std::size_t capacity) {
+            _events.assign(capacity, TraceEvent{});
+            _next = 0u;
+            _recorded = 0u;
+        }
+    };
+
+    //! Process-wide tracing state
+    class TraceSession {
+        std::atomic<bool> _enabled{false};
+        std::mutex _mutex;
+        std::vector<std::shared_ptr<TraceBuffer>> _buffers;
+        std::unordered_set<std::string> _names;
+        std::size_t _capacity = TraceBuffer::DEFAULT_CAPACITY;
+
+        // Trace-event timestamps are microseconds, nanoseconds are kept as decimals
+        static void write_microseconds(std::ostream &out, std::uint64_t nanoseconds) {
+            out << nanoseconds / 1000u << '.' << char('0' + nanoseconds / 100u % 10u)
+                << char('0' + nanoseconds / 10u % 10u) << char('0' + nanoseconds % 10u);
+        }
+
+    public:
+        //! Returns the session of the process
+        static TraceSession &instance() {
+            static TraceSession session;
+            return session;
+        }
+
+        //! Checks if spans are being recorded
+        bool enabled() const { return _enabled.load(std::memory_order_relaxed); }
+
+        //! Starts recording, discarding events of a previous trace. Threads must not record spans during the call
+        void start(std::size_t capacity = TraceBuffer::DEFAULT_CAPACITY) {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _capacity = std::max<std::size_t>(capacity, 1u);
+            for (auto &buffer : _buffers) {
+                buffer->reset(_capacity);
+            }
+            _enabled.store(true, std::memory_order_relaxed);
+        }
+
+        //! Stops recording, recorded events are kept until the next start
+        void stop() { _enabled.store(false, std::memory_order_relaxed); }
+
+        //! Returns the buffer of the calling thread, registering it on first use
+        TraceBuffer &thread_buffer() {
+            static thread_local std::shared_ptr<TraceBuffer> buffer;
+            if (!buffer) {
+                std::lock_guard<std::mutex> lock(_mutex);
+                buffer = std::make_shared<TraceBuffer>(std::uint32_t(_buffers.size() + 1u), _capacity);
+                _buffers.push_back(buffer);
+            }
+            return *buffer;
+        }
+
+        //! Returns a copy of a name that lives as long as the process, for span names built at run time
+        const char *intern(const std::string &name) {
+            std::lock_guard<std::mutex> lock(_mutex);
+            return _names.insert(name).first->c_str();
+        }
+
+        /*!
+         * Writes recorded events in the Chrome trace-event JSON format, readable by Perfetto and chrome://tracing.
+         * Threads that record spans must not run concurrently with the call.
+         * @param out Stream to write to
+         */
+        void write(std::ostream &out) {
+            std::lock_guard<std::mutex> lock(_mutex);
+            std::uint64_t dropped = 0u;
+            bool first = true;
+
+            out << "{\"displayTimeUnit\": \"ns\", \"traceEvents\": [";
+            for (const auto &buffer : _buffers) {
+                dropped += buffer->dropped();
+                out << (first ? "\n" : ",\n") << "  {\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": "
+                    << buffer->thread() << ", \"args\": {\"name\": \"thread " << buffer->thread() << "\"}}";
+                first = false;
+
+                buffer->visit([&](const TraceEvent &event) {
+                    out << ",\n  {\"name\": \"" << event.name << "\", \"ph\": \"X\", \"pid\": 1, \"tid\": "
+                        << buffer->thread() << ", \"ts\": ";
+                    write_microseconds(out, event.start);
+                    out << ", \"dur\": ";
+                    write_microseconds(out, event.duration);
+                    if (event.argName != nullptr) {
+                        out << ", \"args\": {\"" << event.argName << "\": " << event.arg << "}";
+                    }
+                    out << "}";
+                });
+            }
+            out << "\n], \"otherData\": {\"dropped_events\": " << dropped << "}}\n";
+        }
+    };
+
+    //! Starts recording spans, see TraceSession::start()
+    inline void start_tracing(std::size_t capacity = TraceBuffer::DEFAULT_CAPACITY) {
+        TraceSession::instance().start(capacity);
+    }
+
+    //! Stops recording spans
+    inline void stop_tracing() {
+        TraceSession::instance().stop();
+    }
+
+    //! Writes recorded spans as Chrome trace-event JSON, see TraceSession::write()
+    inline void write_chrome_trace(std::ostream &out) {
+        TraceSession::instance().write(out);
+    }
+
+    //! Returns a copy of a span name that lives as long as the process
+    inline const char *trace_intern(const std::string &name) {
+        return TraceSession::instance().intern(name);
+    }
+
+    //! Checks if spans are compiled in
+    constexpr bool trace_enabled() {
+#ifdef INTEGRALRANGE_TRACE
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    /**
+     * Records a span from its construction to its destruction into the buffer of the calling thread. Does nothing
+     * but a relaxed load if tracing is not started.
+     */
+    class TraceSpan {
+        const char *_name;
+        const char *_argName;
+        std::uint64_t _arg;
+        std::uint64_t _start = 0u;
+        bool _active;
+
+        static std::uint64_t now() {
+            return std::uint64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                    std::chrono::steady_clock::now().time_since_epoch()).count());
+        }
+
+    public:
+        /*!
+         * @param name Name of the span, has to outlive the trace
+         * @param argName Name of an integer argument or nullptr
+         * @param arg Value of the argument
+         */
+        explicit TraceSpan(const char *name, const char *argName = nullptr, std::uint64_t arg = 0u)
+                : _name(name), _argName(argName), _arg(arg), _active(TraceSession::instance().enabled()) {
+            if (_active) {
+                _start = now();
+            }
+        }
+
+        TraceSpan(const TraceSpan &) = delete;
+
+        TraceSpan &operator=(const TraceSpan &) = delete;
+
+        ~TraceSpan() {
+            if (_active) {
+                std::uint64_t stop = now();
+                TraceSession::instance().thread_buffer().push({_name, _argName, _arg, _start, stop - _start});
+            }
+        }
+    };
+
+}
+
+#endif // INTEGRALRANGE_RANGETRACE_H
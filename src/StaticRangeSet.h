@@ -0,0 +1,519 @@
+// Copyright 2019 Dmitry Valter
+// Copyright 2019 Sviatoslav Dmitriev
+// Distributed under the Boost Software License, Version 1.0.
+// See accompanying file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt
+
+#ifndef INTEGRALRANGE_STATICRANGESET_H
+#define INTEGRALRANGE_STATICRANGESET_H
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include <iterator>
+#include <limits>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+namespace ranges {
+
+    /**
+     * Set of unsigned integral values in the encoding of IntegralRangeVector, stored inline in an array of N words.
+     * All operations are constexpr, so sets and their merges can be computed at compile time and placed in
+     * read-only data without any startup work:
+     *
+     *     constexpr StaticRangeSet<std::uint32_t, 4> wellKnown{{0u, 1024u}, {8080u, 8081u}};
+     *     constexpr StaticRangeSet<std::uint32_t, 2> dynamic{{49152u, 65536u}};
+     *     constexpr auto reserved = unite(wellKnown, dynamic);
+     *
+     * A set never allocates and is trivially copyable, so it can be passed by value, copied with memcpy and kept
+     * in lock-free structures. It has the interface the merges of RangeMerger.h rely on, so vectors of sets can
+     * be merged by intersect_ranges(), unite_ranges() and subtract_ranges() as well.
+     *
+     * Capacity is always checked: push_back() throws std::length_error when the words of a range do not fit,
+     * which also fails compilation in a constant expression, and try_push_back() reports it instead. Either way
+     * the set is left unchanged.
+     */
+    template<typename T, std::size_t N>
+    class StaticRangeSet {
+    public:
+        static_assert(std::is_unsigned_v<T>);
+        static_assert(N > 0u);
+
+        //! Mask that is applied to the beginning and ending of the range
+        static constexpr T mask = std::numeric_limits<T>::max() ^ (std::numeric_limits<T>::max() >> 1);
+
+        //! Type of value returned when iterating over the container
+        typedef std::pair<T, T> value_type;
+
+        //! Type of value used to calculate range size
+        typedef std::size_t size_type;
+
+        //! Type that represents difference between two positions in the container
+        typedef std::ptrdiff_t difference_type;
+
+        //! Size of the blocks contains() decodes from their first range boundary
+        static constexpr size_type BLOCK = 64u;
+
+    private:
+        T _words[N]{};
+        size_type _size = 0u;
+        //! Bit b is set if the word at b * BLOCK ends a range
+        std::uint64_t _blockEnds[(N + BLOCK * 64u - 1u) / (BLOCK * 64u)]{};
+
+        //! Marks the last word if it ends a range and starts a block, called after words are appended
+        constexpr void mark_back() {
+            size_type last = _size - 1u;
+            if (_size != 0u && last % BLOCK == 0u && (_words[last] & mask)) {
+                _blockEnds[last / BLOCK / 64u] |= std::uint64_t(1u) << (last / BLOCK % 64u);
+            }
+        }
+
+        constexpr void append(T word) {
+            assert(_size < N);
+            _words[_size++] = word;
+        }
+
+        //! Returns the amount of words appending a range adds, extending the last range needs fewer of them
+        constexpr size_type required(value_type val) const {
+            if (_size != 0u && val.second - val.first > 0) {
+                T back = _words[_size - 1u];
+                if ((back & mask) > 0 && (back & ~mask) == val.first) {
+                    return 0u;
+                }
+                else if ((back & mask) == 0 && (back & ~mask) == val.first - 1) {
+                    return 1u;
+                }
+            }
+            switch (val.second - val.first) {
+                case 0:
+                    return 0u;
+                case 1:
+                    return 1u;
+                default:
+                    return 2u;
+            }
+        }
+
+        constexpr void append_range(value_type val) {
+            if (_size != 0u && val.second - val.first > 0) {
+                T &back = _words[_size - 1u];
+                if ((back & mask) > 0 && (back & ~mask) == val.first) {
+                    back = T(val.second | mask);
+                    return;
+                }
+                else if ((back & mask) == 0 && (back & ~mask) == val.first - 1) {
+                    back = T(back | mask);
+                    append(T(val.second | mask));
+                    return;
+                }
+            }
+            switch (val.second - val.first) {
+                case 0:
+                    break;
+                case 1:
+                    append(val.first);
+                    break;
+                default:
+                    append(T(val.first | mask));
+                    append(T(val.second | mask));
+            }
+        }
+
+    public:
+
+        //! Class used to iterate over range container
+        class const_iterator {
+        public:
+
+            //! Default constructor - creates an end iterator
+            constexpr const_iterator() = default;
+
+            //! Type of values stored in the iterated container
+            typedef StaticRangeSet::value_type value_type;
+
+            //! Reference to the stored value
+            typedef const value_type &reference;
+
+            //! Constant reference to the stored value
+            typedef const value_type &const_reference;
+
+            //! Pointer to the stored value
+            typedef const value_type *pointer;
+
+            //! Constant pointer to the stored value
+            typedef const value_type *const_pointer;
+
+            //! Difference between two iterators
+            typedef std::ptrdiff_t difference_type;
+
+            //! Iterator category
+            typedef std::input_iterator_tag iterator_category;
+
+        private:
+            const T *_pos = nullptr;
+            const T *_end = nullptr;
+
+            value_type _current_value = {T(0u), T(0u)};
+
+            // Members are assigned one by one, assignment of a pair is not constexpr before C++20
+            constexpr void calculate_value() {
+                if (_pos >= _end) {
+                    _current_value.first = T(0u);
+                    _current_value.second = T(0u);
+                }
+                else if (mask & *_pos) {
+                    _current_value.first = T(*_pos & ~mask);
+                    _current_value.second = T(*(_pos + 1) & ~mask);
+                }
+                else {
+                    _current_value.first = *_pos;
+                    _current_value.second = T(*_pos + 1u);
+                }
+            }
+
+            constexpr const_iterator(const T *pos, const T *end) : _pos(pos), _end(end) {
+                calculate_value();
+            }
+
+            friend class StaticRangeSet<T, N>;
+
+        public:
+
+            //! Equals operator between two iterators
+            constexpr bool operator==(const const_iterator &other) const { return _pos == other._pos; }
+
+            //! Not equals operator between two iterators
+            constexpr bool operator!=(const const_iterator &other) const { return _pos != other._pos; }
+
+            //! Lesser than operator between two iterators
+            constexpr bool operator<(const const_iterator &other) const { return _pos < other._pos; }
+
+            //! Greater than operator between two iterators
+            constexpr bool operator>(const const_iterator &other) const { return _pos > other._pos; }
+
+            //! Lesser or equal operator between two iterators
+            constexpr bool operator<=(const const_iterator &other) const { return _pos <= other._pos; }
+
+            //! Greater or equal operator between two iterators
+            constexpr bool operator>=(const const_iterator &other) const { return _pos >= other._pos; }
+
+            //! Dereference operator
+            constexpr const_reference operator*() const {
+                assert(_pos < _end);
+
+                return _current_value;
+            }
+
+            //! Member access operator
+            constexpr const_pointer operator->() const {
+                assert(_pos < _end);
+
+                return &_current_value;
+            }
+
+            //! Postfix increment operator
+            constexpr const_iterator operator++(int) {
+                const_iterator result = *this;
+                ++*this;
+                return result;
+            }
+
+            //! Prefix increment operator
+            constexpr const_iterator &operator++() {
+                if (_pos < _end && mask & *_pos) {
+                    ++_pos;
+                }
+                ++_pos;
+
+                calculate_value();
+                return *this;
+            }
+        };
+
+        //! Default constructor - creates an empty container
+        constexpr StaticRangeSet() = default;
+
+        /*!
+         * Initializes container with ascending value ranges
+         * @param list Ranges to append
+         */
+        constexpr StaticRangeSet(std::initializer_list<value_type> list) {
+            for (const auto &range : list) {
+                push_back(range);
+            }
+        }
+
+        //! Amount of words the container can hold
+        static constexpr size_type capacity() { return N; }
+
+        /*!
+         * Appends a value range to the end of the container
+         * @param val A value range to append
+         * @throws std::length_error if the range does not fit, the container is left unchanged
+         */
+        constexpr void push_back(value_type val) {
+            if (!try_push_back(val)) {
+                throw std::length_error("StaticRangeSet capacity exceeded");
+            }
+        }
+
+        /*!
+         * Appends a single value to the end of the container
+         * @param val A value to append
+         * @throws std::length_error if the value does not fit, the container is left unchanged
+         */
+        constexpr void push_back(T val) {
+            push_back(value_type(val, T(val + 1u)));
+        }
+
+        /*!
+         * Appends a value range to the end of the container if it fits
+         * @param val A value range to append
+         * @return False if the range does not fit, the container is left unchanged then
+         */
+        constexpr bool try_push_back(value_type val) {
+            assert((val.first & mask) == 0);
+            assert((val.second & mask) == 0);
+
+            if (required(val) > N - _size) {
+                return false;
+            }
+            append_range(val);
+            mark_back();
+            return true;
+        }
+
+        /*!
+         * Appends a single value to the end of the container if it fits
+         * @param val A value to append
+         * @return False if the value does not fit, the container is left unchanged then
+         */
+        constexpr bool try_push_back(T val) {
+            return try_push_back(value_type(val, T(val + 1u)));
+        }
+
+        /*!
+         * Checks if a value is stored in the container, see IntegralRangeVector::contains()
+         * @param val Value to look up
+         * @return True if the value is stored
+         */
+        constexpr bool contains(T val) const {
+            assert((val & mask) == 0);
+
+            // Position after the last word whose value is not greater than the searched one
+            size_type low = 0u, high = _size;
+            while (low < high) {
+                size_type middle = low + (high - low) / 2u;
+                if (T(_words[middle] & ~mask) <= val) {
+                    low = middle + 1u;
+                }
+                else {
+                    high = middle;
+                }
+            }
+            if (low == 0u) {
+                return false;
+            }
+            size_type position = low - 1u;
+
+            if ((_words[position] & mask) == 0) {
+                return _words[position] == val;
+            }
+
+            // Decoding the block from its first range boundary stops at the position only if it begins a range
+            size_type block = position / BLOCK;
+            size_type word = block * BLOCK + ((_blockEnds[block / 64u] >> (block % 64u)) & 1u);
+            while (word < position) {
+                word += (_words[word] & mask) ? 2u : 1u;
+            }
+            return word == position && position + 1u < _size && val < T(_words[position + 1u] & ~mask);
+        }
+
+        //! Equals operator for two sets of the same capacity
+        constexpr bool operator==(const StaticRangeSet &other) const {
+            if (_size != other._size) {
+                return false;
+            }
+            for (size_type i = 0; i < _size; i++) {
+                if (_words[i] != other._words[i]) {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        //! Not equals operator for two sets of the same capacity
+        constexpr bool operator!=(const StaticRangeSet &other) const { return !(*this == other); }
+
+        //! Returns a constant iterator pointing to the beginning of the container
+        constexpr const_iterator cbegin() const { return {_words, _words + _size}; }
+
+        //! Returns a constant iterator pointing to the end of the container
+        constexpr const_iterator cend() const { return {_words + _size, _words + _size}; }
+
+        //! Returns an iterator pointing to the beginning of the container
+        constexpr const_iterator begin() const { return cbegin(); }
+
+        //! Returns an iterator pointing to the end of the container
+        constexpr const_iterator end() const { return cend(); }
+
+        //! Returns the stored words
+        constexpr const T *data() const { return _words; }
+
+        //! Returns the amount of stored words
+        constexpr size_type size() const { return _size; }
+
+        //! Returns the amount of values stored in the container
+        constexpr size_type length() const {
+            size_type result = 0u;
+            for (auto it = begin(); it != end(); ++it) {
+                result += it->second - it->first;
+            }
+            return result;
+        }
+
+        //! Checks if the container is empty
+        constexpr bool empty() const { return _size == 0u; }
+
+        //! Checks if the container holds as many words as it can
+        constexpr bool full() const { return _size == N; }
+    };
+
+    static_assert(std::is_trivially_copyable_v<StaticRangeSet<unsigned, 1u>>);
+
+    /*!
+     * Copies a set into a set of another capacity, e.g. to fit a table computed at compile time at namespace
+     * scope:
+     *
+     *     constexpr auto table = with_capacity<reserved.size()>(reserved);
+     *
+     * @tparam M Capacity of the result, has to hold the stored words
+     * @param set Set to copy
+     * @return Copy of the set
+     */
+    template<std::size_t M, typename T, std::size_t N>
+    constexpr StaticRangeSet<T, M> with_capacity(const StaticRangeSet<T, N> &set) {
+        StaticRangeSet<T, M> result;
+        for (const auto &range : set) {
+            result.push_back(range);
+        }
+        return result;
+    }
+
+    /*!
+     * Calculates a union of two sets. Every range of the result ends where a range of an operand ends and has
+     * no more words than it, so the sum of capacities always suffices.
+     */
+    template<typename T, std::size_t N1, std::size_t N2>
+    constexpr StaticRangeSet<T, N1 + N2> unite(const StaticRangeSet<T, N1> &a, const StaticRangeSet<T, N2> &b) {
+        StaticRangeSet<T, N1 + N2> result;
+        auto first = a.begin();
+        auto second = b.begin();
+        bool pending = false;
+        T pendingBegin = 0u, pendingEnd = 0u;
+
+        while (first != a.end() || second != b.end()) {
+            T begin = 0u, end = 0u;
+            if (second == b.end() || (first != a.end() && first->first <= second->first)) {
+                begin = first->first;
+                end = first->second;
+                ++first;
+            }
+            else {
+                begin = second->first;
+                end = second->second;
+                ++second;
+            }
+
+            if (pending && begin <= pendingEnd) {
+                pendingEnd = end > pendingEnd ? end : pendingEnd;
+                continue;
+            }
+            if (pending) {
+                result.push_back({pendingBegin, pendingEnd});
+            }
+            pending = true;
+            pendingBegin = begin;
+            pendingEnd = end;
+        }
+        if (pending) {
+            result.push_back({pendingBegin, pendingEnd});
+        }
+        return result;
+    }
+
+    /*!
+     * Calculates an intersection of two sets. Every range of the result ends where a range of an operand ends and
+     * lies inside it, so the sum of capacities always suffices.
+     */
+    template<typename T, std::size_t N1, std::size_t N2>
+    constexpr StaticRangeSet<T, N1 + N2> intersect(const StaticRangeSet<T, N1> &a,
+                                                   const StaticRangeSet<T, N2> &b) {
+        StaticRangeSet<T, N1 + N2> result;
+        auto first = a.begin();
+        auto second = b.begin();
+
+        while (first != a.end() && second != b.end()) {
+            T begin = first->first > second->first ? first->first : second->first;
+            T end = first->second < second->second ? first->second : second->second;
+            if (begin < end) {
+                result.push_back({begin, end});
+            }
+            if (first->second < second->second) {
+                ++first;
+            }
+            else {
+                ++second;
+            }
+        }
+        return result;
+    }
+
+    /*!
+     * Calculates values of the first set that are not in the second one. A subtracted range splits a range in two
+     * at most and a subtracted singleton can leave two words, so the result needs up to N1 + 2 * N2 words.
+     */
+    template<typename T, std::size_t N1, std::size_t N2>
+    constexpr StaticRangeSet<T, N1 + 2u * N2> subtract(const StaticRangeSet<T, N1> &a,
+                                                       const StaticRangeSet<T, N2> &b) {
+        StaticRangeSet<T, N1 + 2u * N2> result;
+        auto cut = b.begin();
+
+        for (auto range = a.begin(); range != a.end(); ++range) {
+            T begin = range->first;
+            T end = range->second;
+
+            while (cut != b.end() && cut->second <= begin) {
+                ++cut;
+            }
+            for (auto it = cut; begin < end && it != b.end() && it->first < end; ++it) {
+                if (it->first > begin) {
+                    result.push_back({begin, it->first});
+                }
+                begin = it->second > begin ? it->second : begin;
+            }
+            if (begin < end) {
+                result.push_back({begin, end});
+            }
+        }
+        return result;
+    }
+
+    //! Calculates a union of any amount of sets, the capacity of the result is the sum of capacities
+    template<typename T, std::size_t N1, std::size_t N2, typename... Sets>
+    constexpr auto unite(const StaticRangeSet<T, N1> &a, const StaticRangeSet<T, N2> &b, const Sets &... rest) {
+        return unite(unite(a, b), rest...);
+    }
+
+    //! Calculates an intersection of any amount of sets, the capacity of the result is the sum of capacities
+    template<typename T, std::size_t N1, std::size_t N2, typename... Sets>
+    constexpr auto intersect(const StaticRangeSet<T, N1> &a, const StaticRangeSet<T, N2> &b,
+                             const Sets &... rest) {
+        return intersect(intersect(a, b), rest...);
+    }
+
+}
+
+#endif // INTEGRALRANGE_STATICRANGESET_H